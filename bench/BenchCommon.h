@@ -0,0 +1,101 @@
+#ifndef __BENCHCOMMON_H__
+#define __BENCHCOMMON_H__
+
+// Helpers shared by the benchmarks: GL context setup, synthetic shaders and geometry
+
+#include "glad/glad.h"
+#include "GLFW/glfw3.h"
+
+#include "glm/glm.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+// Creates a hidden 3.3 core window and loads GL through glad, returns NULL on failure
+inline GLFWwindow *createHiddenContext(const char *title, int width = 64, int height = 64)
+{
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow *window = glfwCreateWindow(width, height, title, NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "Failed to init window" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "Failed to init GLAD" << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+	return window;
+}
+
+inline double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Vertex shader in the style of lessonshader.vs (MVP) whose work depends on VARIANT,
+// so every variant really is a different program for the compiler
+inline std::string syntheticVertexShader()
+{
+	return "#version 330 core\n"
+		   "layout (location = 0) in vec3 aPos;\n"
+		   "layout (location = 1) in vec2 aTexCoord;\n"
+		   "out vec2 TexCoord;\n"
+		   "uniform mat4 model;\n"
+		   "uniform mat4 view;\n"
+		   "uniform mat4 projection;\n"
+		   "void main()\n"
+		   "{\n"
+		   "    vec3 p = aPos;\n"
+		   "    for (int i = 0; i < VARIANT % 7 + 1; i++)\n"
+		   "        p = p * 0.99 + sin(p.yzx * float(VARIANT) * 0.01);\n"
+		   "    gl_Position = projection * view * model * vec4(p, 1.0);\n"
+		   "    TexCoord = aTexCoord;\n"
+		   "}\n";
+}
+
+inline std::string syntheticFragmentShader()
+{
+	return "#version 330 core\n"
+		   "out vec4 FragColor;\n"
+		   "in vec2 TexCoord;\n"
+		   "uniform sampler2D texture1;\n"
+		   "uniform sampler2D texture2;\n"
+		   "void main()\n"
+		   "{\n"
+		   "    vec4 c = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.2);\n"
+		   "    c.rgb = pow(c.rgb, vec3(1.0 + float(VARIANT) * 0.001));\n"
+		   "    FragColor = c;\n"
+		   "}\n";
+}
+
+inline std::string syntheticDefines(int variant)
+{
+	return "#define VARIANT " + std::to_string(variant) + "\n";
+}
+
+// Unit cube, -0.5..0.5, as 12 triangles: calls emit(position, uv) for each of the 36 corners
+template <typename F>
+inline void emitUnitCube(F &&emit)
+{
+	static const int faces[6][4] = {{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}};
+	static const glm::vec2 uv[4] = {glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f)};
+	for (const int *f : faces)
+		for (int corner : {0, 1, 2, 0, 2, 3})
+		{
+			int c = f[corner];
+			emit(glm::vec3(c & 4 ? 0.5f : -0.5f, c & 2 ? 0.5f : -0.5f, c & 1 ? 0.5f : -0.5f), uv[corner]);
+		}
+}
+
+#endif
@@ -0,0 +1,257 @@
+// EntityWorld against a plain array of structs holding the same data: N entities,
+// half of them moving, each frame a move, spin, bounds and cull pass. The ECS runs
+// the passes serially and through JobSystem, and every frame's visible count and
+// bounds checksum must match the array of structs. Also times random access by
+// handle and structural changes (destroy/create and add/remove a component).
+//
+// usage: EntityWorldBench [entities] [frames] [threads]
+
+#include "EntityWorld.h"
+#include "JobSystem.h"
+#include "SceneComponents.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+struct Velocity
+{
+	glm::vec3 value;
+};
+
+// What a typical game object looks like without an ECS
+struct GameObject
+{
+	Transform transform;
+	MeshRef mesh;
+	MaterialRef material;
+	Bounds bounds;
+	glm::vec3 velocity;
+	bool moving;
+};
+
+static void frustumPlanes(const glm::mat4 &m, glm::vec4 planes[6])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		planes[i * 2] = glm::vec4(m[0][3] + m[0][i], m[1][3] + m[1][i], m[2][3] + m[2][i], m[3][3] + m[3][i]);
+		planes[i * 2 + 1] = glm::vec4(m[0][3] - m[0][i], m[1][3] - m[1][i], m[2][3] - m[2][i], m[3][3] - m[3][i]);
+	}
+}
+
+static bool inside(const glm::vec4 planes[6], const Bounds &b)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const glm::vec4 &n = planes[p];
+		if (n.x * (n.x > 0.0f ? b.max.x : b.min.x) + n.y * (n.y > 0.0f ? b.max.y : b.min.y) + n.z * (n.z > 0.0f ? b.max.z : b.min.z) + n.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+static void move(Transform &t, const Velocity &v, float dt)
+{
+	t.position += v.value * dt;
+}
+
+static void spin(Transform &t, float dt)
+{
+	t.angle += dt;
+}
+
+static void updateBounds(const Transform &t, const MeshRef &m, Bounds &b)
+{
+	glm::vec3 extent(m.radius * t.scale);
+	b.min = t.position - extent;
+	b.max = t.position + extent;
+}
+
+struct Totals
+{
+	double moveMs = 0.0, spinMs = 0.0, boundsMs = 0.0, cullMs = 0.0;
+	void print(const char *name, int frames) const
+	{
+		std::cout << name << (moveMs + spinMs + boundsMs + cullMs) / frames << " ms/frame (move " << moveMs / frames << ", spin " << spinMs / frames
+				  << ", bounds " << boundsMs / frames << ", cull " << cullMs / frames << ")" << std::endl;
+	}
+};
+
+int main(int argc, char **argv)
+{
+	const size_t count = argc > 1 ? (size_t)atoll(argv[1]) : 1000000;
+	const int frames = argc > 2 ? atoi(argv[2]) : 20;
+	const unsigned threads = argc > 3 ? (unsigned)atoi(argv[3]) : 0;
+	const float dt = 1.0f / 60.0f;
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> pos(-500.0f, 500.0f), unit(-1.0f, 1.0f), size(0.5f, 2.0f);
+	std::vector<GameObject> objects(count);
+	EntityWorld world;
+	std::vector<Entity> entities(count);
+	auto start = Clock::now();
+	for (size_t i = 0; i < count; i++)
+	{
+		GameObject &o = objects[i];
+		o.transform.position = glm::vec3(pos(rng), pos(rng), pos(rng));
+		o.transform.scale = size(rng);
+		o.mesh = {1, 0, 36, 0.87f};
+		o.material = {(uint32_t)(i % 4), (uint32_t)(i % 16)};
+		o.velocity = glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f;
+		o.moving = i % 2 == 0;
+		if (o.moving)
+			entities[i] = world.create(o.transform, o.mesh, o.material, Bounds(), Velocity{o.velocity});
+		else
+			entities[i] = world.create(o.transform, o.mesh, o.material, Bounds());
+	}
+	double createMs = msSince(start);
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+	JobSystem jobs(threads);
+	Totals aos, serial, parallel;
+	size_t mismatches = 0, visibleTotal = 0;
+	std::vector<size_t> aosVisible(4), ecsVisible(4);
+
+	for (int f = 0; f < frames; f++)
+	{
+		glm::vec3 eye(0.0f, 0.0f, 0.0f);
+		glm::mat4 view = glm::lookAt(eye, glm::vec3(std::cos(f * 0.3f), 0.0f, std::sin(f * 0.3f)), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::vec4 planes[6];
+		frustumPlanes(projection * view, planes);
+
+		// array of structs, every pass walks the whole object
+		start = Clock::now();
+		for (GameObject &o : objects)
+			if (o.moving)
+				move(o.transform, Velocity{o.velocity}, dt);
+		aos.moveMs += msSince(start);
+		start = Clock::now();
+		for (GameObject &o : objects)
+			spin(o.transform, dt);
+		aos.spinMs += msSince(start);
+		start = Clock::now();
+		for (GameObject &o : objects)
+			updateBounds(o.transform, o.mesh, o.bounds);
+		aos.boundsMs += msSince(start);
+		start = Clock::now();
+		std::fill(aosVisible.begin(), aosVisible.end(), 0);
+		for (const GameObject &o : objects)
+			if (inside(planes, o.bounds))
+				aosVisible[o.material.program]++;
+		aos.cullMs += msSince(start);
+
+		// the ECS runs each pass twice, serial and parallel, on alternating frames so
+		// both see the same data as the array of structs
+		bool useJobs = f & 1;
+		Totals &totals = useJobs ? parallel : serial;
+		start = Clock::now();
+		if (useJobs)
+			world.parallelEach<Transform, const Velocity>(jobs, [&](Transform &t, const Velocity &v)
+														  { move(t, v, dt); });
+		else
+			world.each<Transform, const Velocity>([&](Transform &t, const Velocity &v)
+												  { move(t, v, dt); });
+		totals.moveMs += msSince(start);
+		start = Clock::now();
+		if (useJobs)
+			world.parallelEach<Transform>(jobs, [&](Transform &t)
+										  { spin(t, dt); });
+		else
+			world.each<Transform>([&](Transform &t)
+								  { spin(t, dt); });
+		totals.spinMs += msSince(start);
+		start = Clock::now();
+		if (useJobs)
+			world.parallelEach<const Transform, const MeshRef, Bounds>(jobs, updateBounds);
+		else
+			world.each<const Transform, const MeshRef, Bounds>(updateBounds);
+		totals.boundsMs += msSince(start);
+		start = Clock::now();
+		std::atomic<size_t> visible[4] = {};
+		auto cull = [&](size_t n, const Bounds *bounds, const MaterialRef *materials)
+		{
+			size_t local[4] = {};
+			for (size_t i = 0; i < n; i++)
+				if (inside(planes, bounds[i]))
+					local[materials[i].program]++;
+			for (int p = 0; p < 4; p++)
+				visible[p].fetch_add(local[p], std::memory_order_relaxed);
+		};
+		if (useJobs)
+			world.parallelForEachChunk<const Bounds, const MaterialRef>(jobs, cull);
+		else
+			world.forEachChunk<const Bounds, const MaterialRef>(cull);
+		totals.cullMs += msSince(start);
+
+		for (int p = 0; p < 4; p++)
+		{
+			mismatches += visible[p].load() != aosVisible[p];
+			visibleTotal += aosVisible[p];
+		}
+	}
+
+	// the same data must have come out of both
+	for (size_t i = 0; i < count; i += 97)
+	{
+		const Bounds *b = world.get<Bounds>(entities[i]);
+		mismatches += b == nullptr || b->min != objects[i].bounds.min || b->max != objects[i].bounds.max;
+	}
+
+	// random access through handles
+	std::vector<size_t> order(count);
+	for (size_t i = 0; i < count; i++)
+		order[i] = i;
+	std::shuffle(order.begin(), order.end(), rng);
+	start = Clock::now();
+	float sum = 0.0f;
+	for (size_t i : order)
+		sum += world.get<Transform>(entities[i])->angle;
+	double getMs = msSince(start);
+
+	// structural changes: a tenth stops moving, another tenth is destroyed and recreated
+	start = Clock::now();
+	for (size_t i = 0; i < count; i += 20)
+		world.remove<Velocity>(entities[i]);
+	for (size_t i = 1; i < count; i += 20)
+		world.add(entities[i], Velocity{glm::vec3(1.0f)});
+	double migrateMs = msSince(start);
+	start = Clock::now();
+	for (size_t i = 2; i < count; i += 10)
+		world.destroy(entities[i]);
+	for (size_t i = 2; i < count; i += 10)
+		entities[i] = world.create(objects[i].transform, objects[i].mesh, objects[i].material, Bounds());
+	double churnMs = msSince(start);
+	size_t badHandles = world.size() != count;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Transform *t = world.get<Transform>(entities[i]);
+		badHandles += t == nullptr || t->position != objects[i].transform.position;
+		badHandles += world.has<Velocity>(entities[i]) != ((i % 20 == 1) || (i % 2 == 0 && i % 20 != 0 && i % 10 != 2));
+	}
+
+	std::cout << count << " entities in " << world.archetypeCount() << " archetypes, " << world.chunkCapacity<Transform, MeshRef, MaterialRef, Bounds>()
+			  << " per 16 KB chunk without Velocity, " << jobs.threadCount() << " worker threads, " << frames << " frames" << std::endl;
+	std::cout << "create all:          " << createMs << " ms" << std::endl;
+	aos.print("array of structs:    ", frames);
+	serial.print("ECS, serial:         ", frames / 2 + frames % 2);
+	parallel.print("ECS, JobSystem:      ", std::max(1, frames / 2));
+	std::cout << "get by handle, random order: " << getMs << " ms (" << sum << ")" << std::endl;
+	std::cout << "add/remove Velocity on 10%:  " << migrateMs << " ms" << std::endl;
+	std::cout << "destroy + create 10%:        " << churnMs << " ms" << std::endl;
+	std::cout << (double)visibleTotal / frames << " visible per frame, mismatches: " << mismatches << ", bad handles: " << badHandles << std::endl;
+	return mismatches || badHandles ? 1 : 0;
+}
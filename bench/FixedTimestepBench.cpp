@@ -0,0 +1,127 @@
+// Fixed timestep: the old loop (one variable-dt update per rendered frame) against
+// FixedTimestep (120 Hz simulation, interpolated at render time), with rendering
+// capped at 60 and 240 fps and uncapped. Reports simulation steps and CPU use per
+// second of wall time, showing simulation cost no longer scales with render rate.
+//
+// usage: FixedTimestepBench [objects] [seconds]
+
+#include "FixedTimestep.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Body
+{
+	glm::vec3 position, velocity;
+	float angle, spin;
+};
+
+struct Result
+{
+	double fps, stepsPerSecond, cpuPercent;
+};
+
+static void simulate(std::vector<Body> &bodies, float dt)
+{
+	for (Body &b : bodies)
+	{
+		b.position += b.velocity * dt;
+		for (int axis = 0; axis < 3; axis++)
+			if (b.position[axis] < -50.0f || b.position[axis] > 50.0f)
+				b.velocity[axis] = -b.velocity[axis];
+		b.angle += b.spin * dt;
+	}
+}
+
+// stand-in for building the frame: one model matrix per object, blended between steps
+static void render(const std::vector<Body> &previous, const std::vector<Body> &current, float alpha, std::vector<glm::mat4> &models)
+{
+	for (size_t i = 0; i < current.size(); i++)
+	{
+		glm::vec3 position = glm::mix(previous[i].position, current[i].position, alpha);
+		float angle = glm::mix(previous[i].angle, current[i].angle, alpha);
+		models[i] = glm::rotate(glm::translate(glm::mat4(1.0f), position), angle, glm::vec3(1.0f, 0.3f, 0.5f));
+	}
+}
+
+static Result run(bool fixed, double renderHz, size_t objects, double seconds)
+{
+	std::vector<Body> current(objects), previous;
+	for (size_t i = 0; i < objects; i++)
+		current[i] = {glm::vec3((float)(i % 100) - 50.0f, (float)(i / 100 % 100) - 50.0f, 0.0f),
+					  glm::vec3(1.0f + i % 7, 2.0f - i % 5, 0.5f * (i % 3)), 0.0f, 0.1f * (i % 11)};
+	previous = current;
+	std::vector<glm::mat4> models(objects);
+
+	FixedTimestep clock(1.0 / 120.0, 8);
+	const auto period = renderHz > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / renderHz)) : Clock::duration::zero();
+	const auto start = Clock::now();
+	const std::clock_t cpuStart = std::clock();
+	auto deadline = start;
+	double lastFrame = 0.0;
+	unsigned long long frames = 0, steps = 0;
+	for (;;)
+	{
+		double now = std::chrono::duration<double>(Clock::now() - start).count();
+		if (now >= seconds)
+			break;
+		if (fixed)
+		{
+			clock.advance(now);
+			while (clock.step())
+			{
+				previous = current;
+				simulate(current, (float)clock.dt());
+				steps++;
+			}
+			render(previous, current, (float)clock.alpha(), models);
+		}
+		else
+		{
+			// the old loop: a float dt straight from the frame clock, one update per frame
+			simulate(current, (float)(now - lastFrame));
+			lastFrame = now;
+			steps++;
+			render(current, current, 1.0f, models);
+		}
+		frames++;
+
+		// capped: sleep until the next frame is due, restarting the schedule if we fell behind
+		if (renderHz > 0.0)
+		{
+			deadline += period;
+			if (deadline < Clock::now())
+				deadline = Clock::now();
+			std::this_thread::sleep_until(deadline);
+		}
+	}
+	double wall = std::chrono::duration<double>(Clock::now() - start).count();
+	double cpu = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	return {frames / wall, steps / wall, 100.0 * cpu / wall};
+}
+
+int main(int argc, char **argv)
+{
+	const size_t objects = argc > 1 ? (size_t)atoll(argv[1]) : 20000;
+	const double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+	std::cout << objects << " objects, " << seconds << " s per run, fixed step 120 Hz (max 8 catch-up steps)" << std::endl;
+
+	for (double hz : {60.0, 240.0, 0.0})
+		for (bool fixed : {false, true})
+		{
+			Result r = run(fixed, hz, objects, seconds);
+			std::cout << (hz > 0.0 ? std::to_string((int)hz) + " fps cap" : std::string("uncapped  ")) << (fixed ? ", fixed step:    " : ", variable step: ")
+					  << r.fps << " fps, " << r.stepsPerSecond << " sim steps/s, " << r.cpuPercent << "% CPU" << std::endl;
+		}
+	return 0;
+}
@@ -0,0 +1,111 @@
+// Frame pacing: a synthetic frame with jittery CPU cost run uncapped, with a plain
+// sleep_until limiter and with FrameLimiter (sleep+spin, with and without
+// predictive start). Reports frame time spread, start-to-present latency and CPU
+// use, then overloads the frame to show the limiter falling back to a lower rate.
+//
+// usage: FramePacingBench [target fps] [work ms] [seconds]
+
+#include "FrameLimiter.h"
+#include "FrameTimings.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum class Pacing
+{
+	Uncapped,
+	SleepUntil,
+	Limiter,
+	Predictive
+};
+
+struct Result
+{
+	FrameTimings::Summary frames;
+	double latencyMs, cpuPercent, finalRate;
+};
+
+static void busyFor(double ms)
+{
+	auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+	while (Clock::now() < end)
+	{
+	}
+}
+
+static double msBetween(Clock::time_point a, Clock::time_point b)
+{
+	return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static Result run(Pacing pacing, double fps, double workMs, double seconds)
+{
+	FrameLimiter limiter(pacing == Pacing::Limiter || pacing == Pacing::Predictive ? fps : 0.0, pacing == Pacing::Predictive);
+	const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+	std::mt19937 rng(7);
+	// mostly steady, with the odd slow frame
+	std::normal_distribution<double> jitter(workMs, workMs * 0.15);
+
+	std::vector<double> frameTimes, latencies;
+	const auto start = Clock::now();
+	const std::clock_t cpuStart = std::clock();
+	auto deadline = start + period;
+	auto lastPresent = start;
+	while (Clock::now() - start < std::chrono::duration<double>(seconds))
+	{
+		limiter.beginFrame();
+		// input would be sampled here, latency runs from now until present
+		auto frameStart = Clock::now();
+		busyFor(std::max(0.0, jitter(rng)) * (rng() % 60 == 0 ? 2.0 : 1.0));
+		auto present = Clock::now();
+		limiter.endFrame();
+
+		frameTimes.push_back(msBetween(lastPresent, present));
+		latencies.push_back(msBetween(frameStart, present));
+		lastPresent = present;
+
+		// the usual limiter: sleep off whatever is left of the frame after presenting
+		if (pacing == Pacing::SleepUntil)
+		{
+			std::this_thread::sleep_until(deadline);
+			deadline = std::max(deadline + period, Clock::now());
+		}
+	}
+	double wall = std::chrono::duration<double>(Clock::now() - start).count();
+	double cpu = (double)(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	return {FrameTimings::summarize(frameTimes), FrameTimings::summarize(latencies).mean, 100.0 * cpu / wall, limiter.rate()};
+}
+
+static void print(const char *name, const Result &r)
+{
+	std::cout << name << r.frames.frames << " frames, frame ms mean " << r.frames.mean << " sd " << r.frames.stddev
+			  << " p99 " << r.frames.p99 << ", latency " << r.latencyMs << " ms, " << r.cpuPercent << "% CPU" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	const double fps = argc > 1 ? atof(argv[1]) : 60.0;
+	const double workMs = argc > 2 ? atof(argv[2]) : 4.0;
+	const double seconds = argc > 3 ? atof(argv[3]) : 3.0;
+	std::cout << "target " << fps << " fps, " << workMs << " ms work per frame, " << seconds << " s per run" << std::endl;
+
+	print("uncapped:           ", run(Pacing::Uncapped, fps, workMs, seconds));
+	print("sleep_until:        ", run(Pacing::SleepUntil, fps, workMs, seconds));
+	print("limiter:            ", run(Pacing::Limiter, fps, workMs, seconds));
+	print("limiter, predictive:", run(Pacing::Predictive, fps, workMs, seconds));
+
+	// work that can't fit the target: the limiter should settle on an even lower rate
+	double overload = 1200.0 / fps;
+	Result r = run(Pacing::Predictive, fps, overload, seconds);
+	std::cout << "overloaded (" << overload << " ms work): paced at " << r.finalRate << " fps, ";
+	print("", r);
+	return 0;
+}
@@ -0,0 +1,137 @@
+// Frame pipelining: a CPU-heavy synthetic frame (object transforms on the update
+// side, draw recording + sorting on the render side) run serially and through
+// FramePipeline, reporting frames per second and snapshot-to-submit latency.
+//
+// usage: FramePipelineBench [objects]
+
+#include "FramePipeline.h"
+#include "RenderQueue.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Snapshot
+{
+	std::vector<glm::mat4> models;
+	Clock::time_point sampled;
+};
+
+struct Result
+{
+	double fps;
+	double latencyMs;
+};
+
+static void simulate(Snapshot &s, size_t objects, int frame)
+{
+	s.sampled = Clock::now();
+	s.models.resize(objects);
+	for (size_t i = 0; i < objects; i++)
+	{
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((float)(i % 100), (float)(i / 100 % 100), -(float)(i / 10000)));
+		s.models[i] = glm::rotate(model, 0.01f * (float)(frame + i), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+}
+
+// stand-in for GL submission: record one draw per object and sort them
+static void render(RenderQueue &queue, const Snapshot &s)
+{
+	queue.reset();
+	RenderQueue::Bucket &bucket = queue.bucket(0);
+	for (size_t i = 0; i < s.models.size(); i++)
+	{
+		uint32_t depth = SortKey::quantizeDepth(-s.models[i][3].z, 0.1f, 1000.0f);
+		bucket.submit({SortKey::make(0, (unsigned)(i % 8), (unsigned)(i % 64), (unsigned)(i % 4), depth), 0, 36, s.models[i]});
+	}
+	queue.sort();
+	queue.simulate();
+}
+
+static double msSince(Clock::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+static Result runSerial(size_t objects, int frames)
+{
+	RenderQueue queue;
+	Snapshot s;
+	double latency = 0.0;
+	auto start = Clock::now();
+	for (int f = 0; f < frames; f++)
+	{
+		simulate(s, objects, f);
+		render(queue, s);
+		latency += msSince(s.sampled);
+	}
+	return {frames / (msSince(start) / 1000.0), latency / frames};
+}
+
+static Result runPipelined(size_t objects, int frames, FramePipeline<Snapshot>::Mode mode, unsigned ahead)
+{
+	FramePipeline<Snapshot> pipeline(mode, ahead);
+	std::thread update([&]()
+					   {
+		for (int f = 0;; f++)
+		{
+			Snapshot *s = pipeline.beginWrite();
+			if (!s)
+				break;
+			simulate(*s, objects, f);
+			pipeline.publish();
+		} });
+
+	RenderQueue queue;
+	double latency = 0.0;
+	int rendered = 0;
+	auto start = Clock::now();
+	while (rendered < frames)
+	{
+		const Snapshot *s = pipeline.acquire();
+		if (!s)
+			continue;
+		render(queue, *s);
+		latency += msSince(s->sampled);
+		rendered++;
+	}
+	double seconds = msSince(start) / 1000.0;
+	pipeline.stop();
+	update.join();
+	return {rendered / seconds, latency / rendered};
+}
+
+int main(int argc, char **argv)
+{
+	const size_t objects = argc > 1 ? (size_t)atoll(argv[1]) : 200000;
+	const int frames = 60;
+	std::cout << objects << " objects, " << frames << " frames, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+	Result serial = runSerial(objects, frames);
+	std::cout << "serial:            " << serial.fps << " fps, latency " << serial.latencyMs << " ms" << std::endl;
+
+	struct Config
+	{
+		const char *name;
+		FramePipeline<Snapshot>::Mode mode;
+		unsigned ahead;
+	};
+	const Config configs[] = {
+		{"pipelined, 1 ahead", FramePipeline<Snapshot>::Mode::Queue, 1},
+		{"pipelined, 2 ahead", FramePipeline<Snapshot>::Mode::Queue, 2},
+		{"pipelined, latest ", FramePipeline<Snapshot>::Mode::Latest, 1},
+	};
+	for (const Config &c : configs)
+	{
+		Result r = runPipelined(objects, frames, c.mode, c.ahead);
+		std::cout << c.name << ": " << r.fps << " fps (" << r.fps / serial.fps << "x), latency " << r.latencyMs << " ms" << std::endl;
+	}
+	return 0;
+}
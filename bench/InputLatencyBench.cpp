@@ -0,0 +1,127 @@
+// Input latency replay: plays a synthetic 1 kHz mouse stream in real time into
+// InputSystem, runs the update thread / render thread pipeline from main.cpp
+// with a fixed render cost, and measures event-to-matrix-upload latency with
+// and without late latching the camera orientation.
+//
+// usage: InputLatencyBench [render ms]
+
+#include "FramePipeline.h"
+#include "InputSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const Clock::time_point epoch = Clock::now();
+
+static double now()
+{
+	return std::chrono::duration<double>(Clock::now() - epoch).count();
+}
+
+static void busyUntil(double t)
+{
+	while (now() < t)
+	{
+	}
+}
+
+struct Snapshot
+{
+	Camera camera;
+	InputSystem::LookState look;
+	glm::mat4 view;
+};
+
+struct Stats
+{
+	double mean, p99, max;
+};
+
+static Stats replay(bool lateLatch, double renderMs, double seconds)
+{
+	InputSystem input;
+	Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+	FramePipeline<Snapshot> pipeline(FramePipeline<Snapshot>::Mode::Queue, 1);
+
+	// event i is pushed at eventTimes[i]
+	const double start = now() + 0.01;
+	const size_t eventCount = (size_t)(seconds * 1000.0);
+	std::vector<double> eventTimes(eventCount);
+	std::atomic<bool> producing{true};
+	std::thread producer([&]()
+						 {
+		for (size_t i = 0; i < eventCount; i++)
+		{
+			busyUntil(start + i * 0.001);
+			double t = now();
+			eventTimes[i] = t;
+			input.push({InputEvent::MouseMove, FORWARD, std::sin((float)i * 0.01f), 0.1f, t});
+		}
+		producing = false; });
+
+	std::thread update([&]()
+					   {
+		while (Snapshot *s = pipeline.beginWrite())
+		{
+			s->look = input.integrate(camera, now());
+			s->camera = camera;
+			s->view = camera.GetViewMatrix();
+			pipeline.publish();
+		} });
+
+	std::vector<double> latencies;
+	latencies.reserve(eventCount);
+	uint64_t uploaded = 0;
+	while (producing || uploaded < eventCount)
+	{
+		const Snapshot *s = pipeline.acquire();
+		if (!s)
+			continue;
+		// command recording and submission before the view matrix is needed
+		busyUntil(now() + renderMs / 1000.0);
+
+		uint64_t included = s->look.events;
+		glm::mat4 view = s->view;
+		if (lateLatch)
+		{
+			Camera latched = s->camera;
+			included = input.lateLatch(latched, s->look);
+			view = latched.GetViewMatrix();
+		}
+		// "upload": every event included in this view gets its latency recorded
+		double t = now();
+		for (; uploaded < included; uploaded++)
+			latencies.push_back((t - eventTimes[uploaded]) * 1000.0);
+		(void)view;
+	}
+	pipeline.stop();
+	producer.join();
+	update.join();
+
+	std::sort(latencies.begin(), latencies.end());
+	double sum = 0.0;
+	for (double l : latencies)
+		sum += l;
+	return {sum / latencies.size(), latencies[latencies.size() * 99 / 100], latencies.back()};
+}
+
+int main(int argc, char **argv)
+{
+	const double renderMs = argc > 1 ? atof(argv[1]) : 8.0;
+	const double seconds = 2.0;
+	std::cout << "1 kHz mouse for " << seconds << " s, " << renderMs << " ms render cost per frame" << std::endl;
+	for (bool late : {false, true})
+	{
+		Stats s = replay(late, renderMs, seconds);
+		std::cout << (late ? "late latch:    " : "snapshot only: ") << "mean " << s.mean << " ms, p99 " << s.p99 << " ms, max " << s.max << " ms" << std::endl;
+	}
+	return 0;
+}
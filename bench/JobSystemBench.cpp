@@ -0,0 +1,107 @@
+// Job system scalability: a synthetic frame of 1M transform updates followed by
+// frustum culling, run through JobSystem::parallelFor with 1..N threads.
+//
+// usage: JobSystemBench [objects]
+
+#include "JobSystem.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct Object
+{
+	glm::vec3 position;
+	glm::vec3 axis;
+	float angle;
+	float spin;
+	float radius;
+};
+
+// Gribb/Hartmann plane extraction, planes point inwards
+static void frustumPlanes(const glm::mat4 &m, glm::vec4 planes[6])
+{
+	for (int i = 0; i < 3; i++)
+	{
+		planes[i * 2] = glm::vec4(m[0][3] + m[0][i], m[1][3] + m[1][i], m[2][3] + m[2][i], m[3][3] + m[3][i]);
+		planes[i * 2 + 1] = glm::vec4(m[0][3] - m[0][i], m[1][3] - m[1][i], m[2][3] - m[2][i], m[3][3] - m[3][i]);
+	}
+	for (int i = 0; i < 6; i++)
+		planes[i] = planes[i] / glm::length(glm::vec3(planes[i]));
+}
+
+int main(int argc, char **argv)
+{
+	const size_t objectCount = argc > 1 ? (size_t)atoll(argv[1]) : 1000000;
+	const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	const int frames = 10;
+	const float dt = 1.0f / 60.0f;
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> pos(-500.0f, 500.0f), unit(-1.0f, 1.0f), speed(0.1f, 2.0f);
+	std::vector<Object> objects(objectCount);
+	for (Object &o : objects)
+		o = {glm::vec3(pos(rng), pos(rng), pos(rng)), glm::normalize(glm::vec3(unit(rng), unit(rng), 0.5f)), 0.0f, speed(rng), 1.0f};
+	std::vector<glm::mat4> models(objectCount);
+	std::vector<unsigned char> visible(objectCount);
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::vec4 planes[6];
+	frustumPlanes(projection * view, planes);
+
+	auto update = [&](size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			Object &o = objects[i];
+			o.angle += o.spin * dt;
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), o.position);
+			models[i] = glm::rotate(model, o.angle, o.axis);
+		}
+	};
+	std::atomic<size_t> visibleCount{0};
+	auto cull = [&](size_t first, size_t last)
+	{
+		size_t count = 0;
+		for (size_t i = first; i < last; i++)
+		{
+			glm::vec3 center(models[i][3]);
+			bool inside = true;
+			for (int p = 0; p < 6 && inside; p++)
+				inside = glm::dot(glm::vec3(planes[p]), center) + planes[p].w > -objects[i].radius;
+			visible[i] = inside;
+			count += inside;
+		}
+		visibleCount.fetch_add(count, std::memory_order_relaxed);
+	};
+
+	std::cout << objectCount << " objects, " << frames << " frames per run" << std::endl;
+	double baseline = 0.0;
+	for (unsigned threads = 1; threads <= maxThreads; threads = threads < maxThreads ? std::min(maxThreads, threads * 2) : threads + 1)
+	{
+		JobSystem jobs(threads);
+		double best = 1e30;
+		for (int f = 0; f < frames; f++)
+		{
+			visibleCount = 0;
+			auto t0 = std::chrono::steady_clock::now();
+			jobs.parallelFor(0, objectCount, 4096, update);
+			jobs.parallelFor(0, objectCount, 4096, cull);
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+		}
+		if (threads == 1)
+			baseline = best;
+		std::cout << threads << " threads: " << best << " ms/frame, speedup " << baseline / best
+				  << "x, visible " << visibleCount.load() << std::endl;
+	}
+	return 0;
+}
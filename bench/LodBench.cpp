@@ -0,0 +1,239 @@
+// Level of detail on a field of high-poly meshes (displaced icospheres) with the
+// camera dollying in: full detail vs LodSelector picking from a MeshSimplifier
+// chain, with and without hysteresis. Reports the chain, triangles drawn and frame
+// time (glFinish included), LOD switches per frame and how far each image is from
+// the full detail one. Run it with LIBGL_ALWAYS_SOFTWARE=1 for the llvmpipe numbers.
+//
+// usage: LodBench [grid] [frames] [subdivisions]
+
+#include "BenchCommon.h"
+#include "LodSelector.h"
+#include "MeshSimplifier.h"
+#include "Shader.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+static const char *meshVertexShader =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aNormal;\n"
+	"out vec3 Normal;\n"
+	"uniform mat4 viewProjection;\n"
+	"uniform vec3 origin;\n"
+	"void main()\n"
+	"{\n"
+	"    gl_Position = viewProjection * vec4(origin + aPos, 1.0);\n"
+	"    Normal = aNormal;\n"
+	"}\n";
+
+static const char *meshFragmentShader =
+	"#version 330 core\n"
+	"in vec3 Normal;\n"
+	"out vec4 FragColor;\n"
+	"void main()\n"
+	"{\n"
+	"    float light = max(dot(normalize(Normal), normalize(vec3(0.4, 0.8, 0.5))), 0.0);\n"
+	"    FragColor = vec4(vec3(0.15) + vec3(0.8, 0.7, 0.6) * light, 1.0);\n"
+	"}\n";
+
+// Unit icosphere, subdivided and displaced so simplification has real detail to remove
+static void displacedSphere(int subdivisions, std::vector<glm::vec3> &positions, std::vector<uint32_t> &indices)
+{
+	const float t = (1.0f + std::sqrt(5.0f)) * 0.5f;
+	positions = {{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0}, {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t}, {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}};
+	indices = {0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			   3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+	for (glm::vec3 &p : positions)
+		p = glm::normalize(p);
+	for (int s = 0; s < subdivisions; s++)
+	{
+		std::map<uint64_t, uint32_t> midpoints;
+		auto midpoint = [&](uint32_t a, uint32_t b)
+		{
+			uint64_t key = a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+			auto it = midpoints.find(key);
+			if (it != midpoints.end())
+				return it->second;
+			positions.push_back(glm::normalize(positions[a] + positions[b]));
+			return midpoints[key] = (uint32_t)positions.size() - 1;
+		};
+		std::vector<uint32_t> next;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+			next.insert(next.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+		}
+		indices.swap(next);
+	}
+	for (glm::vec3 &p : positions)
+		p *= 1.0f + 0.08f * std::sin(7.0f * p.x) * std::sin(7.0f * p.y) * std::sin(7.0f * p.z);
+}
+
+struct Totals
+{
+	double ms = 0.0;
+	size_t triangles = 0, switches = 0, differingPixels = 0;
+	double absoluteDifference = 0.0;
+};
+
+int main(int argc, char **argv)
+{
+	const int grid = argc > 1 ? atoi(argv[1]) : 12;
+	const int frames = argc > 2 ? atoi(argv[2]) : 30;
+	const int subdivisions = argc > 3 ? atoi(argv[3]) : 5;
+	const int width = 640, height = 360;
+	const float Zoom = 45.0f; // Camera's default
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t> indices;
+	displacedSphere(subdivisions, positions, indices);
+	std::vector<glm::vec3> normals(positions.size(), glm::vec3(0.0f));
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		glm::vec3 a = positions[indices[i]], b = positions[indices[i + 1]], c = positions[indices[i + 2]];
+		glm::vec3 n = glm::cross(b - a, c - a);
+		for (int k = 0; k < 3; k++)
+			normals[indices[i + k]] += n;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	LodChain chain = MeshSimplifier::buildChain(positions, indices, 8);
+	double buildMs = elapsedMs(start);
+	std::cout << "chain built in " << buildMs << " ms:";
+	for (size_t l = 0; l < chain.levels.size(); l++)
+		std::cout << " " << chain.triangles(l) << " (" << chain.levels[l].error << ")";
+	std::cout << std::endl;
+
+	GLFWwindow *window = createHiddenContext("LodBench", width, height);
+	if (window == NULL)
+		return 1;
+
+	GLuint program = Shader::link(meshVertexShader, meshFragmentShader);
+	GLint viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+	GLint originLocation = glGetUniformLocation(program, "origin");
+
+	std::vector<float> vertices;
+	for (size_t v = 0; v < positions.size(); v++)
+	{
+		glm::vec3 n = glm::normalize(normals[v]);
+		vertices.insert(vertices.end(), {positions[v].x, positions[v].y, positions[v].z, n.x, n.y, n.z});
+	}
+	GLuint vao, vbo, ebo;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, chain.indices.size() * sizeof(uint32_t), chain.indices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+
+	std::vector<glm::vec3> origins;
+	for (int z = 0; z < grid; z++)
+		for (int x = 0; x < grid; x++)
+			origins.push_back(glm::vec3((x - (grid - 1) * 0.5f) * 3.0f, 0.0f, -z * 3.0f));
+
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, width, height);
+	glm::mat4 projection = glm::perspective(glm::radians(Zoom), (float)width / height, 0.1f, 500.0f);
+
+	LodSelector withHysteresis(1.0f, 0.25f), withoutHysteresis(1.0f, 0.0f);
+	for (LodSelector *selector : {&withHysteresis, &withoutHysteresis})
+		selector->setProjection(Zoom, height);
+	std::vector<unsigned> levelsWith(origins.size()), levelsWithout(origins.size());
+	std::vector<uint8_t> reference(width * height * 4), pixels(width * height * 4);
+	Totals full, hysteresis, noHysteresis;
+
+	for (int f = 0; f <= frames; f++)
+	{
+		// dolly in from far away, with a slight wobble so distances go back and forth
+		float t = (float)f / frames;
+		glm::vec3 eye(0.0f, 2.0f + 1.5f * t, 30.0f - 26.0f * t + 0.3f * std::sin(f * 1.7f));
+		glm::mat4 viewProjection = projection * glm::lookAt(eye, glm::vec3(0.0f, 0.0f, -grid * 1.5f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		// full detail on level 0, LOD runs on the level each selector picks
+		auto render = [&](std::vector<unsigned> *levels, const LodSelector *selector, Totals &totals, std::vector<uint8_t> &out)
+		{
+			auto start = std::chrono::steady_clock::now();
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glUseProgram(program);
+			glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+			glBindVertexArray(vao);
+			size_t triangles = 0, switches = 0;
+			for (size_t i = 0; i < origins.size(); i++)
+			{
+				unsigned level = 0;
+				if (levels)
+				{
+					float distance = LodSelector::distance(chain, eye, origins[i] + chain.center);
+					level = f == 0 ? selector->initial(chain, distance) : selector->select(chain, distance, (*levels)[i]);
+					switches += f > 0 && level != (*levels)[i];
+					(*levels)[i] = level;
+				}
+				const LodLevel &l = chain.levels[level];
+				glUniform3f(originLocation, origins[i].x, origins[i].y, origins[i].z);
+				glDrawElements(GL_TRIANGLES, l.indexCount, GL_UNSIGNED_INT, (void *)(l.indexOffset * sizeof(uint32_t)));
+				triangles += l.indexCount / 3;
+			}
+			glFinish();
+			double ms = elapsedMs(start);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, out.data());
+			if (f == 0)
+				return; // warmup
+			totals.ms += ms;
+			totals.triangles += triangles;
+			totals.switches += switches;
+		};
+
+		auto compare = [&](Totals &totals)
+		{
+			if (f == 0)
+				return;
+			for (size_t p = 0; p < pixels.size(); p += 4)
+			{
+				int difference = 0;
+				for (int c = 0; c < 3; c++)
+					difference = std::max(difference, std::abs((int)pixels[p + c] - (int)reference[p + c]));
+				totals.absoluteDifference += difference;
+				totals.differingPixels += difference > 8;
+			}
+		};
+
+		render(NULL, NULL, full, reference);
+		render(&levelsWith, &withHysteresis, hysteresis, pixels);
+		compare(hysteresis);
+		render(&levelsWithout, &withoutHysteresis, noHysteresis, pixels);
+		compare(noHysteresis);
+	}
+
+	std::cout << origins.size() << " meshes of " << chain.triangles(0) << " triangles, " << frames << " frames at " << width << "x" << height
+			  << ", 1 pixel error threshold" << std::endl;
+	double pixelCount = (double)width * height * frames;
+	auto report = [&](const char *name, const Totals &totals, bool lod)
+	{
+		std::cout << name << totals.ms / frames << " ms/frame, " << (double)totals.triangles / frames / 1e6 << " M triangles";
+		if (lod)
+			std::cout << ", " << (double)totals.switches / frames << " LOD switches/frame, mean difference " << totals.absoluteDifference / pixelCount
+					  << ", " << 100.0 * totals.differingPixels / pixelCount << "% pixels off by more than 8";
+		std::cout << std::endl;
+	};
+	report("full detail:           ", full, false);
+	report("LOD, 25% hysteresis:   ", hysteresis, true);
+	report("LOD, no hysteresis:    ", noHysteresis, true);
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,153 @@
+// MatrixKernels against the glm code they replace: batch multiply (pairwise and
+// viewProjection * model), affine inverse (vs glm::inverse), TRS compose (vs
+// translate * mat4_cast * scale), point transforms and 8-wide block multiply. Each
+// kernel runs in its scalar, SSE4.1 and AVX2 version, best of several repeats over a
+// cache resident batch, and reports ns per item and the largest difference from glm.
+//
+// usage: MatrixKernelsBench [count] [repeats]
+
+#include "MatrixKernels.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static float maxDifference(const std::vector<glm::mat4> &a, const std::vector<glm::mat4> &b)
+{
+	float worst = 0.0f;
+	for (size_t i = 0; i < a.size(); i++)
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+				worst = std::max(worst, std::abs(a[i][c][r] - b[i][c][r]));
+	return worst;
+}
+
+// Best time of repeats runs of fn, in ns per item
+template <typename F>
+static double nsPerItem(int repeats, size_t items, F &&fn)
+{
+	double best = 1e30;
+	for (int r = 0; r < repeats; r++)
+	{
+		auto start = Clock::now();
+		fn();
+		best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+	}
+	return best / items;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t count = argc > 1 ? (size_t)atoll(argv[1]) / 8 * 8 : 16384;
+	const int repeats = argc > 2 ? atoi(argv[2]) : 50;
+	const size_t blocks = count / 8;
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> pos(-100.0f, 100.0f), unit(-1.0f, 1.0f), size(0.5f, 2.0f), angle(0.0f, 6.2831853f);
+	std::vector<glm::vec3> translations(count), scales(count), points(count);
+	std::vector<glm::quat> rotations(count);
+	std::vector<glm::mat4> a(count), b(count), expected(count), result(count);
+	std::vector<TrsBlock> trs(blocks);
+	std::vector<Vec3Block> pointBlocks(blocks), pointResult(blocks);
+	std::vector<Mat4Block> aBlocks(blocks), bBlocks(blocks), blockResult(blocks);
+	for (size_t i = 0; i < count; i++)
+	{
+		translations[i] = glm::vec3(pos(rng), pos(rng), pos(rng));
+		scales[i] = glm::vec3(size(rng), size(rng), size(rng));
+		rotations[i] = glm::angleAxis(angle(rng), glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 2.0f)));
+		points[i] = glm::vec3(pos(rng), pos(rng), pos(rng));
+		trs[i / 8].set((int)(i % 8), translations[i], rotations[i], scales[i]);
+		pointBlocks[i / 8].set((int)(i % 8), points[i]);
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		a[i] = glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+		b[i] = a[(i * 7 + 3) % count];
+		aBlocks[i / 8].set((int)(i % 8), a[i]);
+		bBlocks[i / 8].set((int)(i % 8), b[i]);
+	}
+	glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f) *
+							   glm::lookAt(glm::vec3(3.0f, 2.0f, 8.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	MatrixKernels kernels[3] = {MatrixKernels(MatrixKernels::Isa::Scalar), MatrixKernels(MatrixKernels::Isa::SSE41), MatrixKernels(MatrixKernels::Isa::AVX2)};
+	const char *names[3] = {"scalar", "SSE4.1", "AVX2"};
+	std::cout << count << " items, best of " << repeats << ", ns per item (largest difference from glm)" << std::endl;
+	std::cout << std::setw(22) << "" << std::setw(10) << "glm";
+	for (const MatrixKernels &k : kernels)
+		std::cout << std::setw(22) << names[(int)k.isa()];
+	std::cout << std::endl;
+
+	bool wrong = false;
+	auto row = [&](const char *name, double glmNs, auto &&run, auto &&difference, float tolerance)
+	{
+		std::cout << std::setw(22) << std::left << name << std::right << std::setw(10) << std::fixed << std::setprecision(2) << glmNs;
+		for (const MatrixKernels &k : kernels)
+		{
+			double ns = nsPerItem(repeats, count, [&]
+								  { run(k); });
+			float error = difference();
+			wrong |= !(error <= tolerance);
+			std::cout << std::setw(10) << ns << " (" << std::scientific << std::setprecision(1) << error << ")" << std::fixed << std::setprecision(2);
+		}
+		std::cout << std::endl;
+	};
+
+	double glmNs = nsPerItem(repeats, count, [&]
+							 { for (size_t i = 0; i < count; i++) expected[i] = a[i] * b[i]; });
+	row("multiply a[i] * b[i]", glmNs, [&](const MatrixKernels &k)
+		{ k.multiply(a.data(), b.data(), result.data(), count); }, [&]
+		{ return maxDifference(result, expected); }, 1e-3f);
+
+	glmNs = nsPerItem(repeats, count, [&]
+					  { for (size_t i = 0; i < count; i++) expected[i] = viewProjection * a[i]; });
+	row("multiply vp * model", glmNs, [&](const MatrixKernels &k)
+		{ k.multiply(viewProjection, a.data(), result.data(), count); }, [&]
+		{ return maxDifference(result, expected); }, 1e-3f);
+
+	glmNs = nsPerItem(repeats, count, [&]
+					  { for (size_t i = 0; i < count; i++) expected[i] = glm::inverse(a[i]); });
+	row("affine inverse", glmNs, [&](const MatrixKernels &k)
+		{ k.affineInverse(a.data(), result.data(), count); }, [&]
+		{ return maxDifference(result, expected); }, 1e-3f);
+
+	glmNs = nsPerItem(repeats, count, [&]
+					  { for (size_t i = 0; i < count; i++) expected[i] = glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]); });
+	row("compose TRS", glmNs, [&](const MatrixKernels &k)
+		{ k.compose(trs.data(), result.data(), count); }, [&]
+		{ return maxDifference(result, expected); }, 1e-4f);
+
+	std::vector<glm::vec3> expectedPoints(count);
+	glm::mat4 model = a[0];
+	glmNs = nsPerItem(repeats, count, [&]
+					  { for (size_t i = 0; i < count; i++) expectedPoints[i] = glm::vec3(model * glm::vec4(points[i], 1.0f)); });
+	row("transform points", glmNs, [&](const MatrixKernels &k)
+		{ k.transformPoints(model, pointBlocks.data(), pointResult.data(), blocks); }, [&]
+		{
+			float worst = 0.0f;
+			for (size_t i = 0; i < count; i++)
+				worst = std::max(worst, glm::length(pointResult[i / 8].get((int)(i % 8)) - expectedPoints[i]));
+			return worst; }, 1e-3f);
+
+	glmNs = nsPerItem(repeats, count, [&]
+					  { for (size_t i = 0; i < count; i++) expected[i] = a[i] * b[i]; });
+	row("block multiply (8x)", glmNs, [&](const MatrixKernels &k)
+		{ k.multiply(aBlocks.data(), bBlocks.data(), blockResult.data(), blocks); }, [&]
+		{
+			for (size_t i = 0; i < count; i++)
+				result[i] = blockResult[i / 8].get((int)(i % 8));
+			return maxDifference(result, expected); }, 1e-3f);
+
+	std::cout << "best available: " << names[(int)MatrixKernels::best()] << (wrong ? ", RESULTS DIFFER FROM GLM" : "") << std::endl;
+	return wrong ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+// Mipmap benchmark: glGenerateMipmap against the CPU MipGenerator (box and Kaiser,
+// plus the upload of every level) on a hidden window. Meant to be run on the
+// headless llvmpipe boxes, e.g. with LIBGL_ALWAYS_SOFTWARE=1 under xvfb-run.
+
+#include "BenchCommon.h"
+
+#include "MipGenerator.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+template <typename F>
+static double bestOf(int runs, F &&fn)
+{
+	double best = 1e30;
+	for (int i = 0; i < runs; i++)
+	{
+		auto t0 = std::chrono::steady_clock::now();
+		fn();
+		auto t1 = std::chrono::steady_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+	}
+	return best;
+}
+
+int main()
+{
+	GLFWwindow *window = createHiddenContext("MipmapBench");
+	if (window == NULL)
+		return -1;
+
+	const int runs = 5;
+	for (int size : {512, 2048})
+	{
+		std::vector<unsigned char> image((size_t)size * size * 4);
+		std::mt19937 rng(size);
+		for (unsigned char &c : image)
+			c = (unsigned char)rng();
+
+		GLuint texture;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		double gpu = bestOf(runs, [&]
+							{
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glFinish(); });
+
+		MipOptions box;
+		MipChain chain;
+		double cpuBox = bestOf(runs, [&]
+							   { chain = MipGenerator::generate(image.data(), size, size, box); });
+		double upload = bestOf(runs, [&]
+							   {
+			uploadMipChain(GL_TEXTURE_2D, chain);
+			glFinish(); });
+
+		MipOptions kaiser;
+		kaiser.filter = MipFilter::Kaiser;
+		double cpuKaiser = bestOf(runs, [&]
+								  { chain = MipGenerator::generate(image.data(), size, size, kaiser); });
+
+		MipOptions singleThread;
+		singleThread.threads = 1;
+		double cpuBoxSingle = bestOf(runs, [&]
+									 { chain = MipGenerator::generate(image.data(), size, size, singleThread); });
+
+		std::cout << size << "x" << size << std::endl;
+		std::cout << "  glTexImage2D + glGenerateMipmap: " << gpu << " ms" << std::endl;
+		std::cout << "  upload all levels:               " << upload << " ms" << std::endl;
+		std::cout << "  cpu box (sRGB, all cores):       " << cpuBox << " ms" << (CpuFeatures::hasAVX2() ? " [AVX2]" : "") << std::endl;
+		std::cout << "  cpu box (sRGB, 1 thread):        " << cpuBoxSingle << " ms" << std::endl;
+		std::cout << "  cpu kaiser (sRGB, all cores):    " << cpuKaiser << " ms" << std::endl;
+
+		glDeleteTextures(1, &texture);
+	}
+
+	glfwTerminate();
+	return 0;
+}
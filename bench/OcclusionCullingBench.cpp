@@ -0,0 +1,162 @@
+// Occlusion culling on a dense synthetic city: a grid of box buildings seen from
+// street level, drawn with SoftwareRasterizer after frustum culling only and after
+// OcclusionCuller (the nearest buildings as occluders). Reports the culled
+// fraction, culling cost and net frame time, and checks both images match, since
+// culling must never remove anything visible.
+//
+// usage: OcclusionCullingBench [grid size] [frames]
+
+#include "BenchCommon.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+#include "SoftwareRasterizer.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+struct Building
+{
+	glm::vec3 min, max;
+	glm::mat4 model;
+};
+
+// unit cube, position + texture coordinate
+static std::vector<SoftwareVertex> cubeVertices()
+{
+	std::vector<SoftwareVertex> vertices;
+	emitUnitCube([&](const glm::vec3 &position, const glm::vec2 &uv)
+				 { vertices.push_back({position, uv}); });
+	return vertices;
+}
+
+int main(int argc, char **argv)
+{
+	const int grid = argc > 1 ? atoi(argv[1]) : 100;
+	const int frames = argc > 2 ? atoi(argv[2]) : 20;
+	const int width = 640, height = 360;
+	const size_t occluderCount = 64;
+
+	// blocks 12 units apart, 8x8 footprints, so streets are 4 wide
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> heights(6.0f, 40.0f);
+	std::vector<Building> buildings;
+	for (int z = 0; z < grid; z++)
+		for (int x = 0; x < grid; x++)
+		{
+			glm::vec3 centre(x * 12.0f, 0.0f, -z * 12.0f);
+			float h = heights(rng);
+			Building b;
+			b.min = centre + glm::vec3(-4.0f, 0.0f, -4.0f);
+			b.max = centre + glm::vec3(4.0f, h, 4.0f);
+			b.model = glm::scale(glm::translate(glm::mat4(1.0f), (b.min + b.max) * 0.5f), b.max - b.min);
+			buildings.push_back(b);
+		}
+
+	std::vector<uint8_t> checker(64 * 64 * 3);
+	for (int i = 0; i < 64 * 64; i++)
+		std::fill_n(&checker[i * 3], 3, (uint8_t)((((i % 64) / 8 + (i / 64) / 8) & 1) ? 220 : 90));
+	SoftwareTexture texture(checker.data(), 64, 64, 3);
+	std::vector<SoftwareVertex> cube = cubeVertices();
+
+	JobSystem jobs;
+	SoftwareRasterizer rasterizer(jobs);
+	SoftwareFramebuffer withoutCulling(width, height), withCulling(width, height);
+	OcclusionCuller culler;
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)width / height, 0.5f, 1000.0f);
+
+	std::vector<uint8_t> frustumVisible(buildings.size()), occlusionVisible(buildings.size());
+	std::vector<size_t> byDistance(buildings.size());
+	double frustumMs = 0.0, occlusionMs = 0.0, drawAllMs = 0.0, drawCulledMs = 0.0;
+	size_t inFrustum = 0, afterOcclusion = 0, differingPixels = 0;
+
+	auto draw = [&](SoftwareFramebuffer &target, const std::vector<uint8_t> &visible)
+	{
+		target.clear(glm::vec4(0.5f, 0.6f, 0.8f, 1.0f));
+		rasterizer.setTextures(&texture, &texture);
+		for (size_t i = 0; i < buildings.size(); i++)
+			if (visible[i])
+				rasterizer.draw(cube.data(), cube.size(), buildings[i].model);
+		rasterizer.flush(target);
+	};
+
+	for (int f = 0; f < frames; f++)
+	{
+		// walk down a street at head height, looking along it
+		glm::vec3 eye(6.0f + f * 0.5f, 2.0f, 10.0f - f * 3.0f);
+		glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.15f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 viewProjection = projection * view;
+		rasterizer.setViewProjection(view, projection);
+
+		// frustum only: an empty depth buffer hides nothing, it only drops what is off screen
+		auto start = Clock::now();
+		culler.begin(viewProjection);
+		culler.finish();
+		jobs.parallelFor(0, buildings.size(), 256, [&](size_t first, size_t last)
+						 {
+			for (size_t i = first; i < last; i++)
+				frustumVisible[i] = culler.isVisible(buildings[i].min, buildings[i].max); });
+		frustumMs += msSince(start);
+
+		// occlusion: the closest buildings in view become occluders
+		start = Clock::now();
+		size_t candidates = 0;
+		for (size_t i = 0; i < buildings.size(); i++)
+			if (frustumVisible[i])
+				byDistance[candidates++] = i;
+		auto distance = [&](size_t i)
+		{ return glm::length((buildings[i].min + buildings[i].max) * 0.5f - eye); };
+		size_t occluders = std::min(occluderCount, candidates);
+		std::nth_element(byDistance.begin(), byDistance.begin() + occluders, byDistance.begin() + candidates,
+						 [&](size_t a, size_t b)
+						 { return distance(a) < distance(b); });
+		culler.begin(viewProjection);
+		for (size_t o = 0; o < occluders; o++)
+			culler.addOccluderBox(buildings[byDistance[o]].model, glm::vec3(-0.5f), glm::vec3(0.5f));
+		culler.finish();
+		jobs.parallelFor(0, buildings.size(), 256, [&](size_t first, size_t last)
+						 {
+			for (size_t i = first; i < last; i++)
+				occlusionVisible[i] = frustumVisible[i] && culler.isVisible(buildings[i].min, buildings[i].max); });
+		occlusionMs += msSince(start);
+
+		start = Clock::now();
+		draw(withoutCulling, frustumVisible);
+		drawAllMs += msSince(start);
+		start = Clock::now();
+		draw(withCulling, occlusionVisible);
+		drawCulledMs += msSince(start);
+
+		for (size_t i = 0; i < buildings.size(); i++)
+		{
+			inFrustum += frustumVisible[i];
+			afterOcclusion += occlusionVisible[i];
+		}
+		for (size_t p = 0; p < withCulling.color.size(); p++)
+			differingPixels += withCulling.color[p] != withoutCulling.color[p];
+	}
+
+	std::cout << buildings.size() << " buildings, " << frames << " frames at " << width << "x" << height << ", "
+			  << occluderCount << " occluders into " << culler.bufferWidth() << "x" << culler.bufferHeight() << std::endl;
+	std::cout << "in frustum per frame:       " << (double)inFrustum / frames << std::endl;
+	std::cout << "after occlusion per frame:  " << (double)afterOcclusion / frames << " ("
+			  << 100.0 * (1.0 - (double)afterOcclusion / inFrustum) << "% of the frustum culled)" << std::endl;
+	std::cout << "frustum only:   cull " << frustumMs / frames << " ms + draw " << drawAllMs / frames << " ms = " << (frustumMs + drawAllMs) / frames << " ms" << std::endl;
+	std::cout << "with occlusion: cull " << (frustumMs + occlusionMs) / frames << " ms + draw " << drawCulledMs / frames << " ms = "
+			  << (frustumMs + occlusionMs + drawCulledMs) / frames << " ms" << std::endl;
+	std::cout << "pixels differing between the two: " << differingPixels << (differingPixels ? " (culling removed something visible!)" : "") << std::endl;
+	return differingPixels ? 1 : 0;
+}
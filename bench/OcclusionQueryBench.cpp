@@ -0,0 +1,222 @@
+// GPU occlusion queries on a heavily occluded scene: a grid of groups of instanced
+// cubes behind a wall with a narrow gap, the camera strafing past the gap. Every
+// frame is drawn three times with the same camera: frustum culling only, through
+// OcclusionQueries with GL_QUERY_WAIT and with GL_QUERY_NO_WAIT conditional
+// rendering. Reports frame time (glFinish included), draws issued and skipped, and
+// checks the images match the frustum-only one, since no visible group may vanish.
+// Run it with LIBGL_ALWAYS_SOFTWARE=1 for the llvmpipe numbers.
+//
+// usage: OcclusionQueryBench [grid] [frames]
+
+#include "BenchCommon.h"
+#include "OcclusionQueries.h"
+#include "Shader.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+static const char *cubeVertexShader =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec3 aOffset;\n"
+	"out vec3 Color;\n"
+	"uniform mat4 viewProjection;\n"
+	"uniform vec3 origin;\n"
+	"uniform vec3 scale;\n"
+	"void main()\n"
+	"{\n"
+	"    gl_Position = viewProjection * vec4(origin + aOffset + aPos * scale, 1.0);\n"
+	"    Color = fract((origin + aOffset) * 0.137) * 0.5 + 0.3 + aPos * 0.2;\n"
+	"}\n";
+
+static const char *cubeFragmentShader =
+	"#version 330 core\n"
+	"in vec3 Color;\n"
+	"out vec4 FragColor;\n"
+	"void main()\n"
+	"{\n"
+	"    FragColor = vec4(Color, 1.0);\n"
+	"}\n";
+
+// unit cube, positions only
+static std::vector<float> cubeTriangles()
+{
+	std::vector<float> vertices;
+	emitUnitCube([&](const glm::vec3 &position, const glm::vec2 &)
+				 { vertices.insert(vertices.end(), {position.x, position.y, position.z}); });
+	return vertices;
+}
+
+static GLuint makeVao(GLuint cubeVbo, const std::vector<glm::vec3> &offsets, GLuint &offsetVbo)
+{
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cubeVbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
+	glEnableVertexAttribArray(0);
+	glGenBuffers(1, &offsetVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, offsetVbo);
+	glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(glm::vec3), offsets.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void *)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisor(1, 1);
+	return vao;
+}
+
+struct Totals
+{
+	double ms = 0.0;
+	size_t drawn = 0, conditional = 0, queries = 0, skipped = 0, differing = 0;
+};
+
+int main(int argc, char **argv)
+{
+	const int grid = argc > 1 ? atoi(argv[1]) : 12;
+	const int frames = argc > 2 ? atoi(argv[2]) : 60;
+	const int width = 640, height = 360;
+	const int Side = 8;         // cubes per group along each axis
+	const float Spacing = 0.6f; // between cube centres inside a group
+	const float GroupPitch = 6.0f;
+	const int Warmup = 5;
+
+	GLFWwindow *window = createHiddenContext("OcclusionQueryBench", width, height);
+	if (window == NULL)
+		return 1;
+
+	GLuint program = Shader::link(cubeVertexShader, cubeFragmentShader);
+	GLint viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+	GLint originLocation = glGetUniformLocation(program, "origin");
+	GLint scaleLocation = glGetUniformLocation(program, "scale");
+
+	std::vector<float> cube = cubeTriangles();
+	GLuint cubeVbo;
+	glGenBuffers(1, &cubeVbo);
+	glBindBuffer(GL_ARRAY_BUFFER, cubeVbo);
+	glBufferData(GL_ARRAY_BUFFER, cube.size() * sizeof(float), cube.data(), GL_STATIC_DRAW);
+
+	// one group = Side^3 cubes, offsets relative to the group origin
+	std::vector<glm::vec3> groupOffsets;
+	for (int z = 0; z < Side; z++)
+		for (int y = 0; y < Side; y++)
+			for (int x = 0; x < Side; x++)
+				groupOffsets.push_back((glm::vec3(x, y, z) - glm::vec3((Side - 1) * 0.5f)) * Spacing);
+	GLuint groupOffsetVbo, wallOffsetVbo;
+	GLuint groupVao = makeVao(cubeVbo, groupOffsets, groupOffsetVbo);
+	GLuint wallVao = makeVao(cubeVbo, {glm::vec3(0.0f)}, wallOffsetVbo);
+
+	// groups fill the space behind the wall, the gap in it is 3 units wide at x = 0
+	std::vector<glm::vec3> origins;
+	for (int z = 0; z < grid; z++)
+		for (int x = 0; x < grid; x++)
+			origins.push_back(glm::vec3((x - (grid - 1) * 0.5f) * GroupPitch, 0.0f, -6.0f - z * GroupPitch));
+	glm::vec3 halfExtent((Side - 1) * Spacing * 0.5f + Spacing * 0.35f);
+	const float cubeSize = Spacing * 0.7f;
+
+	auto drawGroup = [&](size_t i)
+	{
+		glUseProgram(program);
+		glBindVertexArray(groupVao);
+		glUniform3f(originLocation, origins[i].x, origins[i].y, origins[i].z);
+		glUniform3f(scaleLocation, cubeSize, cubeSize, cubeSize);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, (GLsizei)groupOffsets.size());
+	};
+	auto drawWall = [&]()
+	{
+		glUseProgram(program);
+		glBindVertexArray(wallVao);
+		for (float side : {-1.0f, 1.0f})
+		{
+			glUniform3f(originLocation, side * 101.5f, 0.0f, 0.0f);
+			glUniform3f(scaleLocation, 200.0f, 200.0f, 0.5f);
+			glDrawArrays(GL_TRIANGLES, 0, 36);
+		}
+	};
+
+	OcclusionQueries waitQueries(4, GL_QUERY_WAIT), noWaitQueries(4, GL_QUERY_NO_WAIT);
+	for (OcclusionQueries *queries : {&waitQueries, &noWaitQueries})
+		for (const glm::vec3 &o : origins)
+			queries->addGroup(o - halfExtent, o + halfExtent);
+
+	glEnable(GL_DEPTH_TEST);
+	glViewport(0, 0, width, height);
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)width / height, 0.1f, 500.0f);
+
+	std::vector<uint8_t> reference(width * height * 4), pixels(width * height * 4);
+	Totals baseline, wait, noWait;
+	size_t frustumDraws = 0;
+
+	for (int f = 0; f < Warmup + frames; f++)
+	{
+		bool measured = f >= Warmup;
+		float t = (float)f / (Warmup + frames - 1);
+		glm::vec3 eye(-12.0f + 24.0f * t, 1.0f, 14.0f);
+		glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		auto beginFrame = [&]()
+		{
+			glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			glUseProgram(program);
+			glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+			drawWall();
+		};
+
+		// frustum culling only, bounding sphere against the clip planes
+		auto start = std::chrono::steady_clock::now();
+		beginFrame();
+		for (size_t i = 0; i < origins.size(); i++)
+		{
+			glm::vec4 c = viewProjection * glm::vec4(origins[i], 1.0f);
+			float r = glm::length(halfExtent) * 2.5f;
+			if (c.x < -c.w - r || c.x > c.w + r || c.y < -c.w - r || c.y > c.w + r || c.w < -r)
+				continue;
+			drawGroup(i);
+			if (measured)
+				frustumDraws++;
+		}
+		glFinish();
+		if (measured)
+			baseline.ms += elapsedMs(start);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, reference.data());
+
+		for (OcclusionQueries *queries : {&waitQueries, &noWaitQueries})
+		{
+			Totals &totals = queries == &waitQueries ? wait : noWait;
+			start = std::chrono::steady_clock::now();
+			beginFrame();
+			queries->render(viewProjection, drawGroup);
+			glFinish();
+			double ms = elapsedMs(start);
+			glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			if (!measured)
+				continue;
+			totals.ms += ms;
+			const OcclusionQueries::Stats &s = queries->stats();
+			totals.drawn += s.drawn + s.unconditional;
+			totals.conditional += s.conditional;
+			totals.queries += s.queries;
+			totals.skipped += s.skipped;
+			for (size_t p = 0; p < pixels.size(); p++)
+				totals.differing += pixels[p] != reference[p];
+		}
+	}
+
+	std::cout << origins.size() << " groups of " << groupOffsets.size() << " cubes, " << frames << " frames at " << width << "x" << height << std::endl;
+	std::cout << "frustum only:      " << baseline.ms / frames << " ms/frame, " << (double)frustumDraws / frames << " draws" << std::endl;
+	for (OcclusionQueries *queries : {&waitQueries, &noWaitQueries})
+	{
+		Totals &totals = queries == &waitQueries ? wait : noWait;
+		std::cout << (queries == &waitQueries ? "queries (WAIT):    " : "queries (NO_WAIT): ") << totals.ms / frames << " ms/frame, "
+				  << (double)totals.drawn / frames << " direct + " << (double)totals.conditional / frames << " conditional draws, "
+				  << (double)totals.queries / frames << " queries, " << (double)totals.skipped / frames << " draws skipped, "
+				  << totals.differing << " differing bytes" << std::endl;
+	}
+
+	glfwTerminate();
+	return wait.differing || noWait.differing ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+// Parallel shader compile benchmark: builds 150 synthetic programs the way Shader
+// does (status checked after every call) and through ProgramBatch. Reports the
+// wall time until all programs are usable with poll() called back to back, the
+// longest single stall inside poll(), and how many 16 ms frames it takes when
+// polled once per frame.
+//
+// Set MESA_SHADER_CACHE_DISABLE=true on Mesa so every run really compiles.
+
+#include "BenchCommon.h"
+
+#include "ProgramBatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+	const int programCount = argc > 1 ? atoi(argv[1]) : 150;
+
+	GLFWwindow *window = createHiddenContext("ParallelShaderBench");
+	if (window == NULL)
+		return -1;
+
+	bool parallel = ProgramBatch::enableParallelCompile();
+	std::cout << "GL_KHR_parallel_shader_compile: " << (parallel ? "yes" : "no") << std::endl;
+
+	std::string vs = syntheticVertexShader(), fs = syntheticFragmentShader();
+
+	// serial, every compile and link waited on before the next one is issued
+	auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < programCount; i++)
+	{
+		std::string v = Shader::injectDefines(vs, syntheticDefines(i));
+		std::string f = Shader::injectDefines(fs, syntheticDefines(i));
+		glDeleteProgram(Shader::link(v.c_str(), f.c_str()));
+	}
+	double serial = elapsedMs(t0);
+
+	// Batched, each run on its own variant range so no driver side dedup kicks in.
+	// Unpaced polls back to back and measures the wall time until every program is
+	// ready. Paced polls once per simulated 16 ms frame, which is how a game would use
+	// it, and counts the frames until ready; its time includes the sleeps.
+	struct BatchRun
+	{
+		double submitMs = 0.0, readyMs = 0.0, worstPollMs = 0.0;
+		int polls = 0;
+		size_t failed = 0;
+	};
+	auto runBatch = [&](int variantBase, bool paced)
+	{
+		BatchRun run;
+		ProgramBatch batch;
+		for (int i = 0; i < programCount; i++)
+			batch.add(vs, fs, syntheticDefines(variantBase + i));
+
+		auto start = std::chrono::steady_clock::now();
+		batch.submit();
+		run.submitMs = elapsedMs(start);
+		while (!batch.done())
+		{
+			auto p0 = std::chrono::steady_clock::now();
+			batch.poll();
+			run.worstPollMs = std::max(run.worstPollMs, elapsedMs(p0));
+			run.polls++;
+			if (paced && !batch.done())
+				std::this_thread::sleep_for(std::chrono::milliseconds(16));
+		}
+		run.readyMs = elapsedMs(start);
+
+		for (ProgramBatch::Handle h = 0; h < batch.size(); h++)
+		{
+			if (batch.state(h) == ProgramBatch::State::Failed)
+				run.failed++;
+			glDeleteProgram(batch.program(h));
+		}
+		return run;
+	};
+	BatchRun unpaced = runBatch(programCount, false);
+	BatchRun paced = runBatch(2 * programCount, true);
+
+	std::cout << programCount << " programs" << std::endl;
+	std::cout << "serial (Shader::link):      " << serial << " ms" << std::endl;
+	std::cout << "batch submit:               " << unpaced.submitMs << " ms" << std::endl;
+	std::cout << "batch until all ready:      " << unpaced.readyMs << " ms (" << unpaced.polls << " polls, no sleeps)" << std::endl;
+	std::cout << "worst single poll():        " << std::max(unpaced.worstPollMs, paced.worstPollMs) << " ms" << std::endl;
+	std::cout << "frames until ready (16 ms): " << paced.polls << " (" << paced.readyMs << " ms including the sleeps)" << std::endl;
+	std::cout << "failed:                     " << unpaced.failed + paced.failed << std::endl;
+
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,95 @@
+// Render queue benchmark: records 100k draws from several threads, then reports
+// merge+sort time and how many state changes the sorted order needs compared
+// to submission order.
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+
+int main()
+{
+	const size_t drawCount = 100000;
+	const unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+	const unsigned programCount = 32, textureSetCount = 256, vaoCount = 64;
+	const int iterations = 20;
+
+	RenderQueue queue(threadCount);
+
+	auto record = [&](unsigned thread)
+	{
+		std::mt19937 rng(1234 + thread);
+		std::uniform_int_distribution<unsigned> program(0, programCount - 1);
+		std::uniform_int_distribution<unsigned> textures(0, textureSetCount - 1);
+		std::uniform_int_distribution<unsigned> vao(0, vaoCount - 1);
+		std::uniform_real_distribution<float> depth(0.1f, 100.0f);
+
+		RenderQueue::Bucket &bucket = queue.bucket(thread);
+		size_t begin = drawCount * thread / threadCount;
+		size_t end = drawCount * (thread + 1) / threadCount;
+		for (size_t i = begin; i < end; i++)
+		{
+			uint64_t key = SortKey::make(0, program(rng), textures(rng), vao(rng), SortKey::quantizeDepth(depth(rng), 0.1f, 100.0f));
+			bucket.submit({key, 0, 36, glm::mat4(1.0f)});
+		}
+	};
+
+	double bestRecord = 1e30, bestSort = 1e30;
+	RenderQueueStats unsorted, sorted;
+	for (int it = 0; it < iterations; it++)
+	{
+		queue.reset();
+
+		auto t0 = std::chrono::steady_clock::now();
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t < threadCount; t++)
+			workers.emplace_back(record, t);
+		for (std::thread &w : workers)
+			w.join();
+		auto t1 = std::chrono::steady_clock::now();
+
+		// state changes in submission order, measured by walking the keys unsorted
+		unsorted = RenderQueueStats();
+		unsigned p = ~0u, tex = ~0u, v = ~0u;
+		for (unsigned t = 0; t < threadCount; t++)
+			for (const DrawCommand &cmd : queue.bucket(t).commands)
+			{
+				unsorted.draws++;
+				if (SortKey::shader(cmd.key) != p)
+					p = SortKey::shader(cmd.key), unsorted.programChanges++;
+				if (SortKey::textureSet(cmd.key) != tex)
+					tex = SortKey::textureSet(cmd.key), unsorted.textureChanges++;
+				if (SortKey::vao(cmd.key) != v)
+					v = SortKey::vao(cmd.key), unsorted.vaoChanges++;
+			}
+
+		auto t2 = std::chrono::steady_clock::now();
+		queue.sort();
+		auto t3 = std::chrono::steady_clock::now();
+		sorted = queue.simulate();
+
+		bestRecord = std::min(bestRecord, std::chrono::duration<double, std::milli>(t1 - t0).count());
+		bestSort = std::min(bestSort, std::chrono::duration<double, std::milli>(t3 - t2).count());
+	}
+
+	for (size_t i = 1; i < queue.size(); i++)
+	{
+		if (queue.sortedKey(i - 1) > queue.sortedKey(i))
+		{
+			std::cout << "ERROR::RENDERQUEUE::KEYS_NOT_SORTED at " << i << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "draws:                 " << sorted.draws << " (" << threadCount << " recording threads)" << std::endl;
+	std::cout << "record time (best):    " << bestRecord << " ms" << std::endl;
+	std::cout << "merge+sort time (best): " << bestSort << " ms" << std::endl;
+	std::cout << "state changes unsorted: " << unsorted.stateChanges()
+			  << " (program " << unsorted.programChanges << ", texture " << unsorted.textureChanges << ", vao " << unsorted.vaoChanges << ")" << std::endl;
+	std::cout << "state changes sorted:   " << sorted.stateChanges()
+			  << " (program " << sorted.programChanges << ", texture " << sorted.textureChanges << ", vao " << sorted.vaoChanges << ")" << std::endl;
+	return 0;
+}
@@ -0,0 +1,202 @@
+// Move heavy workload on SceneContainer: N objects scattered through a 400 unit
+// cube, half of them moving every frame, then a batch of range queries, a frustum
+// query and raycasts. The incremental index is compared against rebuilding it from
+// scratch every frame and against brute force queries over the dense arrays, and
+// every query result is checked against brute force. Also times insert/remove churn.
+//
+// usage: SceneContainerBench [objects] [frames] [cell size]
+
+#include "SceneContainer.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+static bool overlaps(const glm::vec3 &aMin, const glm::vec3 &aMax, const glm::vec3 &bMin, const glm::vec3 &bMax)
+{
+	return aMin.x <= bMax.x && aMax.x >= bMin.x && aMin.y <= bMax.y && aMax.y >= bMin.y && aMin.z <= bMax.z && aMax.z >= bMin.z;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t count = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+	const int frames = argc > 2 ? atoi(argv[2]) : 20;
+	const float cellSize = argc > 3 ? (float)atof(argv[3]) : 8.0f;
+	const float World = 400.0f;
+	const int RangeQueries = 200, Rays = 2000;
+
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> coordinate(0.0f, World), unit(-1.0f, 1.0f), size(0.5f, 2.0f);
+
+	std::vector<glm::vec3> positions(count), velocities(count), halfSizes(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		positions[i] = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+		velocities[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+		halfSizes[i] = glm::vec3(size(rng), size(rng), size(rng)) * 0.5f;
+	}
+	// a few objects bigger than a cell
+	for (size_t i = 0; i < count; i += 1000)
+		halfSizes[i] = glm::vec3(10.0f);
+
+	SceneContainer scene(cellSize);
+	std::vector<SceneContainer::Handle> handles(count);
+	auto start = Clock::now();
+	for (size_t i = 0; i < count; i++)
+		handles[i] = scene.insert(glm::translate(glm::mat4(1.0f), positions[i]), -halfSizes[i], halfSizes[i], (uint32_t)i);
+	double insertMs = msSince(start);
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+	double moveMs = 0.0, rebuildMs = 0.0, rangeMs = 0.0, bruteRangeMs = 0.0, frustumMs = 0.0, bruteFrustumMs = 0.0, rayMs = 0.0, bruteRayMs = 0.0;
+	size_t rangeHits = 0, frustumHits = 0, rayHits = 0, mismatches = 0;
+	std::vector<uint32_t> found, expected;
+
+	for (int f = 0; f < frames; f++)
+	{
+		// half the objects move, the half alternates every frame
+		start = Clock::now();
+		for (size_t i = f & 1; i < count; i += 2)
+		{
+			positions[i] += velocities[i] * (1.0f / 60.0f) * 30.0f;
+			for (int a = 0; a < 3; a++)
+				if (positions[i][a] < 0.0f || positions[i][a] > World)
+					velocities[i][a] = -velocities[i][a];
+			scene.setPosition(handles[i], positions[i]);
+		}
+		moveMs += msSince(start);
+
+		// what keeping no index between frames would cost
+		start = Clock::now();
+		{
+			SceneContainer rebuilt(cellSize);
+			for (size_t i = 0; i < count; i++)
+				rebuilt.insert(glm::translate(glm::mat4(1.0f), positions[i]), -halfSizes[i], halfSizes[i], (uint32_t)i);
+		}
+		rebuildMs += msSince(start);
+
+		const std::vector<glm::vec3> &mins = scene.boundsMin(), &maxs = scene.boundsMax();
+		std::mt19937 queryRng(f);
+		std::uniform_real_distribution<float> queryCoordinate(0.0f, World);
+
+		for (int q = 0; q < RangeQueries; q++)
+		{
+			glm::vec3 centre(queryCoordinate(queryRng), queryCoordinate(queryRng), queryCoordinate(queryRng));
+			glm::vec3 qMin = centre - glm::vec3(10.0f), qMax = centre + glm::vec3(10.0f);
+			found.clear();
+			start = Clock::now();
+			scene.queryRange(qMin, qMax, found);
+			rangeMs += msSince(start);
+			expected.clear();
+			start = Clock::now();
+			for (uint32_t i = 0; i < scene.size(); i++)
+				if (overlaps(mins[i], maxs[i], qMin, qMax))
+					expected.push_back(i);
+			bruteRangeMs += msSince(start);
+			std::sort(found.begin(), found.end());
+			mismatches += found != expected;
+			rangeHits += found.size();
+		}
+
+		glm::vec3 eye(World * 0.5f + 50.0f * std::sin(f * 0.1f), World * 0.5f, World * 0.5f);
+		glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + glm::vec3(std::cos(f * 0.2f), 0.1f, std::sin(f * 0.2f)), glm::vec3(0.0f, 1.0f, 0.0f));
+		found.clear();
+		start = Clock::now();
+		scene.queryFrustum(viewProjection, found);
+		frustumMs += msSince(start);
+		expected.clear();
+		start = Clock::now();
+		{
+			glm::vec4 planes[6];
+			for (int i = 0; i < 3; i++)
+			{
+				glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+				glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+				planes[i * 2] = w + row;
+				planes[i * 2 + 1] = w - row;
+			}
+			for (uint32_t i = 0; i < scene.size(); i++)
+			{
+				bool inside = true;
+				for (const glm::vec4 &p : planes)
+					inside &= p.x * (p.x > 0.0f ? maxs[i].x : mins[i].x) + p.y * (p.y > 0.0f ? maxs[i].y : mins[i].y) + p.z * (p.z > 0.0f ? maxs[i].z : mins[i].z) + p.w >= 0.0f;
+				if (inside)
+					expected.push_back(i);
+			}
+		}
+		bruteFrustumMs += msSince(start);
+		std::sort(found.begin(), found.end());
+		mismatches += found != expected;
+		frustumHits += found.size();
+
+		for (int r = 0; r < Rays; r++)
+		{
+			glm::vec3 origin(queryCoordinate(queryRng), queryCoordinate(queryRng), queryCoordinate(queryRng));
+			glm::vec3 direction = glm::normalize(glm::vec3(unit(queryRng), unit(queryRng), unit(queryRng)));
+			uint32_t hit = 0;
+			float distance = 0.0f;
+			start = Clock::now();
+			bool any = scene.raycast(origin, direction, 100.0f, hit, distance);
+			rayMs += msSince(start);
+
+			start = Clock::now();
+			float best = 100.0f;
+			bool bruteAny = false;
+			for (uint32_t i = 0; i < scene.size(); i++)
+			{
+				float tNear = 0.0f, tFar = best;
+				for (int a = 0; a < 3; a++)
+				{
+					float t0 = (mins[i][a] - origin[a]) / direction[a], t1 = (maxs[i][a] - origin[a]) / direction[a];
+					tNear = std::max(tNear, std::min(t0, t1));
+					tFar = std::min(tFar, std::max(t0, t1));
+				}
+				if (tNear <= tFar && tNear < best)
+				{
+					best = tNear;
+					bruteAny = true;
+				}
+			}
+			bruteRayMs += msSince(start);
+			mismatches += any != bruteAny || (any && std::abs(distance - best) > 1e-3f);
+			rayHits += any;
+		}
+	}
+
+	// churn: remove a tenth of the objects and put them back
+	start = Clock::now();
+	for (size_t i = 0; i < count; i += 10)
+		scene.remove(handles[i]);
+	for (size_t i = 0; i < count; i += 10)
+		handles[i] = scene.insert(glm::translate(glm::mat4(1.0f), positions[i]), -halfSizes[i], halfSizes[i], (uint32_t)i);
+	double churnMs = msSince(start);
+	size_t wrongUserData = 0;
+	for (size_t i = 0; i < count; i++)
+		wrongUserData += !scene.contains(handles[i]) || scene.userData()[scene.indexOf(handles[i])] != i;
+
+	std::cout << count << " objects, " << scene.cellCount() << " cells of " << cellSize << ", " << scene.oversizedCount() << " oversized, " << frames << " frames" << std::endl;
+	std::cout << "insert all:                " << insertMs << " ms" << std::endl;
+	std::cout << "move 50% incrementally:    " << moveMs / frames << " ms/frame" << std::endl;
+	std::cout << "rebuild from scratch:      " << rebuildMs / frames << " ms/frame" << std::endl;
+	std::cout << RangeQueries << " range queries (20^3):  " << rangeMs / frames << " ms/frame vs brute force " << bruteRangeMs / frames << " ms, "
+			  << (double)rangeHits / frames / RangeQueries << " hits each" << std::endl;
+	std::cout << "frustum query:             " << frustumMs / frames << " ms/frame vs brute force " << bruteFrustumMs / frames << " ms, "
+			  << (double)frustumHits / frames << " visible" << std::endl;
+	std::cout << Rays << " raycasts (100 units):  " << rayMs / frames << " ms/frame vs brute force " << bruteRayMs / frames << " ms, "
+			  << 100.0 * rayHits / frames / Rays << "% hit" << std::endl;
+	std::cout << "remove + insert 10%:       " << churnMs << " ms" << std::endl;
+	std::cout << "mismatches against brute force: " << mismatches << ", bad handles: " << wrongUserData << std::endl;
+	return mismatches || wrongUserData ? 1 : 0;
+}
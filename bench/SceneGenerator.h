@@ -0,0 +1,175 @@
+#ifndef __SCENEGENERATOR_H__
+#define __SCENEGENERATOR_H__
+
+// Procedural scenes for the scaling benchmarks: cubes laid out over a ground plane
+// in a grid, uniformly at random or in clusters, each with one of a set of mesh
+// variants and textures. Everything comes from the seed, so runs are comparable
+// across builds.
+
+#include "glm/glm.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+enum class Distribution
+{
+	Grid,
+	Random,
+	Clustered,
+};
+
+inline const char *distributionName(Distribution d)
+{
+	return d == Distribution::Grid ? "grid" : d == Distribution::Random ? "random" : "clustered";
+}
+
+// false for an unknown name
+inline bool parseDistribution(const char *name, Distribution &d)
+{
+	for (Distribution candidate : {Distribution::Grid, Distribution::Random, Distribution::Clustered})
+		if (strcmp(name, distributionName(candidate)) == 0)
+		{
+			d = candidate;
+			return true;
+		}
+	return false;
+}
+
+struct SceneSpec
+{
+	size_t objects = 1000;
+	Distribution distribution = Distribution::Grid;
+	unsigned textures = 8;
+	unsigned meshes = 4;	   // distinct vertex buffers
+	unsigned subdivisions = 0; // each cube face is (subdivisions + 1)^2 quads
+	float spacing = 3.0f;	   // average distance between neighbours
+	uint32_t seed = 1;
+};
+
+struct GeneratedScene
+{
+	std::vector<glm::vec3> positions;
+	std::vector<float> scales;
+	std::vector<uint16_t> meshes, textures;
+	float extent = 0.0f; // grid and random scenes cover [0, extent] in x and z
+
+	size_t memoryBytes() const
+	{
+		return positions.capacity() * sizeof(glm::vec3) + scales.capacity() * sizeof(float) + (meshes.capacity() + textures.capacity()) * sizeof(uint16_t);
+	}
+};
+
+inline GeneratedScene generateScene(const SceneSpec &spec)
+{
+	GeneratedScene scene;
+	size_t n = spec.objects;
+	size_t side = (size_t)std::ceil(std::sqrt((double)n));
+	scene.extent = side * spec.spacing;
+	scene.positions.resize(n);
+	scene.scales.resize(n);
+	scene.meshes.resize(n);
+	scene.textures.resize(n);
+
+	std::mt19937 rng(spec.seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::normal_distribution<float> gaussian(0.0f, 1.0f);
+	// about a thousand objects per cluster, packed about twice as densely as on average
+	size_t clusterCount = std::max<size_t>(1, n / 1000);
+	std::vector<glm::vec3> clusters(clusterCount);
+	for (glm::vec3 &c : clusters)
+		c = glm::vec3(unit(rng) * scene.extent, 0.0f, unit(rng) * scene.extent);
+	float clusterRadius = std::sqrt((float)(n / clusterCount)) * spec.spacing / 4.0f;
+
+	for (size_t i = 0; i < n; i++)
+	{
+		glm::vec3 &p = scene.positions[i];
+		switch (spec.distribution)
+		{
+		case Distribution::Grid:
+			p = glm::vec3((i % side + 0.5f) * spec.spacing, 0.0f, (i / side + 0.5f) * spec.spacing);
+			break;
+		case Distribution::Random:
+			p = glm::vec3(unit(rng) * scene.extent, 0.0f, unit(rng) * scene.extent);
+			break;
+		case Distribution::Clustered:
+			p = clusters[i % clusterCount] + glm::vec3(gaussian(rng), 0.0f, gaussian(rng)) * clusterRadius;
+			break;
+		}
+		p.y = unit(rng) * 2.0f;
+		scene.scales[i] = 0.5f + unit(rng);
+		scene.meshes[i] = (uint16_t)(rng() % std::max(1u, spec.meshes));
+		scene.textures[i] = (uint16_t)(rng() % std::max(1u, spec.textures));
+	}
+	return scene;
+}
+
+// Unit cube with every face split into (subdivisions + 1)^2 quads, as non-indexed
+// triangles of position + texture coordinate. Each variant bulges a little
+// differently, so the vertex buffers really differ.
+inline std::vector<float> subdividedCube(unsigned subdivisions, unsigned variant)
+{
+	const int k = (int)subdivisions + 1;
+	const float bulge = 0.04f * (float)(variant % 5);
+	std::vector<float> vertices;
+	vertices.reserve((size_t)6 * k * k * 6 * 5);
+	for (int face = 0; face < 6; face++)
+	{
+		int axis = face / 2;
+		float sign = face % 2 ? 1.0f : -1.0f;
+		auto corner = [&](float u, float v)
+		{
+			glm::vec3 p;
+			p[axis] = 0.5f * sign;
+			p[(axis + 1) % 3] = (u - 0.5f) * sign;
+			p[(axis + 2) % 3] = v - 0.5f;
+			p *= 1.0f + bulge * std::sin(3.14159265f * u) * std::sin(3.14159265f * v);
+			vertices.insert(vertices.end(), {p.x, p.y, p.z, u, v});
+		};
+		for (int y = 0; y < k; y++)
+			for (int x = 0; x < k; x++)
+			{
+				float u0 = (float)x / k, u1 = (float)(x + 1) / k, v0 = (float)y / k, v1 = (float)(y + 1) / k;
+				corner(u0, v0), corner(u1, v0), corner(u1, v1);
+				corner(u0, v0), corner(u1, v1), corner(u0, v1);
+			}
+	}
+	return vertices;
+}
+
+// size x size RGBA checkerboard, the colours picked by index
+inline std::vector<uint8_t> checkerTexture(unsigned index, int size)
+{
+	std::mt19937 rng(index * 7919 + 1);
+	uint8_t a[3], b[3];
+	for (int c = 0; c < 3; c++)
+	{
+		a[c] = (uint8_t)(64 + rng() % 192);
+		b[c] = (uint8_t)(rng() % 128);
+	}
+	std::vector<uint8_t> pixels((size_t)size * size * 4);
+	for (int y = 0; y < size; y++)
+		for (int x = 0; x < size; x++)
+		{
+			const uint8_t *colour = ((x / 4) + (y / 4)) % 2 ? a : b;
+			uint8_t *p = &pixels[((size_t)y * size + x) * 4];
+			p[0] = colour[0], p[1] = colour[1], p[2] = colour[2], p[3] = 255;
+		}
+	return pixels;
+}
+
+// Scripted flight: one loop around the middle of the scene at low altitude, looking
+// ahead along the path and down at the ground
+inline void cameraPath(int frame, int frames, float extent, glm::vec3 &eye, glm::vec3 &target)
+{
+	const float TwoPi = 6.2831853f;
+	float t = TwoPi * (float)frame / (float)std::max(1, frames);
+	glm::vec3 centre(extent * 0.5f, 0.0f, extent * 0.5f);
+	float radius = std::max(extent * 0.35f, 15.0f);
+	eye = centre + glm::vec3(radius * std::cos(t), 25.0f, radius * std::sin(t));
+	target = centre + glm::vec3(radius * 0.6f * std::cos(t + 0.7f), 0.0f, radius * 0.6f * std::sin(t + 0.7f));
+}
+
+#endif
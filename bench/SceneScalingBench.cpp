@@ -0,0 +1,384 @@
+// Scaling benchmark on generated scenes: from 10 objects up by factors of ten, for
+// each distribution, builds a SceneContainer over the scene and flies a scripted
+// camera through it. Every frame frustum culls through the container, sorts what is
+// visible by texture and mesh, and draws it as instanced batches through the
+// RenderQueue, with glFinish inside the frame time. Reports build time, frame and
+// CPU time percentiles, draw calls, state changes and memory per run, and with
+// --report writes the same as JSON so runs can be compared by script. Run it with
+// LIBGL_ALWAYS_SOFTWARE=1 for the llvmpipe numbers.
+//
+// usage: SceneScalingBench [--objects N | --max N] [--distribution grid|random|clustered|all]
+//                          [--textures N] [--meshes N] [--subdivisions N] [--frames N]
+//                          [--report file.json] [--label text]
+
+#include "BenchCommon.h"
+#include "FrameTimings.h"
+#include "RenderQueue.h"
+#include "SceneContainer.h"
+#include "SceneGenerator.h"
+#include "Shader.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const char *sceneVertexShader =
+	"#version 330 core\n"
+	"layout (location = 0) in vec3 aPos;\n"
+	"layout (location = 1) in vec2 aTexCoord;\n"
+	"layout (std140) uniform Instances\n"
+	"{\n"
+	"    vec4 instances[MAX_INSTANCES];\n" // xyz position, w scale
+	"};\n"
+	"uniform mat4 viewProjection;\n"
+	"out vec2 TexCoord;\n"
+	"out float Shade;\n"
+	"void main()\n"
+	"{\n"
+	"    vec4 instance = instances[gl_InstanceID];\n"
+	"    gl_Position = viewProjection * vec4(instance.xyz + aPos * instance.w, 1.0);\n"
+	"    TexCoord = aTexCoord;\n"
+	"    Shade = 0.6 + 0.4 * clamp(aPos.y + 0.5, 0.0, 1.0);\n"
+	"}\n";
+
+static const char *sceneFragmentShader =
+	"#version 330 core\n"
+	"in vec2 TexCoord;\n"
+	"in float Shade;\n"
+	"out vec4 FragColor;\n"
+	"uniform sampler2D texture1;\n"
+	"void main()\n"
+	"{\n"
+	"    FragColor = vec4(texture(texture1, TexCoord).rgb * Shade, 1.0);\n"
+	"}\n";
+
+static const int Width = 640, Height = 360, TextureSize = 32;
+static const float FarPlane = 300.0f, CellSize = 8.0f;
+
+struct RunResult
+{
+	SceneSpec spec;
+	int frames = 0;
+	double generateMs = 0.0, buildMs = 0.0, uploadMs = 0.0;
+	FrameTimings timings;
+	double drawCalls = 0.0, stateChanges = 0.0, visible = 0.0; // per frame
+	size_t cpuBytes = 0, gpuBytes = 0;
+};
+
+// Returns false if the draws did not cover exactly the visible objects or GL reported an error
+static bool runScene(const SceneSpec &spec, int frames, GLuint program, GLint maxInstances, GLint offsetAlignment, RunResult &result)
+{
+	result.spec = spec;
+	result.frames = frames;
+
+	auto start = Clock::now();
+	GeneratedScene generated = generateScene(spec);
+	result.generateMs = elapsedMs(start);
+
+	start = Clock::now();
+	SceneContainer scene(CellSize);
+	scene.reserve(spec.objects);
+	for (size_t i = 0; i < spec.objects; i++)
+	{
+		glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), generated.positions[i]), glm::vec3(generated.scales[i]));
+		// the bulge of the mesh variants stays within 0.6
+		scene.insert(model, glm::vec3(-0.6f), glm::vec3(0.6f), (uint32_t)i);
+	}
+	result.buildMs = elapsedMs(start);
+
+	start = Clock::now();
+	RenderQueue queue;
+	unsigned programIndex = queue.registerProgram(program);
+	std::vector<GLuint> vaos(spec.meshes), vbos(spec.meshes), textures(spec.textures);
+	std::vector<GLsizei> vertexCounts(spec.meshes);
+	size_t gpuBytes = 0;
+	glGenVertexArrays(spec.meshes, vaos.data());
+	glGenBuffers(spec.meshes, vbos.data());
+	for (unsigned m = 0; m < spec.meshes; m++)
+	{
+		std::vector<float> vertices = subdividedCube(spec.subdivisions, m);
+		vertexCounts[m] = (GLsizei)(vertices.size() / 5);
+		gpuBytes += vertices.size() * sizeof(float);
+		glBindVertexArray(vaos[m]);
+		glBindBuffer(GL_ARRAY_BUFFER, vbos[m]);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+		queue.registerVertexArray(vaos[m]);
+	}
+	glGenTextures(spec.textures, textures.data());
+	for (unsigned t = 0; t < spec.textures; t++)
+	{
+		std::vector<uint8_t> pixels = checkerTexture(t, TextureSize);
+		glBindTexture(GL_TEXTURE_2D, textures[t]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TextureSize, TextureSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		gpuBytes += (size_t)TextureSize * TextureSize * 4 * 4 / 3; // mip chain included
+		TextureSet set;
+		set.units[0] = textures[t];
+		queue.registerTextureSet(set);
+	}
+	GLuint instanceBuffer;
+	glGenBuffers(1, &instanceBuffer);
+	const GLsizeiptr rangeBytes = (GLsizeiptr)maxInstances * sizeof(glm::vec4);
+	queue.setDrawUniforms(instanceBuffer, 0, rangeBytes);
+	glFinish();
+	result.uploadMs = elapsedMs(start);
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)Width / (float)Height, 0.1f, FarPlane);
+	GLint viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+	const size_t alignVec4 = std::max<size_t>(1, offsetAlignment / sizeof(glm::vec4));
+	std::vector<uint32_t> visible;
+	std::vector<uint64_t> order;
+	std::vector<glm::vec4> instances;
+	size_t largestUpload = 0;
+	bool ok = true;
+
+	// two frames to warm up the driver, not recorded
+	for (int f = -2; f < frames; f++)
+	{
+		auto frameStart = Clock::now();
+		glm::vec3 eye, target;
+		cameraPath(std::max(f, 0), frames, generated.extent, eye, target);
+		glm::mat4 viewProjection = projection * glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		visible.clear();
+		scene.queryFrustum(viewProjection, visible);
+		// texture, then mesh, then object, so equal batches end up next to each other
+		order.resize(visible.size());
+		const std::vector<uint32_t> &user = scene.userData();
+		for (size_t v = 0; v < visible.size(); v++)
+		{
+			uint32_t i = user[visible[v]];
+			order[v] = (uint64_t)generated.textures[i] << 48 | (uint64_t)generated.meshes[i] << 32 | i;
+		}
+		std::sort(order.begin(), order.end());
+
+		queue.reset();
+		instances.clear();
+		size_t submitted = 0;
+		for (size_t b = 0; b < order.size();)
+		{
+			uint64_t group = order[b] >> 32;
+			size_t e = b + 1;
+			while (e < order.size() && (order[e] >> 32) == group && e - b < (size_t)maxInstances)
+				e++;
+			instances.resize((instances.size() + alignVec4 - 1) / alignVec4 * alignVec4);
+			GLintptr offset = (GLintptr)(instances.size() * sizeof(glm::vec4));
+			for (size_t k = b; k < e; k++)
+			{
+				uint32_t i = (uint32_t)order[k];
+				instances.push_back(glm::vec4(generated.positions[i], generated.scales[i]));
+			}
+			unsigned texture = (unsigned)(group >> 16), mesh = (unsigned)(group & 0xffff);
+			queue.submit({SortKey::make(0, programIndex, texture, mesh, 0), 0, vertexCounts[mesh], glm::mat4(1.0f), (GLsizei)(e - b), offset});
+			submitted += e - b;
+			b = e;
+		}
+		if (submitted != visible.size())
+			ok = false;
+
+		// orphan and refill, padded so the last batch can still bind a full range
+		size_t uploadBytes = instances.size() * sizeof(glm::vec4) + rangeBytes;
+		largestUpload = std::max(largestUpload, uploadBytes);
+		glBindBuffer(GL_UNIFORM_BUFFER, instanceBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, uploadBytes, NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, instances.size() * sizeof(glm::vec4), instances.data());
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glUseProgram(program);
+		glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+		queue.sort();
+		RenderQueueStats stats = queue.execute();
+		double cpuMs = elapsedMs(frameStart);
+		glFinish();
+		if (f < 0)
+			continue;
+		result.timings.add(elapsedMs(frameStart), cpuMs);
+		result.drawCalls += stats.draws;
+		result.stateChanges += stats.stateChanges();
+		result.visible += visible.size();
+	}
+	if (frames > 0)
+	{
+		result.drawCalls /= frames;
+		result.stateChanges /= frames;
+		result.visible /= frames;
+	}
+	result.cpuBytes = scene.memoryBytes() + generated.memoryBytes() + visible.capacity() * sizeof(uint32_t) +
+					  order.capacity() * sizeof(uint64_t) + instances.capacity() * sizeof(glm::vec4);
+	result.gpuBytes = gpuBytes + largestUpload;
+
+	GLenum error = glGetError();
+	if (error != GL_NO_ERROR)
+	{
+		std::cout << "ERROR::SCENESCALING::GL_ERROR 0x" << std::hex << error << std::dec << std::endl;
+		ok = false;
+	}
+	glDeleteBuffers(1, &instanceBuffer);
+	glDeleteTextures(spec.textures, textures.data());
+	glDeleteBuffers(spec.meshes, vbos.data());
+	glDeleteVertexArrays(spec.meshes, vaos.data());
+	return ok;
+}
+
+static void writeSummary(std::ofstream &out, const char *name, const FrameTimings::Summary &s)
+{
+	out << "\"" << name << "\": {\"mean\": " << s.mean << ", \"stddev\": " << s.stddev << ", \"p50\": " << s.p50
+		<< ", \"p95\": " << s.p95 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max << "}";
+}
+
+static std::string escape(const std::string &text)
+{
+	std::string out;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+			out += '\\';
+		if ((unsigned char)c >= 0x20)
+			out += c;
+	}
+	return out;
+}
+
+static bool writeReport(const std::string &path, const std::string &label, const std::string &renderer, const std::vector<RunResult> &runs)
+{
+	std::ofstream out(path);
+	out << "{\n  \"label\": \"" << escape(label) << "\",\n  \"renderer\": \"" << escape(renderer) << "\",\n";
+	out << "  \"width\": " << Width << ", \"height\": " << Height << ",\n  \"runs\": [";
+	for (size_t r = 0; r < runs.size(); r++)
+	{
+		const RunResult &run = runs[r];
+		out << (r ? ",\n" : "\n") << "    {\"objects\": " << run.spec.objects << ", \"distribution\": \"" << distributionName(run.spec.distribution)
+			<< "\", \"textures\": " << run.spec.textures << ", \"meshes\": " << run.spec.meshes << ", \"subdivisions\": " << run.spec.subdivisions
+			<< ", \"frames\": " << run.frames << ",\n     \"generate_ms\": " << run.generateMs << ", \"build_ms\": " << run.buildMs
+			<< ", \"upload_ms\": " << run.uploadMs << ",\n     ";
+		writeSummary(out, "frame_ms", run.timings.frameSummary());
+		out << ",\n     ";
+		writeSummary(out, "cpu_ms", run.timings.cpuSummary());
+		out << ",\n     \"visible\": " << run.visible << ", \"draw_calls\": " << run.drawCalls << ", \"state_changes\": " << run.stateChanges
+			<< ", \"cpu_bytes\": " << run.cpuBytes << ", \"gpu_bytes\": " << run.gpuBytes << "}";
+	}
+	out << "\n  ]\n}\n";
+	if (!out)
+		std::cout << "ERROR::SCENESCALING::REPORT_WRITE_FAILED " << path << std::endl;
+	return (bool)out;
+}
+
+int main(int argc, char **argv)
+{
+	size_t objects = 0, maxObjects = 1000000;
+	int frames = 30;
+	SceneSpec base;
+	base.textures = 16;
+	base.meshes = 8;
+	std::string distributions = "all", reportPath, label = "scene-scaling";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--objects") == 0)
+			objects = (size_t)atoll(argv[i + 1]);
+		else if (strcmp(argv[i], "--max") == 0)
+			maxObjects = (size_t)atoll(argv[i + 1]);
+		else if (strcmp(argv[i], "--distribution") == 0)
+			distributions = argv[i + 1];
+		else if (strcmp(argv[i], "--textures") == 0)
+			base.textures = (unsigned)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--meshes") == 0)
+			base.meshes = (unsigned)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--subdivisions") == 0)
+			base.subdivisions = (unsigned)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--frames") == 0)
+			frames = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--report") == 0)
+			reportPath = argv[i + 1];
+		else if (strcmp(argv[i], "--label") == 0)
+			label = argv[i + 1];
+		else
+			std::cout << "unknown option " << argv[i] << std::endl;
+	}
+	// what the sort key has room for
+	base.textures = std::clamp(base.textures, 1u, (unsigned)SortKey::mask(SortKey::TextureBits));
+	base.meshes = std::clamp(base.meshes, 1u, (unsigned)SortKey::mask(SortKey::VaoBits));
+
+	std::vector<Distribution> runDistributions;
+	Distribution d;
+	if (distributions == "all")
+		runDistributions = {Distribution::Grid, Distribution::Random, Distribution::Clustered};
+	else if (parseDistribution(distributions.c_str(), d))
+		runDistributions = {d};
+	else
+	{
+		std::cout << "ERROR::SCENESCALING::UNKNOWN_DISTRIBUTION " << distributions << std::endl;
+		return 1;
+	}
+	std::vector<size_t> counts;
+	if (objects)
+		counts = {objects};
+	else
+		for (size_t n = 10; n <= maxObjects; n *= 10)
+			counts.push_back(n);
+
+	GLFWwindow *window = createHiddenContext("SceneScalingBench", Width, Height);
+	if (window == NULL)
+		return 1;
+	std::string renderer = (const char *)glGetString(GL_RENDERER);
+
+	GLint blockSize = 0, offsetAlignment = 256;
+	glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &blockSize);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	GLint maxInstances = std::min(blockSize, 65536) / (GLint)sizeof(glm::vec4);
+	std::string vertexSource = Shader::injectDefines(sceneVertexShader, "#define MAX_INSTANCES " + std::to_string(maxInstances) + "\n");
+	GLuint program = Shader::link(vertexSource.c_str(), sceneFragmentShader);
+	glUseProgram(program);
+	glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Instances"), 0);
+	glUniform1i(glGetUniformLocation(program, "texture1"), 0);
+
+	glViewport(0, 0, Width, Height);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_CULL_FACE);
+	glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
+
+	std::cout << "up to " << maxInstances << " instances per draw, " << frames << " frames per run" << std::endl;
+	std::cout << "objects   distribution  build ms  frame p50/p95/p99 ms      cpu p50 ms  visible   draws  changes  cpu MB   gpu MB" << std::endl;
+	std::vector<RunResult> runs;
+	bool ok = true;
+	for (size_t n : counts)
+		for (Distribution distribution : runDistributions)
+		{
+			SceneSpec spec = base;
+			spec.objects = n;
+			spec.distribution = distribution;
+			RunResult run;
+			if (!runScene(spec, frames, program, maxInstances, offsetAlignment, run))
+			{
+				std::cout << "ERROR::SCENESCALING::DRAWS_DO_NOT_MATCH_VISIBLE " << n << " " << distributionName(distribution) << std::endl;
+				ok = false;
+			}
+			FrameTimings::Summary f = run.timings.frameSummary(), c = run.timings.cpuSummary();
+			printf("%-9zu %-13s %8.1f  %6.2f / %6.2f / %6.2f  %10.2f  %7.0f  %6.0f  %7.0f  %6.1f  %7.1f\n", n, distributionName(distribution),
+				   run.buildMs, f.p50, f.p95, f.p99, c.p50, run.visible, run.drawCalls, run.stateChanges, run.cpuBytes / 1048576.0, run.gpuBytes / 1048576.0);
+			fflush(stdout);
+			runs.push_back(std::move(run));
+		}
+
+	if (!reportPath.empty() && !writeReport(reportPath, label, renderer, runs))
+		ok = false;
+	glDeleteProgram(program);
+	glfwTerminate();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Shader cache benchmark: startup cost of building lessonshader's MVP variant and
+// 200 synthetic programs with a cold (empty) and a warm program binary cache.
+//
+// usage: ShaderCacheBench [shader directory, default src/shaders/]
+// Set MESA_SHADER_CACHE_DISABLE=true on Mesa, otherwise its own cache hides the cold cost.
+
+#include "BenchCommon.h"
+
+#include "ShaderCache.h"
+#include "ShaderPermutations.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+template <typename F>
+static double timeMs(F &&fn)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	fn();
+	glFinish();
+	auto t1 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = argc > 1 ? argv[1] : "src/shaders/";
+
+	GLFWwindow *window = createHiddenContext("ShaderCacheBench");
+	if (window == NULL)
+		return -1;
+
+	ShaderCache cache("shadercache_bench");
+	if (!cache.enabled())
+	{
+		std::cout << "GL_ARB_get_program_binary not available, nothing to measure" << std::endl;
+		glfwTerminate();
+		return 0;
+	}
+	cache.clear();
+
+	// the variant the old coordinateshader pair was
+	const std::string mvp = "#define MVP 1\n";
+	std::string vertexCode = ShaderPreprocessor::process(shaderDir + "lessonshader.vs").source;
+	std::string fragCode = ShaderPreprocessor::process(shaderDir + "lessonshader.fs").source;
+	std::string syntheticVs = syntheticVertexShader(), syntheticFs = syntheticFragmentShader();
+
+	auto buildAll = [&](bool synthetic)
+	{
+		std::vector<unsigned int> programs;
+		if (!synthetic)
+			programs.push_back(cache.program(vertexCode, fragCode, mvp));
+		else
+			for (int i = 0; i < 200; i++)
+				programs.push_back(cache.program(syntheticVs, syntheticFs, syntheticDefines(i)));
+		for (unsigned int p : programs)
+			glDeleteProgram(p);
+	};
+
+	double uncachedPair = timeMs([&]
+								 { glDeleteProgram(Shader::link(Shader::injectDefines(vertexCode, mvp).c_str(), Shader::injectDefines(fragCode, mvp).c_str())); });
+	double coldPair = timeMs([&]
+							 { buildAll(false); });
+	double warmPair = timeMs([&]
+							 { buildAll(false); });
+	double cold200 = timeMs([&]
+							{ buildAll(true); });
+	double warm200 = timeMs([&]
+							{ buildAll(true); });
+
+	std::cout << "lessonshader MVP, no cache:  " << uncachedPair << " ms" << std::endl;
+	std::cout << "lessonshader MVP, cold:      " << coldPair << " ms" << std::endl;
+	std::cout << "lessonshader MVP, warm:      " << warmPair << " ms" << std::endl;
+	std::cout << "200 programs, cold:          " << cold200 << " ms" << std::endl;
+	std::cout << "200 programs, warm:          " << warm200 << " ms" << std::endl;
+	std::cout << "hits " << cache.stats().hits << ", misses " << cache.stats().misses << ", rejected " << cache.stats().rejected << std::endl;
+
+	cache.clear();
+	glfwTerminate();
+	return 0;
+}
@@ -0,0 +1,77 @@
+// Shader permutation benchmark on lessonshader: what startup costs when only the
+// variants a scene references are built (ShaderPermutations compiles on first
+// get()) against building every combination of its permutations up front, and
+// the cost of get() once a variant exists. Every variant is checked to link.
+//
+// usage: ShaderPermutationBench [shader directory, default src/shaders/] [lookups]
+// Set MESA_SHADER_CACHE_DISABLE=true on Mesa so every run really compiles.
+
+#include "BenchCommon.h"
+
+#include "ShaderPermutations.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv)
+{
+	std::string shaderDir = argc > 1 ? argv[1] : "src/shaders/";
+	const int lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+	std::string vs = shaderDir + "lessonshader.vs", fs = shaderDir + "lessonshader.fs";
+
+	GLFWwindow *window = createHiddenContext("ShaderPermutationBench");
+	if (window == NULL)
+		return -1;
+
+	// the first compile pays for driver start up, keep that out of both numbers
+	std::string warmVs = Shader::injectDefines(syntheticVertexShader(), syntheticDefines(0));
+	std::string warmFs = Shader::injectDefines(syntheticFragmentShader(), syntheticDefines(0));
+	glDeleteProgram(Shader::link(warmVs.c_str(), warmFs.c_str()));
+
+	// lazy: the scene only draws the textured 3D cube, the MVP variant
+	auto t0 = std::chrono::steady_clock::now();
+	ShaderPermutations lazy(vs.c_str(), fs.c_str());
+	double preprocessMs = elapsedMs(t0);
+	size_t compiledAtStartup = lazy.compiled();
+	ShaderPermutations::Key mvp = lazy.key({"MVP"});
+	t0 = std::chrono::steady_clock::now();
+	GLuint used = lazy.get(mvp).ID;
+	glFinish();
+	double lazyMs = preprocessMs + elapsedMs(t0);
+
+	// eager: every combination, as a build without permutations would have to ship
+	t0 = std::chrono::steady_clock::now();
+	ShaderPermutations eager(vs.c_str(), fs.c_str());
+	const ShaderPermutations::Key all = ShaderPermutations::Key(1) << eager.permutations().size();
+	for (ShaderPermutations::Key k = 0; k < all; k++)
+		eager.get(k);
+	glFinish();
+	double eagerMs = elapsedMs(t0);
+
+	size_t failed = 0;
+	for (ShaderPermutations::Key k = 0; k < all; k++)
+	{
+		int linked = 0;
+		glGetProgramiv(eager.get(k).ID, GL_LINK_STATUS, &linked);
+		failed += !linked;
+	}
+
+	// draw time lookups of a variant that already exists
+	t0 = std::chrono::steady_clock::now();
+	GLuint sum = 0;
+	for (int i = 0; i < lookups; i++)
+		sum += lazy.get(mvp).ID;
+	double lookupNs = elapsedMs(t0) * 1e6 / lookups;
+
+	std::cout << eager.permutations().size() << " permutations, " << all << " variants" << std::endl;
+	std::cout << "preprocess (#include, #pragma): " << preprocessMs << " ms, " << compiledAtStartup << " programs compiled" << std::endl;
+	std::cout << "startup, referenced only:       " << lazyMs << " ms, " << lazy.compiled() << " program" << std::endl;
+	std::cout << "startup, every variant:         " << eagerMs << " ms, " << eager.compiled() << " programs" << std::endl;
+	std::cout << "get() of a built variant:       " << lookupNs << " ns" << (sum == used * (GLuint)lookups ? "" : " (wrong program)") << std::endl;
+	std::cout << "failed to link:                 " << failed << std::endl;
+
+	glfwTerminate();
+	return failed || compiledAtStartup != 0 || lazy.compiled() != 1 ? 1 : 0;
+}
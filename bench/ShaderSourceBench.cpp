@@ -0,0 +1,147 @@
+// Shader source loading benchmark: reading the sources of N programs as loose
+// files (Shader::readFile, one open and copy per file, what ShaderCache::load does)
+// vs mapping each file (MappedFile) vs one ShaderArchive mapping with every source
+// looked up by name, which is how main loads shaders.pack. Timed with the files in the page cache and, on Linux, after
+// dropping them from it. Every method is checked to see the same bytes.
+//
+// usage: ShaderSourceBench [programs] [repeats]
+
+#include "ShaderSource.h"
+
+#include "BenchCommon.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Asks the kernel to forget the cached pages of path, so the next read goes to disk
+static void dropFromPageCache(const std::string &path)
+{
+#ifdef __linux__
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		fdatasync(fd);
+		posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+#else
+	(void)path;
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	const int programCount = argc > 1 ? atoi(argv[1]) : 200;
+	const int repeats = argc > 2 ? atoi(argv[2]) : 20;
+
+	// a shader directory like a game's: programCount vertex/fragment pairs
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "shadersource_bench";
+	std::filesystem::remove_all(dir);
+	std::filesystem::create_directories(dir);
+	std::vector<std::string> names, files;
+	for (int i = 0; i < programCount; i++)
+		for (const char *stage : {".vs", ".fs"})
+		{
+			std::string name = "program" + std::to_string(i) + stage;
+			std::string code = Shader::injectDefines(stage[1] == 'v' ? syntheticVertexShader() : syntheticFragmentShader(), syntheticDefines(i));
+			std::ofstream((dir / name).string(), std::ios::binary) << code;
+			names.push_back(name);
+			files.push_back((dir / name).string());
+		}
+	std::string pack = (dir / "shaders.pack").string();
+	if (!ShaderArchive::write(pack, dir.string(), files))
+	{
+		std::cout << "ERROR::SHADERSOURCE::PACK_FAILED " << pack << std::endl;
+		return 1;
+	}
+
+	// each method returns a checksum of the bytes it saw, so nothing is optimised away
+	auto checksum = [](const char *data, size_t size)
+	{
+		size_t sum = size;
+		for (size_t i = 0; i < size; i += 64)
+			sum = sum * 31 + (unsigned char)data[i];
+		return sum;
+	};
+	auto readFiles = [&]()
+	{
+		size_t sum = 0;
+		for (const std::string &file : files)
+		{
+			std::string code = Shader::readFile(file.c_str());
+			sum += checksum(code.data(), code.size());
+		}
+		return sum;
+	};
+	auto mapFiles = [&]()
+	{
+		size_t sum = 0;
+		for (const std::string &file : files)
+		{
+			MappedFile mapped(file.c_str());
+			sum += checksum(mapped.data(), mapped.size());
+		}
+		return sum;
+	};
+	auto archive = [&]()
+	{
+		size_t sum = 0;
+		ShaderArchive archive(pack.c_str());
+		for (const std::string &name : names)
+		{
+			std::string_view code = archive.find(name);
+			sum += checksum(code.data(), code.size());
+		}
+		return sum;
+	};
+
+	struct Method
+	{
+		const char *name;
+		std::function<size_t()> run;
+		size_t sum = 0;
+		double warmMs = 1e30, coldMs = 1e30;
+	};
+	Method methods[] = {{"Shader::readFile", readFiles}, {"MappedFile", mapFiles}, {"ShaderArchive", archive}};
+	for (int r = 0; r < repeats; r++)
+		for (Method &m : methods)
+		{
+			for (const std::string &file : files)
+				dropFromPageCache(file);
+			dropFromPageCache(pack);
+			auto t0 = std::chrono::steady_clock::now();
+			m.sum = m.run();
+			m.coldMs = std::min(m.coldMs, elapsedMs(t0));
+
+			t0 = std::chrono::steady_clock::now();
+			m.run();
+			m.warmMs = std::min(m.warmMs, elapsedMs(t0));
+		}
+
+	bool ok = true;
+	std::cout << programCount << " programs, " << files.size() << " sources (best of " << repeats << ")" << std::endl;
+	std::cout << "                  page cache   dropped from it" << std::endl;
+	for (const Method &m : methods)
+	{
+		printf("%-16s  %7.3f ms   %7.3f ms\n", m.name, m.warmMs, m.coldMs);
+		if (m.sum != methods[0].sum)
+		{
+			std::cout << "ERROR::SHADERSOURCE::CONTENT_MISMATCH " << m.name << std::endl;
+			ok = false;
+		}
+	}
+	std::filesystem::remove_all(dir);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// TransformHierarchy on N nodes split into objects of about 100 nodes (random trees,
+// so depths vary), with a fraction of the nodes given a new local matrix every frame.
+// Compares recomputing every world matrix from scratch, the way main.cpp builds its
+// model matrices, against the dense and sparse dirty propagation, serial and through
+// JobSystem. Every frame all world matrices are checked against the from-scratch ones.
+//
+// usage: TransformHierarchyBench [nodes] [frames] [changed fraction] [threads]
+
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+int main(int argc, char **argv)
+{
+	const size_t count = argc > 1 ? (size_t)atoll(argv[1]) : 1000000;
+	const int frames = argc > 2 ? atoi(argv[2]) : 20;
+	const double changed = argc > 3 ? atof(argv[3]) : 0.01;
+	const unsigned threads = argc > 4 ? (unsigned)atoi(argv[4]) : 0;
+	const size_t ObjectSize = 100;
+
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> pos(-500.0f, 500.0f), offset(-1.0f, 1.0f);
+	std::vector<TransformHierarchy::Node> parents(count);
+	std::vector<glm::mat4> locals(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t k = i % ObjectSize;
+		if (k == 0)
+		{
+			parents[i] = TransformHierarchy::NoParent;
+			locals[i] = glm::translate(glm::mat4(1.0f), glm::vec3(pos(rng), pos(rng), pos(rng)));
+		}
+		else
+		{
+			parents[i] = (TransformHierarchy::Node)(i - k + std::uniform_int_distribution<size_t>(0, k - 1)(rng));
+			locals[i] = glm::translate(glm::mat4(1.0f), glm::vec3(offset(rng), offset(rng), offset(rng)));
+		}
+	}
+
+	// serial and JobSystem copies get the same changes
+	TransformHierarchy serial, parallel;
+	for (size_t i = 0; i < count; i++)
+	{
+		serial.add(locals[i], parents[i]);
+		parallel.add(locals[i], parents[i]);
+	}
+	JobSystem jobs(threads);
+	auto start = Clock::now();
+	serial.update();
+	double sortMs = msSince(start);
+	parallel.update(jobs);
+
+	std::vector<glm::mat4> reference(count);
+	double scratchMs = 0.0, ms[2][2] = {}; // [dense, sparse][serial, jobs]
+	size_t updated[2] = {}, mismatches = 0;
+	const size_t changes = (size_t)(count * changed);
+	std::uniform_int_distribution<size_t> node(0, count - 1);
+
+	for (int f = 0; f < frames; f++)
+	{
+		for (size_t c = 0; c < changes; c++)
+		{
+			size_t i = node(rng);
+			locals[i] = glm::rotate(locals[i], 0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+			serial.setLocal((TransformHierarchy::Node)i, locals[i]);
+			parallel.setLocal((TransformHierarchy::Node)i, locals[i]);
+		}
+
+		start = Clock::now();
+		for (size_t i = 0; i < count; i++)
+			reference[i] = parents[i] == TransformHierarchy::NoParent ? locals[i] : reference[parents[i]] * locals[i];
+		scratchMs += msSince(start);
+
+		// dense and sparse take turns
+		int sparse = f & 1;
+		TransformHierarchy::Propagation mode = sparse ? TransformHierarchy::Propagation::Sparse : TransformHierarchy::Propagation::Dense;
+		serial.setPropagation(mode);
+		parallel.setPropagation(mode);
+		start = Clock::now();
+		serial.update();
+		ms[sparse][0] += msSince(start);
+		start = Clock::now();
+		parallel.update(jobs);
+		ms[sparse][1] += msSince(start);
+		updated[sparse] += serial.lastUpdated();
+		mismatches += serial.lastUpdated() != parallel.lastUpdated();
+
+		for (TransformHierarchy *hierarchy : {&serial, &parallel})
+		{
+			const std::vector<glm::mat4> &worlds = hierarchy->worldMatrices();
+			for (size_t i = 0; i < count; i++)
+				mismatches += worlds[hierarchy->indexOf((TransformHierarchy::Node)i)] != reference[i];
+		}
+	}
+
+	int denseFrames = frames / 2 + frames % 2, sparseFrames = std::max(1, frames / 2);
+	std::cout << count << " nodes, " << serial.depth() << " levels, " << changes << " changed per frame, " << jobs.threadCount() << " worker threads, "
+			  << frames << " frames" << std::endl;
+	std::cout << "breadth-first sort:         " << sortMs << " ms (first update included)" << std::endl;
+	std::cout << "recompute all from scratch: " << scratchMs / frames << " ms/frame" << std::endl;
+	std::cout << "dense dirty pass:           " << ms[0][0] / denseFrames << " ms/frame serial, " << ms[0][1] / denseFrames << " with JobSystem, "
+			  << (double)updated[0] / denseFrames << " nodes recomputed" << std::endl;
+	std::cout << "sparse changed subtrees:    " << ms[1][0] / sparseFrames << " ms/frame serial, " << ms[1][1] / sparseFrames << " with JobSystem, "
+			  << (double)updated[1] / sparseFrames << " nodes recomputed" << std::endl;
+	std::cout << "mismatches against from scratch: " << mismatches << std::endl;
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+// The cost of large world precision: throughput of the batched toCameraRelative pass
+// per instruction set, positions up to 1e6 units out, against a plain glm loop. The
+// precision itself is checked by tools/WorldPrecision, which CTest runs.
+// Exits non-zero if any instruction set disagrees with the glm loop.
+//
+// usage: WorldPositionBench [positions] [repeats]
+
+#include "WorldPositions.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char **argv)
+{
+	const size_t count = argc > 1 ? (size_t)atoll(argv[1]) : 1000000;
+	const int repeats = argc > 2 ? atoi(argv[2]) : 20;
+	const double Far = 1e6;
+	bool failed = false;
+
+	// throughput of the conversion pass
+	{
+		std::mt19937 rng(3);
+		std::uniform_real_distribution<double> coordinate(-Far, Far);
+		std::vector<glm::dvec3> aos(count);
+		for (glm::dvec3 &p : aos)
+			p = glm::dvec3(coordinate(rng), coordinate(rng) * 0.01, coordinate(rng));
+		glm::dvec3 cameraPosition(Far * 0.5, 10.0, -Far * 0.25);
+
+		auto best = [&](auto &&fn)
+		{
+			double ms = 1e30;
+			for (int r = 0; r < repeats; r++)
+			{
+				auto t0 = Clock::now();
+				fn();
+				ms = std::min(ms, std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+			}
+			return ms;
+		};
+
+		std::vector<glm::vec3> expected(count), offsets(count);
+		double naiveMs = best([&]
+							  { for (size_t i = 0; i < count; i++) expected[i] = glm::vec3(aos[i] - cameraPosition); });
+		std::cout << count << " positions to camera relative floats, best of " << repeats << ":" << std::endl;
+		std::cout << "  glm, dvec3 array:       " << naiveMs << " ms, " << count / naiveMs / 1e3 << " M/s" << std::endl;
+
+		const char *names[3] = {"scalar", "SSE4.1", "AVX2"};
+		std::vector<glm::mat4> models(count, glm::mat4(1.0f));
+		for (MatrixKernels::Isa isa : {MatrixKernels::Isa::Scalar, MatrixKernels::Isa::SSE41, MatrixKernels::Isa::AVX2})
+		{
+			WorldPositions world(isa);
+			world.reserve(count);
+			for (const glm::dvec3 &p : aos)
+				world.add(p);
+			double vec3Ms = best([&]
+								 { world.toCameraRelative(cameraPosition, offsets.data()); });
+			double mat4Ms = best([&]
+								 { world.toCameraRelative(cameraPosition, models.data()); });
+			size_t wrong = 0;
+			for (size_t i = 0; i < count; i++)
+				wrong += offsets[i] != expected[i] || glm::vec3(models[i][3]) != expected[i] || models[i][3][3] != 1.0f;
+			failed |= wrong != 0;
+			std::cout << "  WorldPositions, " << names[(int)isa] << ": " << vec3Ms << " ms to vec3 (" << count / vec3Ms / 1e3 << " M/s), "
+					  << mat4Ms << " ms into mat4 translations, " << wrong << " wrong" << std::endl;
+		}
+	}
+	return failed ? 1 : 0;
+}
@@ -17,7 +17,8 @@ enum Camera_Movement
 class Camera
 {
 public:
-    glm::vec3 Position;
+    // double, so movement far from the origin still adds up; see GetRelativeViewMatrix
+    glm::dvec3 Position;
     glm::vec3 Front;
     glm::vec3 Up;
     glm::vec3 Right;
@@ -31,7 +32,7 @@ public:
     float Zoom;
 
     // constructor with vectors
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = -90.0f, float pitch = 0.0f) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MoveSpeed(2.5f), Sensitivity(0.1f), Zoom(45.0f)
+    Camera(glm::dvec3 position = glm::dvec3(0.0, 0.0, 0.0), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = -90.0f, float pitch = 0.0f) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MoveSpeed(2.5f), Sensitivity(0.1f), Zoom(45.0f)
     {
         Position = position;
         WorldUp = up;
@@ -43,16 +44,25 @@ public:
     // constructor with scalar values
     Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MoveSpeed(2.5f), Sensitivity(0.1f), Zoom(45.0f)
     {
-        Position = glm::vec3(posX, posY, posZ);
+        Position = glm::dvec3(posX, posY, posZ);
         WorldUp = glm::vec3(upX, upY, upZ);
         Yaw = yaw;
         Pitch = pitch;
         updateCameraVectors();
     }
 
+    // For world space positions. Built in double, but the float result still loses
+    // precision when the camera is far from the origin.
     glm::mat4 GetViewMatrix()
     {
-        return glm::lookAt(Position, Position + Front, Up);
+        return glm::mat4(glm::lookAt(Position, Position + glm::dvec3(Front), glm::dvec3(Up)));
+    }
+
+    // The view with the camera at the origin, for positions relative to the camera
+    // (WorldPositions::toCameraRelative). Exact at any distance from the world origin.
+    glm::mat4 GetRelativeViewMatrix()
+    {
+        return glm::lookAt(glm::vec3(0.0f), Front, Up);
     }
 
     // processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
@@ -68,15 +78,15 @@ public:
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, float deltaTime)
     {
-        float velocity = MoveSpeed * deltaTime;
+        double velocity = (double)MoveSpeed * deltaTime;
         if (direction == FORWARD)
-            Position += Front * velocity;
+            Position += glm::dvec3(Front) * velocity;
         if (direction == BACKWARD)
-            Position -= Front * velocity;
+            Position -= glm::dvec3(Front) * velocity;
         if (direction == LEFT)
-            Position -= Right * velocity;
+            Position -= glm::dvec3(Right) * velocity;
         if (direction == RIGHT)
-            Position += Right * velocity;
+            Position += glm::dvec3(Right) * velocity;
     }
 
     // processes input received from a mouse input system. Expects the offset value in both the x and y direction.
@@ -0,0 +1,70 @@
+#ifndef __CPUFEATURES_H__
+#define __CPUFEATURES_H__
+
+// Runtime CPU feature checks, so SIMD kernels can be compiled into every build
+// and picked at startup instead of requiring -mavx2 for the whole project.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEARNOPENGL_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Marks a function as allowed to use AVX2/FMA instructions. MSVC lets any
+// function use intrinsics, GCC and Clang need the target attribute.
+#if defined(LEARNOPENGL_X86) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE41
+#endif
+
+namespace CpuFeatures
+{
+    struct Flags
+    {
+        bool sse41 = false;
+        bool avx2 = false;
+        bool fma = false;
+    };
+
+    inline Flags detect()
+    {
+        Flags flags;
+#if defined(LEARNOPENGL_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        flags.sse41 = (info[2] & (1 << 19)) != 0;
+        flags.fma = (info[2] & (1 << 12)) != 0;
+        bool osSavesYmm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 0x6) == 0x6);
+        if (maxLeaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            flags.avx2 = osSavesYmm && (info[1] & (1 << 5)) != 0;
+        }
+#elif defined(LEARNOPENGL_X86)
+        __builtin_cpu_init();
+        flags.sse41 = __builtin_cpu_supports("sse4.1");
+        flags.avx2 = __builtin_cpu_supports("avx2");
+        flags.fma = __builtin_cpu_supports("fma");
+#endif
+        return flags;
+    }
+
+    // Detected once, on first use
+    inline const Flags &get()
+    {
+        static const Flags flags = detect();
+        return flags;
+    }
+
+    inline bool hasAVX2() { return get().avx2 && get().fma; }
+    inline bool hasSSE41() { return get().sse41; }
+}
+
+#endif
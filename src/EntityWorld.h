@@ -0,0 +1,401 @@
+#ifndef __ENTITYWORLD_H__
+#define __ENTITYWORLD_H__
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Stable reference to an entity. The generation changes when the index is reused,
+// so a handle to a destroyed entity never reaches its successor.
+struct Entity
+{
+    uint32_t index = ~0u;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+// Archetype based entity storage. Entities with the same set of components share
+// an archetype, whose data lives in 16 KB chunks laid out column by column: all
+// the first components of the chunk, then all the second ones, and so on, plus a
+// column of entity handles. Iterating one component therefore reads contiguous
+// memory and never pulls in the others.
+//
+// Components must be trivially copyable, they are moved between chunks and
+// archetypes with memcpy. Adding or removing a component moves the entity to
+// another archetype. Destroying one moves the archetype's last entity into the hole,
+// so chunks stay packed and only the last one of each archetype is partly filled.
+class EntityWorld
+{
+public:
+    static constexpr size_t ChunkSize = 16 * 1024;
+    static constexpr size_t MaxComponents = 64;
+
+    EntityWorld() = default;
+    EntityWorld(const EntityWorld &) = delete;
+    EntityWorld &operator=(const EntityWorld &) = delete;
+
+    template <typename... Components>
+    Entity create(const Components &...components)
+    {
+        uint32_t index;
+        if (!freeIndices.empty())
+        {
+            index = freeIndices.back();
+            freeIndices.pop_back();
+        }
+        else
+        {
+            index = (uint32_t)records.size();
+            records.emplace_back();
+        }
+        Entity entity{index, records[index].generation};
+        Archetype &archetype = archetypeFor(maskOf<Components...>());
+        Location location = appendRow(archetype, entity);
+        (writeComponent(archetype, location, components), ...);
+        records[index].archetype = archetype.index;
+        records[index].chunk = location.chunk;
+        records[index].row = location.row;
+        entityCount++;
+        return entity;
+    }
+
+    bool alive(Entity entity) const
+    {
+        return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+               records[entity.index].archetype != NoArchetype;
+    }
+
+    void destroy(Entity entity)
+    {
+        if (!alive(entity))
+            return;
+        Record &record = records[entity.index];
+        removeRow(*archetypes[record.archetype], {record.chunk, record.row});
+        record.archetype = NoArchetype;
+        record.generation++;
+        freeIndices.push_back(entity.index);
+        entityCount--;
+    }
+
+    template <typename T>
+    bool has(Entity entity) const
+    {
+        return alive(entity) && (archetypes[records[entity.index].archetype]->mask & bit<T>());
+    }
+
+    // NULL when the entity is gone or lacks the component. The pointer is valid
+    // until the next structural change (create, destroy, add, remove).
+    template <typename T>
+    T *get(Entity entity)
+    {
+        if (!has<T>(entity))
+            return nullptr;
+        const Record &record = records[entity.index];
+        Archetype &archetype = *archetypes[record.archetype];
+        return column<T>(archetype, record.chunk) + record.row;
+    }
+
+    template <typename T>
+    void add(Entity entity, const T &component)
+    {
+        if (!alive(entity))
+            return;
+        if (T *existing = get<T>(entity))
+        {
+            *existing = component;
+            return;
+        }
+        Location location = migrate(entity, archetypes[records[entity.index].archetype]->mask | bit<T>());
+        Record &record = records[entity.index];
+        writeComponent(*archetypes[record.archetype], location, component);
+    }
+
+    template <typename T>
+    void remove(Entity entity)
+    {
+        if (has<T>(entity))
+            migrate(entity, archetypes[records[entity.index].archetype]->mask & ~bit<T>());
+    }
+
+    size_t size() const { return entityCount; }
+    size_t archetypeCount() const { return archetypes.size(); }
+
+    // Calls fn(count, Components *...) once per chunk holding all of Components, the
+    // pointers being the chunk's columns. The tightest loop, and the easiest for the
+    // compiler to vectorise.
+    template <typename... Components, typename F>
+    void forEachChunk(F &&fn)
+    {
+        uint64_t mask = maskOf<Components...>();
+        for (auto &archetype : archetypes)
+            if ((archetype->mask & mask) == mask)
+                for (size_t c = 0; c < archetype->chunks.size(); c++)
+                    fn((size_t)archetype->chunks[c]->count, column<Components>(*archetype, c)...);
+    }
+
+    // Calls fn(Components &...) for every entity holding all of Components
+    template <typename... Components, typename F>
+    void each(F &&fn)
+    {
+        forEachChunk<Components...>([&](size_t count, Components *...columns)
+                                    {
+            for (size_t i = 0; i < count; i++)
+                fn(columns[i]...); });
+    }
+
+    // forEachChunk spread over the job system, chunksPerJob chunks per job.
+    // fn runs concurrently and must only touch the chunk it is given.
+    template <typename... Components, typename F>
+    void parallelForEachChunk(JobSystem &jobs, F &&fn, size_t chunksPerJob = 8)
+    {
+        uint64_t mask = maskOf<Components...>();
+        matchingChunks.clear();
+        for (auto &archetype : archetypes)
+            if ((archetype->mask & mask) == mask)
+                for (size_t c = 0; c < archetype->chunks.size(); c++)
+                    matchingChunks.push_back({archetype.get(), c});
+        jobs.parallelFor(0, matchingChunks.size(), chunksPerJob, [&](size_t first, size_t last)
+                         {
+            for (size_t i = first; i < last; i++)
+            {
+                Archetype &archetype = *matchingChunks[i].archetype;
+                size_t c = matchingChunks[i].chunk;
+                fn((size_t)archetype.chunks[c]->count, column<Components>(archetype, c)...);
+            } });
+    }
+
+    template <typename... Components, typename F>
+    void parallelEach(JobSystem &jobs, F &&fn, size_t chunksPerJob = 8)
+    {
+        parallelForEachChunk<Components...>(jobs, [&](size_t count, Components *...columns)
+                                            {
+            for (size_t i = 0; i < count; i++)
+                fn(columns[i]...); }, chunksPerJob);
+    }
+
+    // Entities per chunk of the archetype holding exactly Components, creating it if needed
+    template <typename... Components>
+    size_t chunkCapacity()
+    {
+        return archetypeFor(maskOf<Components...>()).capacity;
+    }
+
+private:
+    static constexpr uint32_t NoArchetype = ~0u;
+
+    struct alignas(64) Chunk
+    {
+        unsigned char data[ChunkSize];
+        uint32_t count = 0;
+    };
+
+    struct ComponentInfo
+    {
+        size_t size = 0;
+        size_t align = 1;
+    };
+
+    struct Archetype
+    {
+        uint64_t mask = 0;
+        uint32_t index = 0;
+        size_t capacity = 0;
+        size_t entityOffset = 0;
+        size_t offsets[MaxComponents] = {}; // column start per component id, inside the chunk
+        std::vector<std::unique_ptr<Chunk>> chunks;
+    };
+
+    struct Record
+    {
+        uint32_t archetype = NoArchetype;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    struct Location
+    {
+        uint32_t chunk;
+        uint32_t row;
+    };
+
+    struct ChunkRef
+    {
+        Archetype *archetype;
+        size_t chunk;
+    };
+
+    // Component ids are handed out on first use, the same for every world. First use can
+    // be on a job thread, hence the atomic; each id fits one bit of a 64-bit mask.
+    static size_t nextComponentId()
+    {
+        static std::atomic<size_t> next{0};
+        size_t id = next.fetch_add(1, std::memory_order_relaxed);
+        if (id >= MaxComponents)
+        {
+            std::cout << "ERROR::ENTITYWORLD::TOO_MANY_COMPONENTS at most " << MaxComponents << " component types" << std::endl;
+            std::abort();
+        }
+        return id;
+    }
+
+    // Fixed size so registering a type never moves another type's entry
+    static std::array<ComponentInfo, MaxComponents> &componentInfo()
+    {
+        static std::array<ComponentInfo, MaxComponents> info;
+        return info;
+    }
+
+    template <typename T>
+    static size_t componentId()
+    {
+        using Plain = std::remove_cv_t<T>;
+        static_assert(std::is_trivially_copyable_v<Plain>, "components are copied with memcpy");
+        static const size_t id = []
+        {
+            size_t id = nextComponentId();
+            componentInfo()[id] = {sizeof(Plain), alignof(Plain)};
+            return id;
+        }();
+        return id;
+    }
+
+    template <typename T>
+    static uint64_t bit()
+    {
+        return uint64_t(1) << componentId<std::remove_cv_t<T>>();
+    }
+
+    template <typename... Components>
+    static uint64_t maskOf()
+    {
+        return (uint64_t(0) | ... | bit<Components>());
+    }
+
+    template <typename T>
+    static T *column(Archetype &archetype, size_t chunk)
+    {
+        size_t id = componentId<std::remove_cv_t<T>>();
+        return reinterpret_cast<T *>(archetype.chunks[chunk]->data + archetype.offsets[id]);
+    }
+
+    static Entity *entityColumn(Archetype &archetype, size_t chunk)
+    {
+        return reinterpret_cast<Entity *>(archetype.chunks[chunk]->data + archetype.entityOffset);
+    }
+
+    // Fits as many rows as the chunk holds once every column is aligned
+    Archetype &archetypeFor(uint64_t mask)
+    {
+        for (auto &archetype : archetypes)
+            if (archetype->mask == mask)
+                return *archetype;
+
+        auto archetype = std::make_unique<Archetype>();
+        archetype->mask = mask;
+        archetype->index = (uint32_t)archetypes.size();
+        const std::array<ComponentInfo, MaxComponents> &info = componentInfo();
+        size_t rowSize = sizeof(Entity), padding = alignof(Entity);
+        for (size_t id = 0; id < MaxComponents; id++)
+            if (mask & (uint64_t(1) << id))
+            {
+                rowSize += info[id].size;
+                padding += std::max<size_t>(info[id].align, 16);
+            }
+        archetype->capacity = (ChunkSize - padding) / rowSize;
+
+        size_t offset = 0;
+        auto place = [&](size_t size, size_t align)
+        {
+            align = std::max<size_t>(align, 16);
+            offset = (offset + align - 1) / align * align;
+            size_t start = offset;
+            offset += size * archetype->capacity;
+            return start;
+        };
+        for (size_t id = 0; id < MaxComponents; id++)
+            if (mask & (uint64_t(1) << id))
+                archetype->offsets[id] = place(info[id].size, info[id].align);
+        archetype->entityOffset = place(sizeof(Entity), alignof(Entity));
+
+        archetypes.push_back(std::move(archetype));
+        return *archetypes.back();
+    }
+
+    Location appendRow(Archetype &archetype, Entity entity)
+    {
+        if (archetype.chunks.empty() || archetype.chunks.back()->count == archetype.capacity)
+            archetype.chunks.push_back(std::make_unique<Chunk>());
+        uint32_t chunk = (uint32_t)archetype.chunks.size() - 1;
+        uint32_t row = archetype.chunks[chunk]->count++;
+        entityColumn(archetype, chunk)[row] = entity;
+        return {chunk, row};
+    }
+
+    // Fills the hole with the archetype's very last row and fixes that entity's record
+    void removeRow(Archetype &archetype, Location hole)
+    {
+        uint32_t lastChunk = (uint32_t)archetype.chunks.size() - 1;
+        uint32_t lastRow = archetype.chunks[lastChunk]->count - 1;
+        if (hole.chunk != lastChunk || hole.row != lastRow)
+        {
+            const std::array<ComponentInfo, MaxComponents> &info = componentInfo();
+            for (size_t id = 0; id < MaxComponents; id++)
+                if (archetype.mask & (uint64_t(1) << id))
+                    std::memcpy(archetype.chunks[hole.chunk]->data + archetype.offsets[id] + hole.row * info[id].size,
+                                archetype.chunks[lastChunk]->data + archetype.offsets[id] + lastRow * info[id].size, info[id].size);
+            Entity moved = entityColumn(archetype, lastChunk)[lastRow];
+            entityColumn(archetype, hole.chunk)[hole.row] = moved;
+            records[moved.index].chunk = hole.chunk;
+            records[moved.index].row = hole.row;
+        }
+        if (--archetype.chunks[lastChunk]->count == 0)
+            archetype.chunks.pop_back();
+    }
+
+    // Moves an entity to the archetype for mask, copying the components both have
+    Location migrate(Entity entity, uint64_t mask)
+    {
+        Record &record = records[entity.index];
+        Archetype &from = *archetypes[record.archetype];
+        Archetype &to = archetypeFor(mask);
+        Location source{record.chunk, record.row};
+        Location target = appendRow(to, entity);
+        const std::array<ComponentInfo, MaxComponents> &info = componentInfo();
+        for (size_t id = 0; id < MaxComponents; id++)
+            if (from.mask & to.mask & (uint64_t(1) << id))
+                std::memcpy(to.chunks[target.chunk]->data + to.offsets[id] + target.row * info[id].size,
+                            from.chunks[source.chunk]->data + from.offsets[id] + source.row * info[id].size, info[id].size);
+        removeRow(from, source);
+        record.archetype = to.index;
+        record.chunk = target.chunk;
+        record.row = target.row;
+        return target;
+    }
+
+    template <typename T>
+    void writeComponent(Archetype &archetype, Location location, const T &component)
+    {
+        column<T>(archetype, location.chunk)[location.row] = component;
+    }
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::vector<Record> records;
+    std::vector<uint32_t> freeIndices;
+    std::vector<ChunkRef> matchingChunks;
+    size_t entityCount = 0;
+};
+
+#endif
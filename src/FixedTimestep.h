@@ -0,0 +1,83 @@
+#ifndef __FIXEDTIMESTEP_H__
+#define __FIXEDTIMESTEP_H__
+
+#include <algorithm>
+
+// Accumulator for a fixed-step simulation driven by a double-precision clock.
+//
+//     clock.advance(now);
+//     while (clock.step())
+//         simulate(clock.dt());        // previous = current first, for interpolation
+//     render(lerp(previous, current, clock.alpha()));
+//
+// The simulation always advances in dt sized steps, so its cost and results
+// don't depend on the render rate. When a frame takes too long, at most
+// maxSteps are run and the rest of the backlog is dropped, so a slow frame
+// can't cause an even slower one (the spiral of death). Simulation time skips
+// over the dropped part, so it keeps following the clock passed to advance().
+class FixedTimestep
+{
+public:
+    explicit FixedTimestep(double dt = 1.0 / 120.0, int maxSteps = 8) : stepSize(dt), maxSteps(maxSteps) {}
+
+    // Adds the time since the last call, the first call only sets the start time
+    void advance(double now)
+    {
+        if (started)
+            accumulator += now - lastNow;
+        else
+        {
+            simTime = now;
+            started = true;
+        }
+        lastNow = now;
+
+        double limit = stepSize * maxSteps;
+        if (accumulator > limit)
+        {
+            droppedTime += accumulator - limit;
+            simTime += accumulator - limit;
+            accumulator = limit;
+        }
+    }
+
+    // True while a whole step is owed, moves simulation time forward by one step
+    bool step()
+    {
+        if (accumulator < stepSize)
+            return false;
+        accumulator -= stepSize;
+        simTime += stepSize;
+        steps++;
+        return true;
+    }
+
+    double dt() const { return stepSize; }
+
+    // End of the most recent step, the time the current state is valid for. Never
+    // more than a step behind the last advance(), dropped time included.
+    double time() const { return simTime; }
+
+    // How far the last advance() is past the current state, in steps: the blend from
+    // previous to current for a frame showing that moment. Taken from the clock's own
+    // state, so a copy handed to another thread still gives the right value there.
+    double alpha() const
+    {
+        return std::clamp(accumulator / stepSize, 0.0, 1.0);
+    }
+
+    unsigned long long stepCount() const { return steps; }
+    double dropped() const { return droppedTime; }
+
+private:
+    double stepSize;
+    int maxSteps;
+    bool started = false;
+    double lastNow = 0.0;
+    double accumulator = 0.0;
+    double simTime = 0.0;
+    double droppedTime = 0.0;
+    unsigned long long steps = 0;
+};
+
+#endif
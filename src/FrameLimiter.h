@@ -0,0 +1,158 @@
+#ifndef __FRAMELIMITER_H__
+#define __FRAMELIMITER_H__
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+
+// Paces the render loop to a target rate without burning a core.
+//
+//     limiter.beginFrame();   // may wait, then sample input
+//     ... build and submit the frame, swap ...
+//     limiter.endFrame();
+//
+// Waiting sleeps for all but the amount the OS has been oversleeping by lately and
+// spins for the rest, so deadlines are hit to within microseconds without
+// spinning for whole milliseconds.
+//
+// Predictive mode moves the wait to the start of the frame: it starts the frame
+// as late as recent frame times allow, so it finishes just before its deadline
+// and input is sampled as late as possible. When frames keep taking longer than a
+// whole period, the rate falls back to target/2, target/3... and climbs again
+// once the work fits.
+class FrameLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 0 leaves the loop uncapped
+    explicit FrameLimiter(double targetHz = 0.0, bool predictive = true) : predictive(predictive) { setTarget(targetHz); }
+
+    void setTarget(double hz)
+    {
+        targetHz = std::max(0.0, hz);
+        divisor = 1;
+        started = false;
+    }
+
+    double target() const { return targetHz; }
+    // the rate actually being paced to, lower than target() after falling back
+    double rate() const { return targetHz / divisor; }
+
+    // Waits until this frame should start
+    void beginFrame()
+    {
+        Clock::time_point now = Clock::now();
+        if (targetHz <= 0.0)
+        {
+            frameStart = now;
+            return;
+        }
+        if (!started)
+        {
+            deadline = now + period();
+            started = true;
+        }
+        // predicted work: mean plus a couple of deviations, and a little slack for the wake up
+        Clock::time_point start = deadline - period();
+        if (predictive)
+        {
+            double expected = std::min(workMean + 2.0 * workDeviation + SafetyMargin, seconds(period()));
+            start = deadline - toDuration(expected);
+        }
+        waitUntil(start);
+        frameStart = Clock::now();
+    }
+
+    // Call once the frame is submitted
+    void endFrame()
+    {
+        Clock::time_point now = Clock::now();
+        double work = seconds(now - frameStart);
+        // exponential moving mean and mean absolute deviation of the work per frame
+        workDeviation += Smoothing * (std::abs(work - workMean) - workDeviation);
+        workMean += Smoothing * (work - workMean);
+        if (targetHz <= 0.0)
+            return;
+
+        if (now > deadline + toDuration(SafetyMargin))
+            overrunCount++;
+        deadline += period();
+        // a whole frame behind, start a fresh schedule instead of rushing frames to catch up
+        if (deadline < now)
+            deadline = now + period();
+        // the rate only falls back for frames that couldn't fit even when started on time
+        adjustRate(work > seconds(period()));
+    }
+
+    // frames that finished after their deadline
+    uint64_t overruns() const { return overrunCount; }
+    // recent seconds of work per frame, as used for prediction
+    double expectedWork() const { return workMean; }
+
+private:
+    static constexpr double SafetyMargin = 0.0005;
+    static constexpr double Smoothing = 0.1;
+    static constexpr int MaxDivisor = 4;
+
+    static double seconds(Clock::duration d) { return std::chrono::duration<double>(d).count(); }
+    static Clock::duration toDuration(double s) { return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(s)); }
+
+    Clock::duration period() const { return toDuration(divisor / targetHz); }
+
+    void waitUntil(Clock::time_point t)
+    {
+        double remaining = seconds(t - Clock::now());
+        double budget = oversleepMean + 2.0 * oversleepDeviation;
+        if (remaining > budget)
+        {
+            double request = remaining - budget;
+            Clock::time_point before = Clock::now();
+            std::this_thread::sleep_for(toDuration(request));
+            double oversleep = seconds(Clock::now() - before) - request;
+            oversleepDeviation += Smoothing * (std::abs(oversleep - oversleepMean) - oversleepDeviation);
+            oversleepMean += Smoothing * (oversleep - oversleepMean);
+        }
+        while (Clock::now() < t)
+            std::this_thread::yield();
+    }
+
+    // drop to a lower rate when 4 of the last 16 frames were too long, go back up
+    // after 120 frames that fit if the work would fit the faster rate with room left
+    void adjustRate(bool tooLong)
+    {
+        history = (history << 1) | (tooLong ? 1u : 0u);
+        cleanFrames = tooLong ? 0 : cleanFrames + 1;
+        if (std::popcount(history & 0xffffu) >= 4 && divisor < MaxDivisor)
+        {
+            divisor++;
+            history = 0;
+            cleanFrames = 0;
+        }
+        else if (divisor > 1 && cleanFrames >= 120 && workMean + 2.0 * workDeviation < 0.75 * (divisor - 1) / targetHz)
+        {
+            divisor--;
+            cleanFrames = 0;
+        }
+    }
+
+    double targetHz = 0.0;
+    bool predictive;
+    int divisor = 1;
+
+    bool started = false;
+    Clock::time_point deadline, frameStart;
+
+    double workMean = 0.0, workDeviation = 0.0;
+    // how much longer than asked sleeps have been taking
+    double oversleepMean = 0.001, oversleepDeviation = 0.0005;
+
+    uint32_t history = 0; // one bit per frame, set when it took longer than a period
+    int cleanFrames = 0;
+    uint64_t overrunCount = 0;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef __FRAMEPIPELINE_H__
+#define __FRAMEPIPELINE_H__
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Hands render snapshots from an update thread to the render thread, so frame N+1
+// is simulated while frame N is submitted.
+//
+// The update thread fills beginWrite() and publish()es it, the render thread
+// acquire()s the next snapshot and reads it until its next acquire(). Snapshots
+// are never shared while being written, so neither side needs to lock its data.
+//
+// Latency is bounded by maxFramesAhead, the number of published snapshots the
+// render thread may lag behind:
+//   Queue  - every snapshot is rendered in order; the update thread blocks when
+//            it gets maxFramesAhead frames ahead (input-to-photon <= maxFramesAhead + 1 frames)
+//   Latest - the update thread never blocks; acquire() skips to the newest snapshot and
+//            stale ones are recycled, trading simulation work for the lowest latency
+template <typename Snapshot>
+class FramePipeline
+{
+public:
+    enum class Mode
+    {
+        Queue,
+        Latest
+    };
+
+    explicit FramePipeline(Mode mode = Mode::Queue, unsigned maxFramesAhead = 1)
+        : mode(mode), slots(std::max(1u, maxFramesAhead) + 2), maxAhead(std::max(1u, maxFramesAhead))
+    {
+        for (unsigned i = 0; i < slots.size(); i++)
+            freeSlots.push_back(i);
+    }
+
+    // Update thread: a snapshot to overwrite, blocks in Queue mode while the render
+    // thread is too far behind. Returns nullptr after stop().
+    Snapshot *beginWrite()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (mode == Mode::Queue)
+            canWrite.wait(lock, [this]
+                          { return stopped || (published.size() < maxAhead && !freeSlots.empty()); });
+        else if (freeSlots.empty())
+        {
+            // nobody picked the oldest snapshot up yet and a newer one is on its way, reuse it
+            freeSlots.push_back(published.front());
+            published.pop_front();
+            dropped++;
+        }
+        if (stopped)
+            return nullptr;
+        writing = freeSlots.front();
+        freeSlots.pop_front();
+        return &slots[writing];
+    }
+
+    // Update thread: makes the snapshot from beginWrite() visible to the render thread
+    void publish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            published.push_back(writing);
+            writing = -1;
+        }
+        canRead.notify_one();
+    }
+
+    // Render thread: the next snapshot, or nullptr after stop() or when timeout expires
+    // with nothing new. The previous snapshot goes back to the update thread.
+    const Snapshot *acquire(std::chrono::milliseconds timeout = std::chrono::milliseconds(100))
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!canRead.wait_for(lock, timeout, [this]
+                              { return stopped || !published.empty(); }) ||
+            stopped)
+            return nullptr;
+        if (mode == Mode::Latest)
+            while (published.size() > 1)
+            {
+                freeSlots.push_back(published.front());
+                published.pop_front();
+                dropped++;
+            }
+        if (reading >= 0)
+            freeSlots.push_back(reading);
+        reading = published.front();
+        published.pop_front();
+        lock.unlock();
+        canWrite.notify_one();
+        return &slots[reading];
+    }
+
+    // Wakes both sides, every later call returns nullptr
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        canRead.notify_all();
+        canWrite.notify_all();
+    }
+
+    // snapshots the render thread never saw (Latest mode)
+    size_t droppedFrames() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dropped;
+    }
+
+private:
+    const Mode mode;
+    std::vector<Snapshot> slots;
+    const unsigned maxAhead;
+
+    mutable std::mutex mutex;
+    std::condition_variable canRead, canWrite;
+    std::deque<int> freeSlots, published;
+    int writing = -1, reading = -1;
+    size_t dropped = 0;
+    bool stopped = false;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef __FRAMETIMINGS_H__
+#define __FRAMETIMINGS_H__
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Per-frame timings collected during a run, written out as CSV and summarised
+// as mean and percentiles so two builds can be compared frame for frame.
+class FrameTimings
+{
+public:
+    struct Summary
+    {
+        size_t frames = 0;
+        double mean = 0.0, stddev = 0.0;
+        double p50 = 0.0, p95 = 0.0, p99 = 0.0, max = 0.0;
+    };
+
+    // frameMs: start of one frame to the start of the next, cpuMs: time spent recording it
+    void add(double frameMs, double cpuMs)
+    {
+        frames.push_back(frameMs);
+        cpu.push_back(cpuMs);
+    }
+
+    size_t size() const { return frames.size(); }
+
+    Summary frameSummary() const { return summarize(frames); }
+    Summary cpuSummary() const { return summarize(cpu); }
+
+    bool writeCsv(const std::string &path) const
+    {
+        std::ofstream out(path);
+        out << "frame,frame_ms,cpu_ms\n";
+        for (size_t i = 0; i < frames.size(); i++)
+            out << i << "," << frames[i] << "," << cpu[i] << "\n";
+        if (!out)
+            std::cout << "ERROR::FRAMETIMINGS::WRITE_FAILED " << path << std::endl;
+        return (bool)out;
+    }
+
+    void print(const char *title) const
+    {
+        Summary f = frameSummary(), c = cpuSummary();
+        std::cout << title << ": " << f.frames << " frames" << std::endl;
+        std::cout << "  frame ms: mean " << f.mean << ", sd " << f.stddev << ", p50 " << f.p50 << ", p95 " << f.p95 << ", p99 " << f.p99 << ", max " << f.max << std::endl;
+        std::cout << "  cpu ms:   mean " << c.mean << ", sd " << c.stddev << ", p50 " << c.p50 << ", p95 " << c.p95 << ", p99 " << c.p99 << ", max " << c.max << std::endl;
+    }
+
+    static Summary summarize(std::vector<double> values)
+    {
+        Summary s;
+        s.frames = values.size();
+        if (values.empty())
+            return s;
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values)
+            sum += v;
+        s.mean = sum / values.size();
+        double var = 0.0;
+        for (double v : values)
+            var += (v - s.mean) * (v - s.mean);
+        s.stddev = std::sqrt(var / values.size());
+        auto percentile = [&](double p)
+        { return values[std::min(values.size() - 1, (size_t)(p * values.size()))]; };
+        s.p50 = percentile(0.50);
+        s.p95 = percentile(0.95);
+        s.p99 = percentile(0.99);
+        s.max = values.back();
+        return s;
+    }
+
+private:
+    std::vector<double> frames, cpu;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef __INPUTRECORDING_H__
+#define __INPUTRECORDING_H__
+
+#include "Camera.h"
+#include "InputSystem.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Binary input log for repeatable flythroughs.
+//
+// Layout (little endian): "ILOG", uint32 version, the starting camera (double position
+// xyz, float yaw, pitch, zoom; 36 bytes, no padding), uint32 event count, then per event: uint8 type,
+// uint8 key, float x, float y, double time. Times are seconds since recording
+// started. The count is patched in when the recorder closes; a log left at 0 by a crash
+// is replayed up to its last whole event.
+namespace InputLog
+{
+    constexpr uint32_t Version = 3;
+    constexpr size_t EventSize = 18;
+
+    struct CameraState
+    {
+        double position[3];
+        float yaw, pitch, zoom;
+    };
+
+    inline CameraState capture(const Camera &camera)
+    {
+        return {{camera.Position.x, camera.Position.y, camera.Position.z}, camera.Yaw, camera.Pitch, camera.Zoom};
+    }
+
+    inline Camera restore(const CameraState &state)
+    {
+        Camera camera(glm::dvec3(state.position[0], state.position[1], state.position[2]), glm::vec3(0.0f, 1.0f, 0.0f), state.yaw, state.pitch);
+        camera.Zoom = state.zoom;
+        return camera;
+    }
+}
+
+// Writes every event handed to record() while the window thread is running
+class InputRecorder
+{
+public:
+    InputRecorder(const std::string &path, const Camera &camera, double startTime) : file(path, std::ios::binary), start(startTime)
+    {
+        if (!file)
+        {
+            std::cout << "ERROR::INPUTLOG::OPEN_FAILED " << path << std::endl;
+            return;
+        }
+        InputLog::CameraState state = InputLog::capture(camera);
+        uint32_t count = 0;
+        file.write("ILOG", 4);
+        file.write((const char *)&InputLog::Version, sizeof(InputLog::Version));
+        file.write((const char *)state.position, sizeof(state.position));
+        file.write((const char *)&state.yaw, sizeof(float));
+        file.write((const char *)&state.pitch, sizeof(float));
+        file.write((const char *)&state.zoom, sizeof(float));
+        countOffset = file.tellp();
+        file.write((const char *)&count, sizeof(count));
+    }
+
+    ~InputRecorder()
+    {
+        if (!file)
+            return;
+        file.seekp(countOffset);
+        file.write((const char *)&count, sizeof(count));
+    }
+
+    InputRecorder(const InputRecorder &) = delete;
+    InputRecorder &operator=(const InputRecorder &) = delete;
+
+    void record(const InputEvent &event)
+    {
+        if (!file)
+            return;
+        uint8_t type = event.type, key = (uint8_t)event.key;
+        double time = event.time - start;
+        file.write((const char *)&type, 1);
+        file.write((const char *)&key, 1);
+        file.write((const char *)&event.x, sizeof(float));
+        file.write((const char *)&event.y, sizeof(float));
+        file.write((const char *)&time, sizeof(double));
+        count++;
+    }
+
+private:
+    std::ofstream file;
+    std::streampos countOffset = 0;
+    double start;
+    uint32_t count = 0;
+};
+
+// A loaded log, fed back into an InputSystem at whatever rate the replay runs
+class InputReplay
+{
+public:
+    bool load(const std::string &path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = file ? (std::streamoff)file.tellg() : -1;
+        file.seekg(0);
+        char magic[4];
+        uint32_t version = 0, count = 0;
+        if (!file.read(magic, 4) || memcmp(magic, "ILOG", 4) != 0 ||
+            !file.read((char *)&version, sizeof(version)) || version != InputLog::Version ||
+            !file.read((char *)startCamera.position, sizeof(startCamera.position)) ||
+            !file.read((char *)&startCamera.yaw, sizeof(float)) ||
+            !file.read((char *)&startCamera.pitch, sizeof(float)) ||
+            !file.read((char *)&startCamera.zoom, sizeof(float)) ||
+            !file.read((char *)&count, sizeof(count)))
+        {
+            std::cout << "ERROR::INPUTLOG::INVALID " << path << std::endl;
+            return false;
+        }
+        // never trust the count further than the file backs it
+        uint64_t available = (uint64_t)(size - (std::streamoff)file.tellg()) / InputLog::EventSize;
+        if (count == 0)
+            count = (uint32_t)std::min<uint64_t>(available, UINT32_MAX);
+        else if (count > available)
+        {
+            std::cout << "ERROR::INPUTLOG::TRUNCATED " << path << std::endl;
+            return false;
+        }
+        events.resize(count);
+        for (InputEvent &e : events)
+        {
+            uint8_t type, key;
+            file.read((char *)&type, 1);
+            file.read((char *)&key, 1);
+            file.read((char *)&e.x, sizeof(float));
+            file.read((char *)&e.y, sizeof(float));
+            file.read((char *)&e.time, sizeof(double));
+            e.type = (InputEvent::Type)type;
+            e.key = (Camera_Movement)key;
+        }
+        if (!file)
+        {
+            std::cout << "ERROR::INPUTLOG::TRUNCATED " << path << std::endl;
+            return false;
+        }
+        next = 0;
+        return true;
+    }
+
+    Camera camera() const { return InputLog::restore(startCamera); }
+
+    // time of the last event, a replay runs at least this long
+    double duration() const { return events.empty() ? 0.0 : events.back().time; }
+    bool finished() const { return next >= events.size(); }
+
+    // Pushes every event up to time into input, call from the thread that integrates it
+    void feed(InputSystem &input, double time)
+    {
+        while (next < events.size() && events[next].time <= time)
+            input.push(events[next++]);
+    }
+
+private:
+    InputLog::CameraState startCamera{};
+    std::vector<InputEvent> events;
+    size_t next = 0;
+};
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef __INPUTSYSTEM_H__
+#define __INPUTSYSTEM_H__
+
+#include "Camera.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// One raw input event, stamped when the window system delivered it
+struct InputEvent
+{
+    enum Type : uint8_t
+    {
+        MouseMove,
+        Scroll,
+        KeyDown,
+        KeyUp
+    };
+
+    Type type;
+    Camera_Movement key;
+    float x, y; // mouse offset, or scroll amount in y
+    double time; // seconds, same clock as the update thread
+};
+
+// Lock-free single producer / single consumer ring buffer
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+public:
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    // Producer only, false when full
+    bool push(const T &item)
+    {
+        size_t head = writeIndex.load(std::memory_order_relaxed);
+        if (head - readIndex.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[head & (Capacity - 1)] = item;
+        writeIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Only the producer adds items, so a false here holds until its next push.
+    bool full() const { return writeIndex.load(std::memory_order_relaxed) - readIndex.load(std::memory_order_acquire) == Capacity; }
+
+    // Consumer only
+    const T *peek() const
+    {
+        size_t tail = readIndex.load(std::memory_order_relaxed);
+        if (tail == writeIndex.load(std::memory_order_acquire))
+            return nullptr;
+        return &items[tail & (Capacity - 1)];
+    }
+
+    void pop() { readIndex.store(readIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+private:
+    std::array<T, Capacity> items;
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+// Timestamped input from the window thread to the update thread.
+//
+// The window thread pushes raw events as they arrive. The update thread replays
+// them in order with integrate(): held movement keys move the camera for exactly
+// the time between events rather than a whole frame's dt, so a tap lasting 3 ms
+// moves 3 ms worth regardless of frame rate.
+//
+// Mouse look is additionally late-latched: the snapshot remembers how much mouse
+// movement the update thread consumed (LookState), and just before the render
+// thread uploads the view matrix lateLatch() adds everything that arrived since,
+// so camera orientation is as fresh as the last poll instead of a frame old.
+class InputSystem
+{
+public:
+    // how much mouse movement a camera already includes
+    struct LookState
+    {
+        double x = 0.0, y = 0.0;
+        uint64_t events = 0;
+    };
+
+    // Window thread. Events that don't fit are dropped and counted.
+    void push(const InputEvent &event)
+    {
+        // a dropped move must not reach the look totals either: integrate() never applies
+        // it, so late latching would keep the difference forever
+        if (events.full())
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (event.type == InputEvent::MouseMove)
+        {
+            // seqlock: odd while writing, readers retry if it changed under them
+            uint64_t v = lookVersion.load(std::memory_order_relaxed);
+            lookVersion.store(v + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            lookX.store(lookX.load(std::memory_order_relaxed) + event.x, std::memory_order_relaxed);
+            lookY.store(lookY.load(std::memory_order_relaxed) + event.y, std::memory_order_relaxed);
+            lookEvents.store(lookEvents.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            lookVersion.store(v + 2, std::memory_order_release);
+        }
+        // totals first, so the update thread can never consume a move they don't include yet
+        events.push(event);
+    }
+
+    // Update thread: applies every event stamped up to now, integrating held keys
+    // between event timestamps. Returns the mouse movement camera now includes.
+    LookState integrate(Camera &camera, double now)
+    {
+        if (lastTime < 0.0)
+            lastTime = now;
+        while (const InputEvent *e = events.peek())
+        {
+            if (e->time > now)
+                break;
+            move(camera, e->time);
+            switch (e->type)
+            {
+            case InputEvent::MouseMove:
+                camera.ProcessMouseMovement(e->x, e->y);
+                consumed.x += e->x;
+                consumed.y += e->y;
+                consumed.events++;
+                break;
+            case InputEvent::Scroll:
+                camera.ProcessMouseScroll(e->y);
+                break;
+            case InputEvent::KeyDown:
+                held[e->key] = true;
+                break;
+            case InputEvent::KeyUp:
+                held[e->key] = false;
+                break;
+            }
+            events.pop();
+        }
+        move(camera, now);
+        return consumed;
+    }
+
+    // Render thread: turns camera towards all mouse movement newer than consumed.
+    // Returns how many mouse events camera now includes.
+    uint64_t lateLatch(Camera &camera, const LookState &consumed) const
+    {
+        LookState latest = look();
+        float dx = (float)(latest.x - consumed.x), dy = (float)(latest.y - consumed.y);
+        if (dx != 0.0f || dy != 0.0f)
+            camera.ProcessMouseMovement(dx, dy);
+        return latest.events;
+    }
+
+    // Total mouse movement pushed so far, safe from any thread
+    LookState look() const
+    {
+        LookState state;
+        uint64_t before, after;
+        do
+        {
+            before = lookVersion.load(std::memory_order_acquire);
+            state.x = lookX.load(std::memory_order_relaxed);
+            state.y = lookY.load(std::memory_order_relaxed);
+            state.events = lookEvents.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = lookVersion.load(std::memory_order_relaxed);
+        } while (before != after || (before & 1));
+        return state;
+    }
+
+    size_t droppedEvents() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    // moves the camera for the keys held between lastTime and t
+    void move(Camera &camera, double t)
+    {
+        float dt = (float)(t - lastTime);
+        if (dt <= 0.0f)
+            return;
+        for (int key = FORWARD; key <= RIGHT; key++)
+            if (held[key])
+                camera.ProcessKeyboard((Camera_Movement)key, dt);
+        lastTime = t;
+    }
+
+    SpscQueue<InputEvent, 1024> events;
+    std::atomic<size_t> dropped{0};
+
+    // written by the window thread only
+    std::atomic<uint64_t> lookVersion{0};
+    std::atomic<double> lookX{0.0}, lookY{0.0};
+    std::atomic<uint64_t> lookEvents{0};
+
+    // update thread only
+    bool held[RIGHT + 1] = {};
+    double lastTime = -1.0;
+    LookState consumed;
+};
+
+#endif
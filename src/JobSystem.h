@@ -0,0 +1,362 @@
+#ifndef __JOBSYSTEM_H__
+#define __JOBSYSTEM_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Counts outstanding jobs. Pass one to JobSystem::run and wait on it, jobs that
+// depend on others take the counter of the work they need (see runAfter).
+struct JobCounter
+{
+    std::atomic<int> pending{0};
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+class Job
+{
+public:
+    virtual ~Job() = default;
+    virtual void run() = 0;
+
+    JobCounter *counter = nullptr;
+};
+
+// Chase-Lev work-stealing deque (fixed capacity, the weak memory model version by
+// Lê et al.). The owning thread pushes and pops at the bottom without contention,
+// other threads steal from the top with one CAS.
+class WorkStealingDeque
+{
+public:
+    static constexpr int64_t Capacity = 4096;
+
+    WorkStealingDeque()
+    {
+        for (auto &item : items)
+            item.store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Owner only. False when full, the caller then runs the job itself.
+    bool push(Job *job)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= Capacity)
+            return false;
+        // release on the slot too, so a thief that reads it also sees the job's contents
+        items[b & Mask].store(job, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only, newest job first so the data it touches is still in cache
+    Job *pop()
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job *job = items[b & Mask].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // last job, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // Any thread, oldest job first
+    Job *steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        Job *job = items[t & Mask].load(std::memory_order_acquire);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+
+private:
+    static constexpr int64_t Mask = Capacity - 1;
+    static_assert((Capacity & Mask) == 0, "capacity must be a power of two");
+
+    // top is written by thieves, bottom by the owner, keep them on separate lines
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    alignas(64) std::atomic<Job *> items[Capacity];
+};
+
+// Fixed pool of worker threads sharing work through per-thread stealing deques.
+//
+// The thread that creates the JobSystem is worker 0 and does work whenever it
+// waits, so JobSystem(1) runs everything inline on that thread. Jobs may spawn and
+// wait on other jobs; a waiting thread keeps executing jobs instead of blocking.
+// Threads outside the system can still run() jobs, those go through a locked queue.
+class JobSystem
+{
+public:
+    // threadCount includes the calling thread, 0 uses every hardware thread
+    explicit JobSystem(unsigned threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        queues = std::vector<PaddedDeque>(threadCount);
+        current() = {this, 0};
+        for (unsigned i = 1; i < threadCount; i++)
+            workers.emplace_back([this, i]
+                                 { workerLoop(i); });
+    }
+
+    ~JobSystem()
+    {
+        running.store(false);
+        wake(true);
+        for (std::thread &w : workers)
+            w.join();
+        // jobs nobody waited for are dropped unrun, but their memory is still ours
+        for (PaddedDeque &q : queues)
+            while (Job *job = q.deque.steal())
+                delete job;
+        for (Job *job : injected)
+            delete job;
+        if (current().system == this)
+            current() = {};
+    }
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    unsigned threadCount() const { return (unsigned)queues.size(); }
+
+    // Queues fn, counter (if any) reaches zero again once it and its siblings finished
+    template <typename F>
+    void run(F &&fn, JobCounter *counter = nullptr)
+    {
+        Job *job = new JobImpl<std::decay_t<F>>(std::forward<F>(fn));
+        job->counter = counter;
+        if (counter)
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+        const ThreadSlot &slot = current();
+        if (slot.system == this)
+        {
+            if (!queues[slot.index].deque.push(job))
+            {
+                execute(job);
+                return;
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(injectedMutex);
+            injected.push_back(job);
+            injectedCount.fetch_add(1, std::memory_order_release);
+        }
+        wake(false);
+    }
+
+    // Like run, but fn only starts after everything counted by dependency finished
+    template <typename F>
+    void runAfter(JobCounter &dependency, F &&fn, JobCounter *counter = nullptr)
+    {
+        if (dependency.done())
+        {
+            run(std::forward<F>(fn), counter);
+            return;
+        }
+        run([this, &dependency, fn = std::forward<F>(fn)]() mutable
+            {
+                wait(dependency);
+                fn(); },
+            counter);
+    }
+
+    // Runs other jobs until counter reaches zero
+    void wait(const JobCounter &counter)
+    {
+        const ThreadSlot &slot = current();
+        int idle = 0;
+        while (!counter.done())
+        {
+            Job *job = slot.system == this ? findJob(slot.index) : nullptr;
+            if (job)
+            {
+                execute(job);
+                idle = 0;
+            }
+            else if (++idle > 64)
+                std::this_thread::yield();
+        }
+    }
+
+    // Calls fn(first, last) over [begin, end) split into chunks of about grain items.
+    // grain 0 picks four chunks per thread.
+    template <typename F>
+    void parallelFor(size_t begin, size_t end, size_t grain, F &&fn)
+    {
+        if (end <= begin)
+            return;
+        size_t count = end - begin;
+        if (grain == 0)
+            grain = std::max<size_t>(1, count / (threadCount() * 4));
+        if (count <= grain || threadCount() == 1)
+        {
+            fn(begin, end);
+            return;
+        }
+        JobCounter counter;
+        for (size_t first = begin; first < end; first += grain)
+        {
+            size_t last = std::min(end, first + grain);
+            run([&fn, first, last]
+                { fn(first, last); },
+                &counter);
+        }
+        wait(counter);
+    }
+
+private:
+    template <typename F>
+    class JobImpl : public Job
+    {
+    public:
+        template <typename G>
+        explicit JobImpl(G &&fn) : fn(std::forward<G>(fn)) {}
+        void run() override { fn(); }
+
+    private:
+        F fn;
+    };
+
+    struct ThreadSlot
+    {
+        JobSystem *system = nullptr;
+        unsigned index = 0;
+    };
+
+    struct alignas(64) PaddedDeque
+    {
+        WorkStealingDeque deque;
+    };
+
+    static ThreadSlot &current()
+    {
+        thread_local ThreadSlot slot;
+        return slot;
+    }
+
+    void execute(Job *job)
+    {
+        job->run();
+        if (job->counter)
+            job->counter->pending.fetch_sub(1, std::memory_order_release);
+        delete job;
+    }
+
+    // own deque first, then jobs from outside threads, then steal from a random victim
+    Job *findJob(unsigned index)
+    {
+        if (Job *job = queues[index].deque.pop())
+            return job;
+
+        if (injectedCount.load(std::memory_order_acquire) > 0)
+        {
+            std::lock_guard<std::mutex> lock(injectedMutex);
+            if (!injected.empty())
+            {
+                Job *job = injected.front();
+                injected.pop_front();
+                injectedCount.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        unsigned n = threadCount();
+        if (n == 1)
+            return nullptr;
+        thread_local std::minstd_rand rng(std::random_device{}());
+        unsigned start = (unsigned)rng() % n;
+        for (unsigned i = 0; i < n; i++)
+        {
+            unsigned victim = (start + i) % n;
+            if (victim == index)
+                continue;
+            if (Job *job = queues[victim].deque.steal())
+                return job;
+        }
+        return nullptr;
+    }
+
+    void workerLoop(unsigned index)
+    {
+        current() = {this, index};
+        int idle = 0;
+        while (running.load(std::memory_order_relaxed))
+        {
+            if (Job *job = findJob(index))
+            {
+                execute(job);
+                idle = 0;
+                continue;
+            }
+            // spin briefly, then sleep until a new job is pushed
+            if (++idle < 64)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t seen = epoch.load(std::memory_order_acquire);
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            if (Job *job = findJob(index))
+            {
+                sleeping.fetch_sub(1, std::memory_order_relaxed);
+                execute(job);
+                idle = 0;
+                continue;
+            }
+            if (running.load(std::memory_order_relaxed))
+                epoch.wait(seen, std::memory_order_acquire);
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void wake(bool all)
+    {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (all)
+            epoch.notify_all();
+        else if (sleeping.load(std::memory_order_seq_cst) > 0)
+            epoch.notify_one();
+    }
+
+    std::vector<PaddedDeque> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{true};
+    std::atomic<uint32_t> epoch{0};
+    std::atomic<int> sleeping{0};
+
+    std::mutex injectedMutex;
+    std::deque<Job *> injected;
+    std::atomic<int> injectedCount{0};
+};
+
+#endif
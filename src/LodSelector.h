@@ -0,0 +1,83 @@
+#ifndef __LODSELECTOR_H__
+#define __LODSELECTOR_H__
+
+#include "glm/glm.hpp"
+
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Picks a level from a LodChain by how many pixels its geometric error covers on
+// screen. Each level's error is projected with the camera's vertical FOV (Zoom)
+// and viewport height at the distance of the mesh's bounding sphere, and the
+// coarsest level under thresholdPixels wins.
+//
+// To stop a mesh sitting right at a boundary from flipping between two levels
+// every frame, switching has a band of +-hysteresis around the threshold: a mesh
+// only goes coarser once the coarser level is clearly below the threshold and only
+// goes finer once its current level is clearly above it.
+class LodSelector
+{
+public:
+    LodSelector(float thresholdPixels = 1.0f, float hysteresis = 0.25f)
+        : thresholdPixels(thresholdPixels), hysteresis(hysteresis)
+    {
+    }
+
+    // fovY in degrees, as in Camera::Zoom
+    void setProjection(float fovY, int viewportHeight)
+    {
+        pixelsPerUnit = (float)viewportHeight / (2.0f * std::tan(glm::radians(fovY) * 0.5f));
+    }
+
+    void setThreshold(float pixels) { thresholdPixels = pixels; }
+    void setHysteresis(float fraction) { hysteresis = fraction; }
+
+    // Distance from the camera to the surface of the chain's bounding sphere after
+    // scaling and moving it, never below a small minimum
+    static float distance(const LodChain &chain, const glm::vec3 &cameraPosition, const glm::vec3 &worldCenter, float scale = 1.0f)
+    {
+        return std::max(glm::length(worldCenter - cameraPosition) - chain.radius * scale, 1e-3f);
+    }
+
+    // Error in pixels of an object space error seen at distance
+    float projectedError(float error, float distance, float scale = 1.0f) const
+    {
+        return error * scale * pixelsPerUnit / distance;
+    }
+
+    // The level to draw this frame given the one drawn last frame
+    unsigned select(const LodChain &chain, float distance, unsigned current, float scale = 1.0f) const
+    {
+        unsigned last = (unsigned)chain.levels.size() - 1;
+        current = std::min(current, last);
+        float coarsenBelow = thresholdPixels * (1.0f - hysteresis);
+        float refineAbove = thresholdPixels * (1.0f + hysteresis);
+
+        unsigned level = current;
+        while (level < last && projectedError(chain.levels[level + 1].error, distance, scale) <= coarsenBelow)
+            level++;
+        if (level != current)
+            return level;
+        while (level > 0 && projectedError(chain.levels[level].error, distance, scale) > refineAbove)
+            level--;
+        return level;
+    }
+
+    // Without history, e.g. for an object that just came into view
+    unsigned initial(const LodChain &chain, float distance, float scale = 1.0f) const
+    {
+        unsigned level = 0;
+        while (level + 1 < chain.levels.size() && projectedError(chain.levels[level + 1].error, distance, scale) <= thresholdPixels)
+            level++;
+        return level;
+    }
+
+private:
+    float thresholdPixels;
+    float hysteresis;
+    float pixelsPerUnit = 1.0f;
+};
+
+#endif
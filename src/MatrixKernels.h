@@ -0,0 +1,563 @@
+#ifndef __MATRIXKERNELS_H__
+#define __MATRIXKERNELS_H__
+
+#include "CpuFeatures.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Batched matrix and point kernels for the transform hot path, in scalar, SSE4.1
+// and AVX2/FMA versions picked at runtime. Matrices go in and out as glm::mat4, so
+// results can be uploaded or handed back to glm code directly. Everything that
+// benefits from it is laid out as blocks of 8 (AoSoA): one array per component,
+// 8 lanes wide, so 8 objects fill one AVX register and a SSE4.1 pass does two halves.
+
+// 8 translation/rotation/scale transforms, rotation as a unit quaternion
+struct alignas(32) TrsBlock
+{
+    float tx[8], ty[8], tz[8];
+    float qx[8], qy[8], qz[8], qw[8];
+    float sx[8], sy[8], sz[8];
+
+    void set(int lane, const glm::vec3 &translation, const glm::quat &rotation, const glm::vec3 &scale)
+    {
+        tx[lane] = translation.x, ty[lane] = translation.y, tz[lane] = translation.z;
+        qx[lane] = rotation.x, qy[lane] = rotation.y, qz[lane] = rotation.z, qw[lane] = rotation.w;
+        sx[lane] = scale.x, sy[lane] = scale.y, sz[lane] = scale.z;
+    }
+};
+
+// 8 points
+struct alignas(32) Vec3Block
+{
+    float x[8], y[8], z[8];
+
+    void set(int lane, const glm::vec3 &p) { x[lane] = p.x, y[lane] = p.y, z[lane] = p.z; }
+    glm::vec3 get(int lane) const { return glm::vec3(x[lane], y[lane], z[lane]); }
+};
+
+// 8 matrices, element e (column * 4 + row, as in glm) of matrix k in m[e][k]
+struct alignas(32) Mat4Block
+{
+    float m[16][8];
+
+    void set(int lane, const glm::mat4 &matrix)
+    {
+        for (int e = 0; e < 16; e++)
+            m[e][lane] = matrix[e / 4][e % 4];
+    }
+    glm::mat4 get(int lane) const
+    {
+        glm::mat4 matrix;
+        for (int e = 0; e < 16; e++)
+            matrix[e / 4][e % 4] = m[e][lane];
+        return matrix;
+    }
+};
+
+class MatrixKernels
+{
+public:
+    enum class Isa
+    {
+        Scalar,
+        SSE41,
+        AVX2,
+    };
+
+    static Isa best()
+    {
+        if (CpuFeatures::hasAVX2())
+            return Isa::AVX2;
+        if (CpuFeatures::hasSSE41())
+            return Isa::SSE41;
+        return Isa::Scalar;
+    }
+
+    // Isa::AVX2 or Isa::SSE41 on a CPU without them falls back to the next one down
+    explicit MatrixKernels(Isa isa = best())
+    {
+#ifdef LEARNOPENGL_X86
+        if (isa == Isa::AVX2 && CpuFeatures::hasAVX2())
+        {
+            multiplyFn = multiplyAVX2;
+            affineInverseFn = affineInverseAVX2;
+            composeFn = composeAVX2;
+            transformPointsFn = transformPointsAVX2;
+            multiplyBlocksFn = multiplyBlocksAVX2;
+            relativeFn = relativeAVX2;
+            selected = Isa::AVX2;
+        }
+        else if (isa != Isa::Scalar && CpuFeatures::hasSSE41())
+        {
+            multiplyFn = multiplySSE41;
+            affineInverseFn = affineInverseSSE41;
+            composeFn = composeSSE41;
+            transformPointsFn = transformPointsSSE41;
+            multiplyBlocksFn = multiplyBlocksSSE41;
+            relativeFn = relativeSSE41;
+            selected = Isa::SSE41;
+        }
+#else
+        (void)isa;
+#endif
+    }
+
+    Isa isa() const { return selected; }
+
+    // out[i] = a[i] * b[i]
+    void multiply(const glm::mat4 *a, const glm::mat4 *b, glm::mat4 *out, size_t count) const { multiplyFn(a, 1, b, out, count); }
+    // out[i] = a * b[i], e.g. viewProjection * model
+    void multiply(const glm::mat4 &a, const glm::mat4 *b, glm::mat4 *out, size_t count) const { multiplyFn(&a, 0, b, out, count); }
+
+    // Inverse of matrices whose last row is (0, 0, 0, 1): rotation, scale and translation
+    void affineInverse(const glm::mat4 *in, glm::mat4 *out, size_t count) const { affineInverseFn(in, out, count); }
+
+    // out[i] = translate(t) * mat4_cast(q) * scale(s) for the count transforms in blocks
+    void compose(const TrsBlock *blocks, glm::mat4 *out, size_t count) const { composeFn(blocks, out, count); }
+
+    // Affine transform of the points, w taken as 1
+    void transformPoints(const glm::mat4 &m, const Vec3Block *in, Vec3Block *out, size_t blockCount) const { transformPointsFn(m, in, out, blockCount); }
+
+    // out[i] = a[i] * b[i], 8 matrices per block
+    void multiply(const Mat4Block *a, const Mat4Block *b, Mat4Block *out, size_t blockCount) const { multiplyBlocksFn(a, b, out, blockCount); }
+
+    // out[i] = vec3(p[i] - origin) for double positions split into x, y and z arrays.
+    // The difference is taken in double, so only the offset gets rounded to float.
+    void relative(const glm::dvec3 &origin, const double *x, const double *y, const double *z, glm::vec3 *out, size_t count) const
+    {
+        relativeFn(origin, x, y, z, &out[0][0], 3, count);
+    }
+    // The same offsets written as the translation column of out[i], the rest is left alone
+    void relative(const glm::dvec3 &origin, const double *x, const double *y, const double *z, glm::mat4 *out, size_t count) const
+    {
+        relativeFn(origin, x, y, z, &out[0][3][0], 16, count);
+    }
+
+private:
+    using MultiplyFn = void (*)(const glm::mat4 *, size_t, const glm::mat4 *, glm::mat4 *, size_t);
+    using AffineInverseFn = void (*)(const glm::mat4 *, glm::mat4 *, size_t);
+    using ComposeFn = void (*)(const TrsBlock *, glm::mat4 *, size_t);
+    using TransformPointsFn = void (*)(const glm::mat4 &, const Vec3Block *, Vec3Block *, size_t);
+    using MultiplyBlocksFn = void (*)(const Mat4Block *, const Mat4Block *, Mat4Block *, size_t);
+    // stride in floats between outputs: 3 for packed vec3, 16 for a mat4 column, which also gets w = 1
+    using RelativeFn = void (*)(const glm::dvec3 &, const double *, const double *, const double *, float *, size_t, size_t);
+
+    // Scalar versions, the same arithmetic as glm
+
+    static void multiplyScalar(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            out[i] = a[i * aStride] * b[i];
+    }
+
+    static void affineInverseScalar(const glm::mat4 *in, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::vec3 c0(in[i][0]), c1(in[i][1]), c2(in[i][2]), t(in[i][3]);
+            // the rows of the 3x3 inverse are the cross products of the other two columns
+            glm::vec3 r0 = glm::cross(c1, c2), r1 = glm::cross(c2, c0), r2 = glm::cross(c0, c1);
+            float inverseDeterminant = 1.0f / glm::dot(c0, r0);
+            r0 *= inverseDeterminant, r1 *= inverseDeterminant, r2 *= inverseDeterminant;
+            glm::mat4 &o = out[i];
+            o[0] = glm::vec4(r0.x, r1.x, r2.x, 0.0f);
+            o[1] = glm::vec4(r0.y, r1.y, r2.y, 0.0f);
+            o[2] = glm::vec4(r0.z, r1.z, r2.z, 0.0f);
+            o[3] = glm::vec4(-glm::dot(r0, t), -glm::dot(r1, t), -glm::dot(r2, t), 1.0f);
+        }
+    }
+
+    // Element e of transform l of the block, in column-major order
+    static void composeLane(const TrsBlock &b, int l, float *m)
+    {
+        float x = b.qx[l], y = b.qy[l], z = b.qz[l], w = b.qw[l];
+        float xx = x * x, yy = y * y, zz = z * z, xy = x * y, xz = x * z, yz = y * z, wx = w * x, wy = w * y, wz = w * z;
+        m[0] = (1.0f - 2.0f * (yy + zz)) * b.sx[l], m[1] = 2.0f * (xy + wz) * b.sx[l], m[2] = 2.0f * (xz - wy) * b.sx[l], m[3] = 0.0f;
+        m[4] = 2.0f * (xy - wz) * b.sy[l], m[5] = (1.0f - 2.0f * (xx + zz)) * b.sy[l], m[6] = 2.0f * (yz + wx) * b.sy[l], m[7] = 0.0f;
+        m[8] = 2.0f * (xz + wy) * b.sz[l], m[9] = 2.0f * (yz - wx) * b.sz[l], m[10] = (1.0f - 2.0f * (xx + yy)) * b.sz[l], m[11] = 0.0f;
+        m[12] = b.tx[l], m[13] = b.ty[l], m[14] = b.tz[l], m[15] = 1.0f;
+    }
+
+    static void composeScalar(const TrsBlock *blocks, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            composeLane(blocks[i / 8], (int)(i % 8), &out[i][0][0]);
+    }
+
+    static void transformPointsScalar(const glm::mat4 &m, const Vec3Block *in, Vec3Block *out, size_t blockCount)
+    {
+        for (size_t b = 0; b < blockCount; b++)
+            for (int l = 0; l < 8; l++)
+            {
+                float x = in[b].x[l], y = in[b].y[l], z = in[b].z[l];
+                out[b].x[l] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+                out[b].y[l] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+                out[b].z[l] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+            }
+    }
+
+    static void multiplyBlocksScalar(const Mat4Block *a, const Mat4Block *b, Mat4Block *out, size_t blockCount)
+    {
+        for (size_t i = 0; i < blockCount; i++)
+            for (int c = 0; c < 4; c++)
+                for (int r = 0; r < 4; r++)
+                    for (int l = 0; l < 8; l++)
+                        out[i].m[c * 4 + r][l] = a[i].m[r][l] * b[i].m[c * 4][l] + a[i].m[4 + r][l] * b[i].m[c * 4 + 1][l] +
+                                                 a[i].m[8 + r][l] * b[i].m[c * 4 + 2][l] + a[i].m[12 + r][l] * b[i].m[c * 4 + 3][l];
+    }
+
+    static void relativeScalar(const glm::dvec3 &origin, const double *x, const double *y, const double *z, float *out, size_t stride, size_t count)
+    {
+        for (size_t i = 0; i < count; i++, out += stride)
+        {
+            out[0] = (float)(x[i] - origin.x), out[1] = (float)(y[i] - origin.y), out[2] = (float)(z[i] - origin.z);
+            if (stride == 16)
+                out[3] = 1.0f;
+        }
+    }
+
+#ifdef LEARNOPENGL_X86
+    // SSE4.1: one matrix column per register
+
+    TARGET_SSE41 static void multiplySSE41(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *pa = &a[i * aStride][0][0], *pb = &b[i][0][0];
+            __m128 a0 = _mm_loadu_ps(pa), a1 = _mm_loadu_ps(pa + 4), a2 = _mm_loadu_ps(pa + 8), a3 = _mm_loadu_ps(pa + 12);
+            float *po = &out[i][0][0];
+            for (int c = 0; c < 4; c++)
+            {
+                __m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(pb[c * 4])), _mm_mul_ps(a1, _mm_set1_ps(pb[c * 4 + 1]))),
+                                           _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(pb[c * 4 + 2])), _mm_mul_ps(a3, _mm_set1_ps(pb[c * 4 + 3]))));
+                _mm_storeu_ps(po + c * 4, column);
+            }
+        }
+    }
+
+    TARGET_SSE41 static __m128 cross(__m128 a, __m128 b)
+    {
+        __m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+        return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    TARGET_SSE41 static void affineInverseSSE41(const glm::mat4 *in, glm::mat4 *out, size_t count)
+    {
+        const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *p = &in[i][0][0];
+            __m128 c0 = _mm_and_ps(_mm_loadu_ps(p), xyzMask), c1 = _mm_and_ps(_mm_loadu_ps(p + 4), xyzMask);
+            __m128 c2 = _mm_and_ps(_mm_loadu_ps(p + 8), xyzMask), t = _mm_and_ps(_mm_loadu_ps(p + 12), xyzMask);
+            __m128 r0 = cross(c1, c2), r1 = cross(c2, c0), r2 = cross(c0, c1);
+            __m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), _mm_dp_ps(c0, r0, 0x7F));
+            r0 = _mm_mul_ps(r0, inverseDeterminant), r1 = _mm_mul_ps(r1, inverseDeterminant), r2 = _mm_mul_ps(r2, inverseDeterminant);
+            __m128 translation = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f),
+                                            _mm_or_ps(_mm_or_ps(_mm_dp_ps(r0, t, 0x71), _mm_dp_ps(r1, t, 0x72)), _mm_dp_ps(r2, t, 0x74)));
+            __m128 r3 = _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            float *o = &out[i][0][0];
+            _mm_storeu_ps(o, r0), _mm_storeu_ps(o + 4, r1), _mm_storeu_ps(o + 8, r2), _mm_storeu_ps(o + 12, translation);
+        }
+    }
+
+    // Element vectors e[16] of 4 transforms, lanes first..first + 3 of the block
+    TARGET_SSE41 static void composeElementsSSE41(const TrsBlock &b, int first, __m128 e[16])
+    {
+        __m128 x = _mm_load_ps(b.qx + first), y = _mm_load_ps(b.qy + first), z = _mm_load_ps(b.qz + first), w = _mm_load_ps(b.qw + first);
+        __m128 sx = _mm_load_ps(b.sx + first), sy = _mm_load_ps(b.sy + first), sz = _mm_load_ps(b.sz + first);
+        __m128 one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+        e[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        e[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        e[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        e[4] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        e[5] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        e[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        e[8] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        e[9] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        e[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        e[3] = e[7] = e[11] = zero;
+        e[12] = _mm_load_ps(b.tx + first), e[13] = _mm_load_ps(b.ty + first), e[14] = _mm_load_ps(b.tz + first);
+        e[15] = one;
+    }
+
+    TARGET_SSE41 static void composeSSE41(const TrsBlock *blocks, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i += 4)
+        {
+            __m128 e[16];
+            composeElementsSSE41(blocks[i / 8], (int)(i % 8), e);
+            // each column's 4 element vectors transpose into that column of 4 matrices
+            for (int c = 0; c < 4; c++)
+                _MM_TRANSPOSE4_PS(e[c * 4], e[c * 4 + 1], e[c * 4 + 2], e[c * 4 + 3]);
+            size_t n = std::min<size_t>(4, count - i);
+            for (size_t k = 0; k < n; k++)
+                for (int c = 0; c < 4; c++)
+                    _mm_storeu_ps(&out[i + k][c][0], e[c * 4 + k]);
+        }
+    }
+
+    TARGET_SSE41 static void transformPointsSSE41(const glm::mat4 &m, const Vec3Block *in, Vec3Block *out, size_t blockCount)
+    {
+        __m128 e[16];
+        for (int i = 0; i < 16; i++)
+            e[i] = _mm_set1_ps(m[i / 4][i % 4]);
+        for (size_t b = 0; b < blockCount; b++)
+            for (int h = 0; h < 8; h += 4)
+            {
+                __m128 x = _mm_load_ps(in[b].x + h), y = _mm_load_ps(in[b].y + h), z = _mm_load_ps(in[b].z + h);
+                for (int r = 0; r < 3; r++)
+                {
+                    __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e[r], x), _mm_mul_ps(e[4 + r], y)), _mm_add_ps(_mm_mul_ps(e[8 + r], z), e[12 + r]));
+                    _mm_store_ps((r == 0 ? out[b].x : r == 1 ? out[b].y : out[b].z) + h, v);
+                }
+            }
+    }
+
+    TARGET_SSE41 static void multiplyBlocksSSE41(const Mat4Block *a, const Mat4Block *b, Mat4Block *out, size_t blockCount)
+    {
+        for (size_t i = 0; i < blockCount; i++)
+            for (int h = 0; h < 8; h += 4)
+                for (int c = 0; c < 4; c++)
+                {
+                    __m128 b0 = _mm_load_ps(b[i].m[c * 4] + h), b1 = _mm_load_ps(b[i].m[c * 4 + 1] + h);
+                    __m128 b2 = _mm_load_ps(b[i].m[c * 4 + 2] + h), b3 = _mm_load_ps(b[i].m[c * 4 + 3] + h);
+                    for (int r = 0; r < 4; r++)
+                    {
+                        __m128 v = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(a[i].m[r] + h), b0), _mm_mul_ps(_mm_load_ps(a[i].m[4 + r] + h), b1)),
+                                              _mm_add_ps(_mm_mul_ps(_mm_load_ps(a[i].m[8 + r] + h), b2), _mm_mul_ps(_mm_load_ps(a[i].m[12 + r] + h), b3)));
+                        _mm_store_ps(out[i].m[c * 4 + r] + h, v);
+                    }
+                }
+    }
+
+    // 4 offsets per step, transposed to xyzw and stored with 4 wide writes. Packed vec3
+    // writes run one float into the next point, so the last point always goes scalar.
+    TARGET_SSE41 static void relativeSSE41(const glm::dvec3 &origin, const double *x, const double *y, const double *z, float *out, size_t stride, size_t count)
+    {
+        const __m128d ox = _mm_set1_pd(origin.x), oy = _mm_set1_pd(origin.y), oz = _mm_set1_pd(origin.z);
+        const __m128 w = _mm_set1_ps(stride == 16 ? 1.0f : 0.0f);
+        size_t i = 0;
+        for (; i + 4 < count + (stride == 16); i += 4, out += 4 * stride)
+        {
+            __m128 fx = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(x + i), ox)), _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(x + i + 2), ox)));
+            __m128 fy = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(y + i), oy)), _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(y + i + 2), oy)));
+            __m128 fz = _mm_movelh_ps(_mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(z + i), oz)), _mm_cvtpd_ps(_mm_sub_pd(_mm_loadu_pd(z + i + 2), oz)));
+            __m128 fw = w;
+            _MM_TRANSPOSE4_PS(fx, fy, fz, fw);
+            _mm_storeu_ps(out, fx);
+            _mm_storeu_ps(out + stride, fy);
+            _mm_storeu_ps(out + 2 * stride, fz);
+            _mm_storeu_ps(out + 3 * stride, fw);
+        }
+        relativeScalar(origin, x + i, y + i, z + i, out, stride, count - i);
+    }
+
+    // AVX2: two matrix columns, or two matrices, or 8 lanes per register
+
+    // 4 floats into both halves. glm::mat4 is only 4 byte aligned, so load unaligned
+    // rather than through a __m128 pointer.
+    TARGET_AVX2 static __m256 broadcast4(const float *p)
+    {
+        __m128 v = _mm_loadu_ps(p);
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(v), v, 1);
+    }
+
+    TARGET_AVX2 static void multiplyAVX2(const glm::mat4 *a, size_t aStride, const glm::mat4 *b, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const float *pa = &a[i * aStride][0][0], *pb = &b[i][0][0];
+            __m256 a0 = broadcast4(pa), a1 = broadcast4(pa + 4), a2 = broadcast4(pa + 8), a3 = broadcast4(pa + 12);
+            float *po = &out[i][0][0];
+            for (int c = 0; c < 4; c += 2)
+            {
+                // columns c and c + 1 of b, one per 128 bit half
+                __m256 columns = _mm256_loadu_ps(pb + c * 4);
+                __m256 v = _mm256_mul_ps(a0, _mm256_permute_ps(columns, _MM_SHUFFLE(0, 0, 0, 0)));
+                v = _mm256_fmadd_ps(a1, _mm256_permute_ps(columns, _MM_SHUFFLE(1, 1, 1, 1)), v);
+                v = _mm256_fmadd_ps(a2, _mm256_permute_ps(columns, _MM_SHUFFLE(2, 2, 2, 2)), v);
+                v = _mm256_fmadd_ps(a3, _mm256_permute_ps(columns, _MM_SHUFFLE(3, 3, 3, 3)), v);
+                _mm256_storeu_ps(po + c * 4, v);
+            }
+        }
+    }
+
+    TARGET_AVX2 static __m256 cross(__m256 a, __m256 b)
+    {
+        __m256 aYzx = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), bYzx = _mm256_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m256 c = _mm256_fmsub_ps(a, bYzx, _mm256_mul_ps(aYzx, b));
+        return _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    }
+
+    // Two matrices at a time, one per 128 bit half, with the SSE4.1 path's arithmetic
+    TARGET_AVX2 static void affineInverseAVX2(const glm::mat4 *in, glm::mat4 *out, size_t count)
+    {
+        const __m256 xyzMask = _mm256_castsi256_ps(_mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0));
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            const float *p = &in[i][0][0], *q = &in[i + 1][0][0];
+            __m256 c0 = _mm256_and_ps(_mm256_loadu2_m128(q, p), xyzMask), c1 = _mm256_and_ps(_mm256_loadu2_m128(q + 4, p + 4), xyzMask);
+            __m256 c2 = _mm256_and_ps(_mm256_loadu2_m128(q + 8, p + 8), xyzMask), t = _mm256_and_ps(_mm256_loadu2_m128(q + 12, p + 12), xyzMask);
+            __m256 r0 = cross(c1, c2), r1 = cross(c2, c0), r2 = cross(c0, c1);
+            __m256 inverseDeterminant = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_dp_ps(c0, r0, 0x7F));
+            r0 = _mm256_mul_ps(r0, inverseDeterminant), r1 = _mm256_mul_ps(r1, inverseDeterminant), r2 = _mm256_mul_ps(r2, inverseDeterminant);
+            __m256 translation = _mm256_sub_ps(_mm256_setr_ps(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f),
+                                               _mm256_or_ps(_mm256_or_ps(_mm256_dp_ps(r0, t, 0x71), _mm256_dp_ps(r1, t, 0x72)), _mm256_dp_ps(r2, t, 0x74)));
+            // 3x3 transpose in each half, r0..r2 have w = 0
+            __m256 t0 = _mm256_unpacklo_ps(r0, r1), t1 = _mm256_unpacklo_ps(r2, _mm256_setzero_ps());
+            __m256 t2 = _mm256_unpackhi_ps(r0, r1), t3 = _mm256_unpackhi_ps(r2, _mm256_setzero_ps());
+            __m256 o0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 o1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 o2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            float *op = &out[i][0][0], *oq = &out[i + 1][0][0];
+            _mm256_storeu2_m128(oq, op, o0);
+            _mm256_storeu2_m128(oq + 4, op + 4, o1);
+            _mm256_storeu2_m128(oq + 8, op + 8, o2);
+            _mm256_storeu2_m128(oq + 12, op + 12, translation);
+        }
+        if (i < count)
+            affineInverseSSE41(in + i, out + i, count - i);
+    }
+
+    // Transposes 8 registers of 8 floats
+    TARGET_AVX2 static void transpose8(__m256 r[8])
+    {
+        __m256 t[8], u[8];
+        for (int k = 0; k < 8; k += 2)
+        {
+            t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+            t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+        }
+        for (int k = 0; k < 8; k += 4)
+        {
+            u[k] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            u[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            u[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            u[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        for (int k = 0; k < 4; k++)
+        {
+            r[k] = _mm256_permute2f128_ps(u[k], u[k + 4], 0x20);
+            r[k + 4] = _mm256_permute2f128_ps(u[k], u[k + 4], 0x31);
+        }
+    }
+
+    TARGET_AVX2 static void composeAVX2(const TrsBlock *blocks, glm::mat4 *out, size_t count)
+    {
+        for (size_t i = 0; i < count; i += 8)
+        {
+            const TrsBlock &b = blocks[i / 8];
+            __m256 x = _mm256_load_ps(b.qx), y = _mm256_load_ps(b.qy), z = _mm256_load_ps(b.qz), w = _mm256_load_ps(b.qw);
+            __m256 sx = _mm256_load_ps(b.sx), sy = _mm256_load_ps(b.sy), sz = _mm256_load_ps(b.sz);
+            __m256 one = _mm256_set1_ps(1.0f), two = _mm256_set1_ps(2.0f), zero = _mm256_setzero_ps();
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+            // elements 0..7 (columns 0 and 1), then 8..15 (columns 2 and 3)
+            __m256 e[8] = {
+                _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx),
+                _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+                _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+                zero,
+                _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+                _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy),
+                _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+                zero,
+            };
+            __m256 f[8] = {
+                _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+                _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+                _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz),
+                zero,
+                _mm256_load_ps(b.tx),
+                _mm256_load_ps(b.ty),
+                _mm256_load_ps(b.tz),
+                one,
+            };
+            transpose8(e);
+            transpose8(f);
+            size_t n = std::min<size_t>(8, count - i);
+            for (size_t k = 0; k < n; k++)
+            {
+                float *o = &out[i + k][0][0];
+                _mm256_storeu_ps(o, e[k]);
+                _mm256_storeu_ps(o + 8, f[k]);
+            }
+        }
+    }
+
+    TARGET_AVX2 static void transformPointsAVX2(const glm::mat4 &m, const Vec3Block *in, Vec3Block *out, size_t blockCount)
+    {
+        __m256 e[16];
+        for (int i = 0; i < 16; i++)
+            e[i] = _mm256_set1_ps(m[i / 4][i % 4]);
+        for (size_t b = 0; b < blockCount; b++)
+        {
+            __m256 x = _mm256_load_ps(in[b].x), y = _mm256_load_ps(in[b].y), z = _mm256_load_ps(in[b].z);
+            _mm256_store_ps(out[b].x, _mm256_fmadd_ps(e[0], x, _mm256_fmadd_ps(e[4], y, _mm256_fmadd_ps(e[8], z, e[12]))));
+            _mm256_store_ps(out[b].y, _mm256_fmadd_ps(e[1], x, _mm256_fmadd_ps(e[5], y, _mm256_fmadd_ps(e[9], z, e[13]))));
+            _mm256_store_ps(out[b].z, _mm256_fmadd_ps(e[2], x, _mm256_fmadd_ps(e[6], y, _mm256_fmadd_ps(e[10], z, e[14]))));
+        }
+    }
+
+    TARGET_AVX2 static void multiplyBlocksAVX2(const Mat4Block *a, const Mat4Block *b, Mat4Block *out, size_t blockCount)
+    {
+        for (size_t i = 0; i < blockCount; i++)
+        {
+            __m256 av[16];
+            for (int e = 0; e < 16; e++)
+                av[e] = _mm256_load_ps(a[i].m[e]);
+            for (int c = 0; c < 4; c++)
+            {
+                __m256 b0 = _mm256_load_ps(b[i].m[c * 4]), b1 = _mm256_load_ps(b[i].m[c * 4 + 1]);
+                __m256 b2 = _mm256_load_ps(b[i].m[c * 4 + 2]), b3 = _mm256_load_ps(b[i].m[c * 4 + 3]);
+                for (int r = 0; r < 4; r++)
+                    _mm256_store_ps(out[i].m[c * 4 + r],
+                                    _mm256_fmadd_ps(av[r], b0, _mm256_fmadd_ps(av[4 + r], b1, _mm256_fmadd_ps(av[8 + r], b2, _mm256_mul_ps(av[12 + r], b3)))));
+            }
+        }
+    }
+
+    // The SSE4.1 path with the subtraction and conversion 4 doubles at a time
+    TARGET_AVX2 static void relativeAVX2(const glm::dvec3 &origin, const double *x, const double *y, const double *z, float *out, size_t stride, size_t count)
+    {
+        const __m256d ox = _mm256_set1_pd(origin.x), oy = _mm256_set1_pd(origin.y), oz = _mm256_set1_pd(origin.z);
+        const __m128 w = _mm_set1_ps(stride == 16 ? 1.0f : 0.0f);
+        size_t i = 0;
+        for (; i + 4 < count + (stride == 16); i += 4, out += 4 * stride)
+        {
+            __m128 fx = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(x + i), ox));
+            __m128 fy = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(y + i), oy));
+            __m128 fz = _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(z + i), oz));
+            __m128 fw = w;
+            _MM_TRANSPOSE4_PS(fx, fy, fz, fw);
+            _mm_storeu_ps(out, fx);
+            _mm_storeu_ps(out + stride, fy);
+            _mm_storeu_ps(out + 2 * stride, fz);
+            _mm_storeu_ps(out + 3 * stride, fw);
+        }
+        relativeScalar(origin, x + i, y + i, z + i, out, stride, count - i);
+    }
+#endif
+
+    MultiplyFn multiplyFn = multiplyScalar;
+    AffineInverseFn affineInverseFn = affineInverseScalar;
+    ComposeFn composeFn = composeScalar;
+    TransformPointsFn transformPointsFn = transformPointsScalar;
+    MultiplyBlocksFn multiplyBlocksFn = multiplyBlocksScalar;
+    RelativeFn relativeFn = relativeScalar;
+    Isa selected = Isa::Scalar;
+};
+
+#endif
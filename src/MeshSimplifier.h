@@ -0,0 +1,343 @@
+#ifndef __MESHSIMPLIFIER_H__
+#define __MESHSIMPLIFIER_H__
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// One level of detail inside LodChain::indices. error is the geometric error of
+// the level in object space units, 0 for the full mesh.
+struct LodLevel
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;
+};
+
+// Index buffers for every level back to back, all referencing the original vertex
+// buffer, so one VBO and one EBO serve the whole chain. Levels go from full detail
+// to coarsest. center/radius bound the mesh for distance based selection.
+struct LodChain
+{
+    std::vector<uint32_t> indices;
+    std::vector<LodLevel> levels;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    uint32_t triangles(size_t level) const { return levels[level].indexCount / 3; }
+};
+
+// Quadric error metric simplifier (Garland and Heckbert) with half edge collapses:
+// a vertex is always merged into one of its neighbours, never moved, so the result
+// only needs a new index buffer. Open edges (mesh borders and UV or normal seams,
+// which show up as borders in the index topology) get extra constraint planes so
+// they stay put. Collapses that would fold the mesh or flip a triangle are rejected.
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices)
+        : positions(positions), triangles(indices), quadrics(positions.size()), remap(positions.size()),
+          stamp(positions.size(), 0), vertexTriangles(positions.size())
+    {
+        for (uint32_t v = 0; v < positions.size(); v++)
+            remap[v] = v;
+        liveTriangles = indices.size() / 3;
+        removed.assign(liveTriangles, 0);
+
+        std::unordered_map<uint64_t, int> edgeUse;
+        for (uint32_t t = 0; t < liveTriangles; t++)
+        {
+            const uint32_t *tri = &triangles[t * 3];
+            glm::dvec3 p0(positions[tri[0]]), p1(positions[tri[1]]), p2(positions[tri[2]]);
+            glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+            double length = glm::length(n);
+            if (length > 0.0)
+            {
+                n /= length;
+                Quadric q = Quadric::plane(n, -glm::dot(n, p0));
+                for (int k = 0; k < 3; k++)
+                    quadrics[tri[k]].add(q);
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                vertexTriangles[tri[k]].push_back(t);
+                edgeUse[edgeKey(tri[k], tri[(k + 1) % 3])]++;
+            }
+        }
+
+        // a plane through every open edge, perpendicular to its triangle
+        for (uint32_t t = 0; t < liveTriangles; t++)
+        {
+            const uint32_t *tri = &triangles[t * 3];
+            glm::dvec3 p0(positions[tri[0]]), p1(positions[tri[1]]), p2(positions[tri[2]]);
+            glm::dvec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t a = tri[k], b = tri[(k + 1) % 3];
+                if (edgeUse[edgeKey(a, b)] != 1)
+                    continue;
+                glm::dvec3 pa(positions[a]), edge = glm::dvec3(positions[b]) - pa;
+                glm::dvec3 n = glm::cross(edge, faceNormal);
+                double length = glm::length(n);
+                if (length == 0.0)
+                    continue;
+                n /= length;
+                Quadric q = Quadric::plane(n, -glm::dot(n, pa));
+                q.scale(BorderWeight);
+                quadrics[a].add(q);
+                quadrics[b].add(q);
+            }
+        }
+
+        for (uint32_t t = 0; t < liveTriangles; t++)
+            for (int k = 0; k < 3; k++)
+                pushEdge(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3]);
+    }
+
+    // Collapses edges, cheapest first, until at most targetTriangles are left or
+    // nothing can be collapsed any more. Can be called again with a lower target.
+    // Returns the number of triangles left.
+    size_t simplify(size_t targetTriangles)
+    {
+        while (liveTriangles > targetTriangles && !heap.empty())
+        {
+            Collapse c = heap.top();
+            heap.pop();
+            if (remap[c.from] != c.from || remap[c.to] != c.to || stamp[c.from] != c.fromStamp || stamp[c.to] != c.toStamp)
+                continue;
+            if (!collapseIsValid(c.from, c.to))
+                continue;
+            collapse(c.from, c.to);
+            maxError = std::max(maxError, c.cost);
+        }
+        return liveTriangles;
+    }
+
+    // Geometric error so far: the square root of the worst collapse cost, roughly
+    // how far the surface moved in object space units
+    float error() const { return (float)std::sqrt(std::max(maxError, 0.0)); }
+
+    size_t triangleCount() const { return liveTriangles; }
+
+    // Indices of the triangles still alive, into the original vertex buffer
+    void appendIndices(std::vector<uint32_t> &out) const
+    {
+        for (size_t t = 0; t < removed.size(); t++)
+            if (!removed[t])
+                out.insert(out.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+    }
+
+    // Builds the whole chain: every level keeps ratio of the previous one's triangles,
+    // stopping at maxLevels, at minTriangles or when the mesh can't get any simpler
+    static LodChain buildChain(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices,
+                               size_t maxLevels = 6, float ratio = 0.5f, size_t minTriangles = 32)
+    {
+        LodChain chain;
+        glm::vec3 lo(INFINITY), hi(-INFINITY);
+        for (const glm::vec3 &p : positions)
+        {
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+        chain.center = (lo + hi) * 0.5f;
+        for (const glm::vec3 &p : positions)
+            chain.radius = std::max(chain.radius, glm::length(p - chain.center));
+
+        chain.indices = indices;
+        chain.levels.push_back({0, (uint32_t)indices.size(), 0.0f});
+
+        MeshSimplifier simplifier(positions, indices);
+        size_t triangles = simplifier.triangleCount();
+        while (chain.levels.size() < maxLevels && triangles > minTriangles)
+        {
+            size_t target = std::max(minTriangles, (size_t)(triangles * ratio));
+            size_t left = simplifier.simplify(target);
+            // stalled well short of the target, another level would barely differ
+            if (left > triangles - (triangles - target) / 2)
+                break;
+            LodLevel level;
+            level.indexOffset = (uint32_t)chain.indices.size();
+            simplifier.appendIndices(chain.indices);
+            level.indexCount = (uint32_t)chain.indices.size() - level.indexOffset;
+            level.error = simplifier.error();
+            chain.levels.push_back(level);
+            triangles = left;
+        }
+        return chain;
+    }
+
+private:
+    static constexpr double BorderWeight = 100.0;
+
+    // Symmetric 4x4 matrix of the plane equations summed so far, v^T Q v is the sum
+    // of squared distances of v to those planes
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        static Quadric plane(const glm::dvec3 &n, double d)
+        {
+            Quadric q;
+            q.a2 = n.x * n.x, q.ab = n.x * n.y, q.ac = n.x * n.z, q.ad = n.x * d;
+            q.b2 = n.y * n.y, q.bc = n.y * n.z, q.bd = n.y * d;
+            q.c2 = n.z * n.z, q.cd = n.z * d;
+            q.d2 = d * d;
+            return q;
+        }
+
+        void add(const Quadric &q)
+        {
+            a2 += q.a2, ab += q.ab, ac += q.ac, ad += q.ad, b2 += q.b2;
+            bc += q.bc, bd += q.bd, c2 += q.c2, cd += q.cd, d2 += q.d2;
+        }
+
+        void scale(double s)
+        {
+            a2 *= s, ab *= s, ac *= s, ad *= s, b2 *= s;
+            bc *= s, bd *= s, c2 *= s, cd *= s, d2 *= s;
+        }
+
+        double evaluate(const glm::dvec3 &p) const
+        {
+            return a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x +
+                   b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y +
+                   c2 * p.z * p.z + 2.0 * cd * p.z + d2;
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from, to;
+        uint32_t fromStamp, toStamp;
+
+        bool operator>(const Collapse &other) const { return cost > other.cost; }
+    };
+
+    static uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+    }
+
+    // Queues the cheaper direction of the edge, stale entries are skipped when popped
+    void pushEdge(uint32_t a, uint32_t b)
+    {
+        Quadric q = quadrics[a];
+        q.add(quadrics[b]);
+        double toB = q.evaluate(glm::dvec3(positions[b]));
+        double toA = q.evaluate(glm::dvec3(positions[a]));
+        if (toB <= toA)
+            heap.push({toB, a, b, stamp[a], stamp[b]});
+        else
+            heap.push({toA, b, a, stamp[b], stamp[a]});
+    }
+
+    // The edge may only go if from and to share no neighbours besides the third
+    // corners of their shared triangles (otherwise the mesh folds onto itself), and
+    // moving from onto to must not turn any of from's remaining triangles over
+    bool collapseIsValid(uint32_t from, uint32_t to)
+    {
+        size_t shared = 0;
+        neighbours.clear();
+        for (uint32_t t : vertexTriangles[from])
+        {
+            if (removed[t])
+                continue;
+            const uint32_t *tri = &triangles[t * 3];
+            shared += tri[0] == to || tri[1] == to || tri[2] == to;
+            for (int k = 0; k < 3; k++)
+                if (tri[k] != from && tri[k] != to)
+                    neighbours.push_back(tri[k]);
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        size_t common = 0;
+        for (uint32_t t : vertexTriangles[to])
+        {
+            if (removed[t])
+                continue;
+            const uint32_t *tri = &triangles[t * 3];
+            for (int k = 0; k < 3; k++)
+                if (tri[k] != to && std::binary_search(neighbours.begin(), neighbours.end(), tri[k]))
+                {
+                    common++;
+                    // counted once per vertex
+                    neighbours.erase(std::lower_bound(neighbours.begin(), neighbours.end(), tri[k]));
+                }
+        }
+        if (common != shared)
+            return false;
+
+        glm::vec3 target = positions[to];
+        for (uint32_t t : vertexTriangles[from])
+        {
+            if (removed[t])
+                continue;
+            const uint32_t *tri = &triangles[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue;
+            glm::vec3 p[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+            glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            for (int k = 0; k < 3; k++)
+                if (tri[k] == from)
+                    p[k] = target;
+            glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+            if (glm::dot(before, after) <= 0.2f * glm::length(before) * glm::length(after))
+                return false;
+        }
+        return true;
+    }
+
+    void collapse(uint32_t from, uint32_t to)
+    {
+        remap[from] = to;
+        quadrics[to].add(quadrics[from]);
+        stamp[to]++;
+        for (uint32_t t : vertexTriangles[from])
+        {
+            if (removed[t])
+                continue;
+            uint32_t *tri = &triangles[t * 3];
+            for (int k = 0; k < 3; k++)
+                if (tri[k] == from)
+                    tri[k] = to;
+            if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+            {
+                removed[t] = 1;
+                liveTriangles--;
+            }
+            else
+                vertexTriangles[to].push_back(t);
+        }
+        vertexTriangles[from].clear();
+
+        // drop dead triangles from the survivor's list and requeue its edges with the new quadric
+        std::vector<uint32_t> &list = vertexTriangles[to];
+        list.erase(std::remove_if(list.begin(), list.end(), [&](uint32_t t)
+                                  { return removed[t] != 0; }),
+                   list.end());
+        for (uint32_t t : list)
+            for (int k = 0; k < 3; k++)
+                if (triangles[t * 3 + k] != to)
+                    pushEdge(to, triangles[t * 3 + k]);
+    }
+
+    const std::vector<glm::vec3> &positions;
+    std::vector<uint32_t> triangles;
+    std::vector<uint8_t> removed;
+    std::vector<Quadric> quadrics;
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> stamp;
+    std::vector<std::vector<uint32_t>> vertexTriangles;
+    std::vector<uint32_t> neighbours;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+    size_t liveTriangles = 0;
+    double maxError = 0.0;
+};
+
+#endif
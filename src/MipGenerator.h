@@ -0,0 +1,410 @@
+#ifndef __MIPGENERATOR_H__
+#define __MIPGENERATOR_H__
+
+#include "glad/glad.h"
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
+
+// CPU mip chain generation, to replace glGenerateMipmap on the GL thread.
+//
+// Colour channels are decoded from sRGB to linear before filtering and encoded
+// again afterwards, so lower levels keep the right brightness. For cutout
+// textures the alpha of each level is rescaled so the fraction of texels that
+// pass the alpha test stays the same as in level 0, instead of thinning out.
+
+enum class MipFilter
+{
+    Box,   // 2x2 average, AVX2 when available
+    Kaiser // Kaiser windowed sinc, sharper but slower
+};
+
+struct MipOptions
+{
+    bool srgb = true;         // colour data is sRGB encoded
+    MipFilter filter = MipFilter::Box;
+    float alphaCutoff = 0.0f; // alpha test reference to preserve coverage for, 0 disables
+    int maxLevels = 0;        // 0 generates down to 1x1
+    unsigned threads = 0;     // worker threads per level, 0 uses every core
+};
+
+// RGBA8 levels, largest first
+struct MipChain
+{
+    struct Level
+    {
+        int width, height;
+        std::vector<unsigned char> pixels;
+    };
+    std::vector<Level> levels;
+
+    // Cooked file layout: "MIP1", level count, then per level width, height and pixels
+    bool save(const char *path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        uint32_t count = (uint32_t)levels.size();
+        file.write("MIP1", 4);
+        file.write((const char *)&count, sizeof(count));
+        for (const Level &level : levels)
+        {
+            uint32_t size[2] = {(uint32_t)level.width, (uint32_t)level.height};
+            file.write((const char *)size, sizeof(size));
+            file.write((const char *)level.pixels.data(), level.pixels.size());
+        }
+        return (bool)file;
+    }
+
+    // Largest level 0 side load() accepts
+    static constexpr uint32_t MaxDimension = 16384;
+
+    // Rejects a header that doesn't describe a proper chain (level 0 within
+    // MaxDimension, every level half the one before, no more levels than down to
+    // 1x1) before allocating anything for it, so a corrupt file can't ask for gigabytes
+    bool load(const char *path)
+    {
+        levels.clear();
+        std::ifstream file(path, std::ios::binary);
+        char magic[4];
+        uint32_t count = 0;
+        if (!file.read(magic, 4) || memcmp(magic, "MIP1", 4) != 0 || !file.read((char *)&count, sizeof(count)))
+            return false;
+        if (count == 0 || count > maxLevels(MaxDimension, MaxDimension))
+            return false;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t size[2];
+            if (!file.read((char *)size, sizeof(size)))
+                return false;
+            if (i == 0)
+            {
+                if (size[0] == 0 || size[1] == 0 || size[0] > MaxDimension || size[1] > MaxDimension || count > maxLevels(size[0], size[1]))
+                    return false;
+            }
+            else if ((int)size[0] != std::max(1, levels.back().width / 2) || (int)size[1] != std::max(1, levels.back().height / 2))
+                return false;
+            Level level{(int)size[0], (int)size[1], std::vector<unsigned char>((size_t)size[0] * size[1] * 4)};
+            if (!file.read((char *)level.pixels.data(), level.pixels.size()))
+                return false;
+            levels.push_back(std::move(level));
+        }
+        return true;
+    }
+
+    // 1 + log2 of the larger side
+    static uint32_t maxLevels(uint32_t width, uint32_t height)
+    {
+        uint32_t count = 1;
+        for (uint32_t side = std::max(width, height); side > 1; side /= 2)
+            count++;
+        return count;
+    }
+};
+
+class MipGenerator
+{
+public:
+    // Builds the chain for an RGBA8 image. Safe to call from any thread, it never touches GL.
+    static MipChain generate(const unsigned char *rgba, int width, int height, const MipOptions &options = MipOptions())
+    {
+        MipChain chain;
+        unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+        chain.levels.push_back({width, height, std::vector<unsigned char>(rgba, rgba + (size_t)width * height * 4)});
+
+        std::vector<float> current((size_t)width * height * 4);
+        parallelRows(height, threads, [&](int y0, int y1)
+                     { decode(rgba + (size_t)y0 * width * 4, current.data() + (size_t)y0 * width * 4, (size_t)(y1 - y0) * width, options.srgb); });
+
+        float targetCoverage = options.alphaCutoff > 0.0f ? coverage(current, 1.0f, options.alphaCutoff) : 0.0f;
+
+        std::vector<float> next, scratch;
+        int w = width, h = height;
+        while ((w > 1 || h > 1) && (options.maxLevels == 0 || (int)chain.levels.size() < options.maxLevels))
+        {
+            int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+            next.resize((size_t)nw * nh * 4);
+            if (options.filter == MipFilter::Kaiser)
+                kaiserDownsample(current.data(), w, h, next.data(), nw, nh, scratch, threads);
+            else
+                boxDownsample(current.data(), w, h, next.data(), nw, nh, threads);
+
+            float alphaScale = 1.0f;
+            if (options.alphaCutoff > 0.0f)
+                alphaScale = coverageScale(next, options.alphaCutoff, targetCoverage);
+
+            MipChain::Level level{nw, nh, std::vector<unsigned char>((size_t)nw * nh * 4)};
+            parallelRows(nh, threads, [&](int y0, int y1)
+                         { encode(next.data() + (size_t)y0 * nw * 4, level.pixels.data() + (size_t)y0 * nw * 4, (size_t)(y1 - y0) * nw, options.srgb, alphaScale); });
+            chain.levels.push_back(std::move(level));
+
+            current.swap(next);
+            w = nw;
+            h = nh;
+        }
+        return chain;
+    }
+
+    // Runs generate() on a loader thread
+    static std::future<MipChain> generateAsync(std::vector<unsigned char> rgba, int width, int height, MipOptions options = MipOptions())
+    {
+        return std::async(std::launch::async, [rgba = std::move(rgba), width, height, options]()
+                          { return generate(rgba.data(), width, height, options); });
+    }
+
+private:
+    template <typename F>
+    static void parallelRows(int rows, unsigned threads, F &&fn)
+    {
+        // small levels aren't worth waking threads for
+        unsigned count = std::min<unsigned>(threads, (unsigned)std::max(1, rows / 16));
+        if (count <= 1)
+        {
+            fn(0, rows);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < count; t++)
+            workers.emplace_back([&, t]
+                                 { fn((int)(rows * t / count), (int)(rows * (t + 1) / count)); });
+        fn(0, (int)(rows / count));
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    static const float *srgbToLinearTable()
+    {
+        static const std::vector<float> table = []
+        {
+            std::vector<float> t(256);
+            for (int i = 0; i < 256; i++)
+            {
+                float c = i / 255.0f;
+                t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    static constexpr int EncodeTableSize = 8192;
+
+    static const unsigned char *linearToSrgbTable()
+    {
+        static const std::vector<unsigned char> table = []
+        {
+            std::vector<unsigned char> t(EncodeTableSize);
+            for (int i = 0; i < EncodeTableSize; i++)
+            {
+                float l = (i + 0.5f) / EncodeTableSize;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                t[i] = (unsigned char)std::clamp((int)(c * 255.0f + 0.5f), 0, 255);
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    static void decode(const unsigned char *src, float *dst, size_t pixels, bool srgb)
+    {
+        const float *table = srgbToLinearTable();
+        for (size_t i = 0; i < pixels * 4; i += 4)
+        {
+            for (int c = 0; c < 3; c++)
+                dst[i + c] = srgb ? table[src[i + c]] : src[i + c] / 255.0f;
+            dst[i + 3] = src[i + 3] / 255.0f;
+        }
+    }
+
+    static void encode(const float *src, unsigned char *dst, size_t pixels, bool srgb, float alphaScale)
+    {
+        const unsigned char *table = linearToSrgbTable();
+        for (size_t i = 0; i < pixels * 4; i += 4)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                float v = std::clamp(src[i + c], 0.0f, 1.0f);
+                dst[i + c] = srgb ? table[std::min((int)(v * EncodeTableSize), EncodeTableSize - 1)] : (unsigned char)(v * 255.0f + 0.5f);
+            }
+            dst[i + 3] = (unsigned char)(std::clamp(src[i + 3] * alphaScale, 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    static float coverage(const std::vector<float> &level, float alphaScale, float cutoff)
+    {
+        size_t passed = 0, pixels = level.size() / 4;
+        for (size_t i = 3; i < level.size(); i += 4)
+            passed += level[i] * alphaScale > cutoff;
+        return pixels ? (float)passed / pixels : 0.0f;
+    }
+
+    // Binary searches the alpha scale that brings this level's coverage back to the target
+    static float coverageScale(const std::vector<float> &level, float cutoff, float target)
+    {
+        float lo = 0.0f, hi = 4.0f, scale = 1.0f;
+        for (int i = 0; i < 12; i++)
+        {
+            scale = 0.5f * (lo + hi);
+            float c = coverage(level, scale, cutoff);
+            if (c < target)
+                lo = scale;
+            else
+                hi = scale;
+        }
+        return scale;
+    }
+
+    static void boxDownsample(const float *src, int w, int h, float *dst, int nw, int nh, unsigned threads)
+    {
+        bool avx2 = CpuFeatures::hasAVX2() && w >= 2;
+        parallelRows(nh, threads, [&](int y0, int y1)
+                     {
+            for (int y = y0; y < y1; y++)
+            {
+                const float *row0 = src + (size_t)std::min(2 * y, h - 1) * w * 4;
+                const float *row1 = src + (size_t)std::min(2 * y + 1, h - 1) * w * 4;
+                float *out = dst + (size_t)y * nw * 4;
+                int x = 0;
+#ifdef LEARNOPENGL_X86
+                if (avx2)
+                    x = boxRowAVX2(row0, row1, out, nw);
+#endif
+                for (; x < nw; x++)
+                {
+                    int sx0 = std::min(2 * x, w - 1) * 4, sx1 = std::min(2 * x + 1, w - 1) * 4;
+                    for (int c = 0; c < 4; c++)
+                        out[x * 4 + c] = 0.25f * (row0[sx0 + c] + row0[sx1 + c] + row1[sx0 + c] + row1[sx1 + c]);
+                }
+            } });
+    }
+
+#ifdef LEARNOPENGL_X86
+    // Two output texels per iteration: four source texels from each row are summed
+    // vertically, then neighbouring pairs are added across the 128-bit lanes.
+    // Returns how many outputs were written, the caller finishes the tail.
+    TARGET_AVX2 static int boxRowAVX2(const float *row0, const float *row1, float *out, int nw)
+    {
+        const __m256 quarter = _mm256_set1_ps(0.25f);
+        int x = 0;
+        for (; x + 2 <= nw; x += 2)
+        {
+            const float *a = row0 + x * 8;
+            const float *b = row1 + x * 8;
+            __m256 s01 = _mm256_add_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b));         // texels 0,1
+            __m256 s23 = _mm256_add_ps(_mm256_loadu_ps(a + 8), _mm256_loadu_ps(b + 8)); // texels 2,3
+            __m256 even = _mm256_permute2f128_ps(s01, s23, 0x20);                       // 0,2
+            __m256 odd = _mm256_permute2f128_ps(s01, s23, 0x31);                        // 1,3
+            _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(even, odd), quarter));
+        }
+        return x;
+    }
+#endif
+
+    static float bessel0(float x)
+    {
+        float sum = 1.0f, term = 1.0f, half = x * 0.5f;
+        for (int k = 1; k < 20; k++)
+        {
+            term *= (half / k) * (half / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Weights for resampling one axis from size to newSize, taps entries per output texel
+    static std::vector<float> kaiserWeights(int size, int newSize, int taps, std::vector<int> &firstTap)
+    {
+        const float alpha = 4.0f, radius = taps * 0.5f;
+        float scale = (float)size / newSize;
+        std::vector<float> weights((size_t)newSize * taps);
+        firstTap.resize(newSize);
+        for (int i = 0; i < newSize; i++)
+        {
+            float center = (i + 0.5f) * scale;
+            int first = (int)std::floor(center - radius + 0.5f);
+            firstTap[i] = first;
+            float total = 0.0f;
+            for (int t = 0; t < taps; t++)
+            {
+                float d = (first + t + 0.5f - center) / scale;
+                float sinc = std::abs(d) < 1e-5f ? 1.0f : std::sin(3.14159265f * d) / (3.14159265f * d);
+                float r = d / (radius / scale);
+                float window = std::abs(r) >= 1.0f ? 0.0f : bessel0(alpha * std::sqrt(1.0f - r * r)) / bessel0(alpha);
+                weights[(size_t)i * taps + t] = sinc * window;
+                total += sinc * window;
+            }
+            for (int t = 0; t < taps; t++)
+                weights[(size_t)i * taps + t] /= total;
+        }
+        return weights;
+    }
+
+    // Separable filter: horizontal into scratch, then vertical into dst. Each texel
+    // is one 4 float register on x86, so every tap is a single SSE multiply and add.
+    static void kaiserDownsample(const float *src, int w, int h, float *dst, int nw, int nh, std::vector<float> &scratch, unsigned threads)
+    {
+        const int taps = 8;
+        std::vector<int> firstX, firstY;
+        std::vector<float> wx = kaiserWeights(w, nw, taps, firstX);
+        std::vector<float> wy = kaiserWeights(h, nh, taps, firstY);
+        scratch.resize((size_t)nw * h * 4);
+        float *horizontal = scratch.data();
+
+        parallelRows(h, threads, [&](int y0, int y1)
+                     {
+            for (int y = y0; y < y1; y++)
+                for (int x = 0; x < nw; x++)
+                {
+                    float acc[4] = {};
+                    for (int t = 0; t < taps; t++)
+                        accumulate(acc, src + ((size_t)y * w + std::clamp(firstX[x] + t, 0, w - 1)) * 4, wx[(size_t)x * taps + t]);
+                    memcpy(horizontal + ((size_t)y * nw + x) * 4, acc, sizeof(acc));
+                } });
+
+        parallelRows(nh, threads, [&](int y0, int y1)
+                     {
+            for (int y = y0; y < y1; y++)
+                for (int x = 0; x < nw; x++)
+                {
+                    float acc[4] = {};
+                    for (int t = 0; t < taps; t++)
+                        accumulate(acc, horizontal + ((size_t)std::clamp(firstY[y] + t, 0, h - 1) * nw + x) * 4, wy[(size_t)y * taps + t]);
+                    for (int c = 0; c < 4; c++)
+                        acc[c] = std::max(acc[c], 0.0f); // negative lobes can undershoot
+                    memcpy(dst + ((size_t)y * nw + x) * 4, acc, sizeof(acc));
+                } });
+    }
+
+    static void accumulate(float *acc, const float *texel, float weight)
+    {
+#ifdef LEARNOPENGL_X86
+        _mm_storeu_ps(acc, _mm_add_ps(_mm_loadu_ps(acc), _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(weight))));
+#else
+        for (int c = 0; c < 4; c++)
+            acc[c] += texel[c] * weight;
+#endif
+    }
+};
+
+// Uploads every level of the chain to the currently bound 2D texture target
+inline void uploadMipChain(GLenum target, const MipChain &chain)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t level = 0; level < chain.levels.size(); level++)
+    {
+        const MipChain::Level &l = chain.levels[level];
+        glTexImage2D(target, (GLint)level, GL_RGBA8, l.width, l.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, l.pixels.data());
+    }
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, (GLint)chain.levels.size() - 1);
+}
+
+#endif
@@ -0,0 +1,301 @@
+#ifndef __OCCLUSIONCULLER_H__
+#define __OCCLUSIONCULLER_H__
+
+#include "glm/glm.hpp"
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Software occlusion culling against a small CPU depth buffer.
+//
+//     culler.begin(projection * view);
+//     culler.addOccluderBox(model, min, max);   // a few big, close objects
+//     culler.finish();                          // builds the depth pyramid
+//     if (culler.isVisible(worldMin, worldMax)) ...
+//
+// Occluders are rasterized inner-conservatively: a pixel is only written when the
+// triangle covers all of it, with the farthest depth the triangle has inside it.
+// So the buffer never claims more is hidden than really is, and an object is only
+// culled when its nearest point is behind everything drawn over its whole screen
+// rectangle. Each pyramid level keeps the nearest and farthest depth of 2x2 texels
+// below it: a test starts where the rectangle spans a couple of texels, culls if
+// the object is behind every farthest depth, accepts if it is in front of every
+// nearest one, and only looks at finer levels in between.
+class OcclusionCuller
+{
+public:
+    // width is rounded up to a multiple of 8, the rasterizer's span
+    explicit OcclusionCuller(int width = 256, int height = 128) : width((width + 7) & ~7), height(height)
+    {
+        for (int w = this->width, h = height;; w = (w + 1) / 2, h = (h + 1) / 2)
+        {
+            levels.push_back({w, h, std::vector<float>((size_t)w * h), std::vector<float>((size_t)w * h)});
+            if (w == 1 && h == 1)
+                break;
+        }
+#ifdef LEARNOPENGL_X86
+        if (CpuFeatures::hasAVX2())
+            rasterSpan = rasterSpanAVX2;
+        else if (CpuFeatures::hasSSE41())
+            rasterSpan = rasterSpanSSE41;
+#endif
+    }
+
+    void begin(const glm::mat4 &viewProjection)
+    {
+        this->viewProjection = viewProjection;
+        std::fill(levels[0].maxDepth.begin(), levels[0].maxDepth.end(), 1.0f);
+        occluderTriangles = 0;
+    }
+
+    // Indexed triangles in model space
+    void addOccluder(const glm::vec3 *positions, const uint32_t *indices, size_t indexCount, const glm::mat4 &model)
+    {
+        glm::mat4 mvp = viewProjection * model;
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+            rasterizeTriangle(mvp * glm::vec4(positions[indices[i]], 1.0f), mvp * glm::vec4(positions[indices[i + 1]], 1.0f),
+                              mvp * glm::vec4(positions[indices[i + 2]], 1.0f));
+    }
+
+    // The 12 triangles of a box, in model space
+    void addOccluderBox(const glm::mat4 &model, const glm::vec3 &min, const glm::vec3 &max)
+    {
+        static const uint32_t boxIndices[36] = {0, 1, 3, 0, 3, 2, 4, 6, 7, 4, 7, 5, 0, 4, 5, 0, 5, 1,
+                                                2, 3, 7, 2, 7, 6, 0, 2, 6, 0, 6, 4, 1, 5, 7, 1, 7, 3};
+        glm::vec3 corners[8];
+        for (int c = 0; c < 8; c++)
+            corners[c] = glm::vec3(c & 4 ? max.x : min.x, c & 2 ? max.y : min.y, c & 1 ? max.z : min.z);
+        addOccluder(corners, boxIndices, 36, model);
+    }
+
+    // Builds the min/max pyramid, call after the last occluder
+    void finish()
+    {
+        std::copy(levels[0].maxDepth.begin(), levels[0].maxDepth.end(), levels[0].minDepth.begin());
+        for (size_t l = 1; l < levels.size(); l++)
+        {
+            const Level &fine = levels[l - 1];
+            Level &coarse = levels[l];
+            for (int y = 0; y < coarse.height; y++)
+                for (int x = 0; x < coarse.width; x++)
+                {
+                    // odd sized levels repeat their last row/column
+                    int x0 = 2 * x, x1 = std::min(2 * x + 1, fine.width - 1);
+                    int y0 = 2 * y, y1 = std::min(2 * y + 1, fine.height - 1);
+                    size_t a = (size_t)y0 * fine.width + x0, b = (size_t)y0 * fine.width + x1;
+                    size_t c = (size_t)y1 * fine.width + x0, d = (size_t)y1 * fine.width + x1;
+                    coarse.minDepth[(size_t)y * coarse.width + x] = std::min({fine.minDepth[a], fine.minDepth[b], fine.minDepth[c], fine.minDepth[d]});
+                    coarse.maxDepth[(size_t)y * coarse.width + x] = std::max({fine.maxDepth[a], fine.maxDepth[b], fine.maxDepth[c], fine.maxDepth[d]});
+                }
+        }
+    }
+
+    // World space box against the pyramid, false when it is hidden or off screen.
+    // Safe to call from several threads at once between finish() and the next begin().
+    bool isVisible(const glm::vec3 &min, const glm::vec3 &max) const { return testBox(viewProjection, min, max); }
+
+    // Model space box, transformed by model, so rotated objects are tested by their own bounds
+    bool isVisible(const glm::mat4 &model, const glm::vec3 &min, const glm::vec3 &max) const { return testBox(viewProjection * model, min, max); }
+
+    int bufferWidth() const { return width; }
+    int bufferHeight() const { return height; }
+    // farthest occluder depth per pixel, 1 where nothing was drawn
+    const std::vector<float> &depth() const { return levels[0].maxDepth; }
+    size_t rasterizedTriangles() const { return occluderTriangles; }
+
+private:
+    struct Level
+    {
+        int width, height;
+        std::vector<float> minDepth, maxDepth;
+    };
+
+    // edge and depth planes of one triangle, value = a * x + b * y + c at pixel centres
+    struct Setup
+    {
+        float a[3], b[3], c[3];
+        float za, zb, zc;
+    };
+
+    using RasterSpanFn = void (*)(const Setup &, int y, int x0, int x1, float *row);
+
+    static constexpr float NearW = 1e-4f;
+
+    bool testBox(const glm::mat4 &mvp, const glm::vec3 &min, const glm::vec3 &max) const
+    {
+        float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 1e30f;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec4 p = mvp * glm::vec4(c & 4 ? max.x : min.x, c & 2 ? max.y : min.y, c & 1 ? max.z : min.z, 1.0f);
+            // crosses the near plane, too close to judge
+            if (p.w <= NearW)
+                return true;
+            float invW = 1.0f / p.w;
+            float sx = (p.x * invW * 0.5f + 0.5f) * width, sy = (0.5f - p.y * invW * 0.5f) * height;
+            minX = std::min(minX, sx);
+            maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy);
+            maxY = std::max(maxY, sy);
+            nearest = std::min(nearest, p.z * invW * 0.5f + 0.5f);
+        }
+        if (maxX < 0.0f || maxY < 0.0f || minX > width || minY > height || nearest > 1.0f)
+            return false;
+        int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(width - 1, (int)std::floor(maxX));
+        int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(height - 1, (int)std::floor(maxY));
+
+        // start at the level where the rectangle spans at most 2x2 texels
+        int level = 0;
+        while (level + 1 < (int)levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1))
+            level++;
+        return visibleAt(level, x0, y0, x1, y1, nearest);
+    }
+
+    // rectangle in level 0 pixels (inclusive), tested against the texels of level
+    bool visibleAt(int level, int x0, int y0, int x1, int y1, float nearest) const
+    {
+        const Level &l = levels[level];
+        for (int y = y0 >> level; y <= y1 >> level; y++)
+            for (int x = x0 >> level; x <= x1 >> level; x++)
+            {
+                size_t i = (size_t)y * l.width + x;
+                // behind everything in this texel
+                if (nearest > l.maxDepth[i])
+                    continue;
+                // in front of everything here, or nothing finer to look at
+                if (level == 0 || nearest <= l.minDepth[i])
+                    return true;
+                // in between: look at the part of the rectangle inside this texel one level down
+                int cx0 = std::max(x0, x << level), cx1 = std::min(x1, ((x + 1) << level) - 1);
+                int cy0 = std::max(y0, y << level), cy1 = std::min(y1, ((y + 1) << level) - 1);
+                if (visibleAt(level - 1, cx0, cy0, cx1, cy1, nearest))
+                    return true;
+            }
+        return false;
+    }
+
+    void rasterizeTriangle(glm::vec4 p0, glm::vec4 p1, glm::vec4 p2)
+    {
+        // dropping an occluder only means less gets culled, so skip anything crossing the near plane
+        if (p0.w <= NearW || p1.w <= NearW || p2.w <= NearW)
+            return;
+        glm::vec4 clip[3] = {p0, p1, p2};
+        float x[3], y[3], z[3];
+        for (int i = 0; i < 3; i++)
+        {
+            float invW = 1.0f / clip[i].w;
+            x[i] = (clip[i].x * invW * 0.5f + 0.5f) * width;
+            y[i] = (0.5f - clip[i].y * invW * 0.5f) * height;
+            z[i] = clip[i].z * invW * 0.5f + 0.5f;
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if (area == 0.0f)
+            return;
+        if (area < 0.0f)
+        {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(z[1], z[2]);
+            area = -area;
+        }
+
+        int minX = std::max(0, (int)std::floor(std::min({x[0], x[1], x[2]})));
+        int maxX = std::min(width - 1, (int)std::ceil(std::max({x[0], x[1], x[2]})));
+        int minY = std::max(0, (int)std::floor(std::min({y[0], y[1], y[2]})));
+        int maxY = std::min(height - 1, (int)std::ceil(std::max({y[0], y[1], y[2]})));
+        if (minX > maxX || minY > maxY)
+            return;
+
+        Setup s;
+        float invArea = 1.0f / area;
+        s.za = s.zb = s.zc = 0.0f;
+        for (int i = 0; i < 3; i++)
+        {
+            // edge from vertex j to k, >= 0 inside and weighing vertex i
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            float dx = x[k] - x[j], dy = y[k] - y[j];
+            s.a[i] = -dy;
+            s.b[i] = dx;
+            // at pixel centres, pulled in by half a pixel so only fully covered pixels pass
+            s.c[i] = dy * x[j] - dx * y[j] + 0.5f * (dx - dy) - 0.5f * (std::abs(dx) + std::abs(dy));
+            float weightA = -dy * invArea, weightB = dx * invArea, weightC = (dy * x[j] - dx * y[j] + 0.5f * (dx - dy)) * invArea;
+            s.za += weightA * z[i];
+            s.zb += weightB * z[i];
+            s.zc += weightC * z[i];
+        }
+        // farthest depth anywhere inside the pixel rather than at its centre
+        s.zc += 0.5f * (std::abs(s.za) + std::abs(s.zb));
+
+        for (int py = minY; py <= maxY; py++)
+            rasterSpan(s, py, minX & ~7, maxX, &levels[0].maxDepth[(size_t)py * width]);
+        occluderTriangles++;
+    }
+
+    static void rasterSpanScalar(const Setup &s, int y, int x0, int x1, float *row)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            float fx = (float)x, fy = (float)y;
+            if (s.a[0] * fx + s.b[0] * fy + s.c[0] >= 0.0f && s.a[1] * fx + s.b[1] * fy + s.c[1] >= 0.0f && s.a[2] * fx + s.b[2] * fy + s.c[2] >= 0.0f)
+                row[x] = std::min(row[x], s.za * fx + s.zb * fy + s.zc);
+        }
+    }
+
+#ifdef LEARNOPENGL_X86
+    TARGET_AVX2 static void rasterSpanAVX2(const Setup &s, int y, int x0, int x1, float *row)
+    {
+        const float fy = (float)y;
+        __m256 px = _mm256_add_ps(_mm256_set1_ps((float)x0), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m256 step = _mm256_set1_ps(8.0f);
+        const __m256 zero = _mm256_setzero_ps();
+        for (int x = x0; x <= x1; x += 8, px = _mm256_add_ps(px, step))
+        {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int i = 0; i < 3; i++)
+            {
+                __m256 e = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(s.a[i])), _mm256_set1_ps(s.b[i] * fy + s.c[i]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(e, zero, _CMP_GE_OQ));
+            }
+            if (_mm256_testz_ps(inside, inside))
+                continue;
+            __m256 z = _mm256_add_ps(_mm256_mul_ps(px, _mm256_set1_ps(s.za)), _mm256_set1_ps(s.zb * fy + s.zc));
+            __m256 old = _mm256_loadu_ps(row + x);
+            _mm256_storeu_ps(row + x, _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+        }
+    }
+
+    TARGET_SSE41 static void rasterSpanSSE41(const Setup &s, int y, int x0, int x1, float *row)
+    {
+        const float fy = (float)y;
+        __m128 px = _mm_add_ps(_mm_set1_ps((float)x0), _mm_setr_ps(0, 1, 2, 3));
+        const __m128 step = _mm_set1_ps(4.0f);
+        const __m128 zero = _mm_setzero_ps();
+        // x0 is a multiple of 8 and rows are too, so whole groups of 4 stay inside the row
+        for (int x = x0; x <= x1; x += 4, px = _mm_add_ps(px, step))
+        {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int i = 0; i < 3; i++)
+            {
+                __m128 e = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(s.a[i])), _mm_set1_ps(s.b[i] * fy + s.c[i]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(e, zero));
+            }
+            if (_mm_movemask_ps(inside) == 0)
+                continue;
+            __m128 z = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(s.za)), _mm_set1_ps(s.zb * fy + s.zc));
+            __m128 old = _mm_loadu_ps(row + x);
+            _mm_storeu_ps(row + x, _mm_blendv_ps(old, _mm_min_ps(old, z), inside));
+        }
+    }
+#endif
+
+    const int width, height;
+    std::vector<Level> levels;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    RasterSpanFn rasterSpan = rasterSpanScalar;
+    size_t occluderTriangles = 0;
+};
+
+#endif
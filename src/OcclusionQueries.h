@@ -0,0 +1,302 @@
+#ifndef __OCCLUSIONQUERIES_H__
+#define __OCCLUSIONQUERIES_H__
+
+#include "glad/glad.h"
+
+#include "glm/glm.hpp"
+
+#include "Shader.h"
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// GPU occlusion culling for groups of objects with GL_ANY_SAMPLES_PASSED queries
+// and conditional rendering, the GPU side alternative to OcclusionCuller.
+//
+// Results are never waited for on the CPU. Each group remembers whether it was
+// visible the last time a result came back (temporal coherence) and render()
+// draws in three passes:
+//   1. groups that were visible are drawn directly, they lay down most of the depth
+//   2. groups that were hidden get a bounding box query against that depth and
+//      their real draw goes inside glBeginConditionalRender on it, so the GPU
+//      skips them while they stay hidden and draws them the frame they appear
+//   3. a few visible groups per frame get a box query against the finished depth
+//      buffer to find out when they become hidden
+// Results are polled with GL_QUERY_RESULT_AVAILABLE at the start of the next
+// render() or later, each group keeps a small ring of queries so it can issue a
+// new one while older ones are still in flight.
+class OcclusionQueries
+{
+public:
+    using Group = size_t;
+
+    // Counters for the last render(). skipped counts conditional draws whose query
+    // came back with no samples during that call, i.e. draws the GPU threw away a
+    // frame or two earlier. With GL_QUERY_NO_WAIT it may have drawn them anyway if
+    // the result wasn't ready in time.
+    struct Stats
+    {
+        size_t groups = 0;
+        size_t frustumCulled = 0;
+        size_t drawn = 0;
+        size_t conditional = 0;
+        size_t unconditional = 0;
+        size_t queries = 0;
+        size_t skipped = 0;
+    };
+
+    static constexpr int QueriesPerGroup = 3;
+
+    // requeryInterval: frames between checks of a visible group, staggered across groups.
+    // conditionMode: GL_QUERY_WAIT lets the GPU wait for the box query before the
+    // conditional draw, GL_QUERY_NO_WAIT draws anyway when the result isn't ready.
+    OcclusionQueries(unsigned requeryInterval = 4, GLenum conditionMode = GL_QUERY_WAIT)
+        : requeryInterval(requeryInterval ? requeryInterval : 1), conditionMode(conditionMode)
+    {
+        program = Shader::link(boxVertexShader, boxFragmentShader);
+        viewProjectionLocation = glGetUniformLocation(program, "viewProjection");
+        boxMinLocation = glGetUniformLocation(program, "boxMin");
+        boxMaxLocation = glGetUniformLocation(program, "boxMax");
+        // the box corners come from gl_VertexID, core profile still wants a VAO bound
+        glGenVertexArrays(1, &vao);
+    }
+
+    ~OcclusionQueries()
+    {
+        for (GroupState &g : groups)
+            glDeleteQueries(QueriesPerGroup, g.queries);
+        glDeleteVertexArrays(1, &vao);
+        glDeleteProgram(program);
+    }
+
+    OcclusionQueries(const OcclusionQueries &) = delete;
+    OcclusionQueries &operator=(const OcclusionQueries &) = delete;
+
+    // New groups start visible, so nothing is missing before their first result
+    Group addGroup(const glm::vec3 &min, const glm::vec3 &max)
+    {
+        GroupState g;
+        g.min = min;
+        g.max = max;
+        glGenQueries(QueriesPerGroup, g.queries);
+        groups.push_back(g);
+        return groups.size() - 1;
+    }
+
+    void setBounds(Group group, const glm::vec3 &min, const glm::vec3 &max)
+    {
+        groups[group].min = min;
+        groups[group].max = max;
+    }
+
+    // Draws every group through drawGroup(Group), which binds whatever it needs.
+    // Draw the big static occluders before calling this.
+    template <typename DrawGroup>
+    void render(const glm::mat4 &viewProjection, DrawGroup drawGroup)
+    {
+        frameStats = Stats();
+        frameStats.groups = groups.size();
+        frame++;
+        poll();
+
+        // pass 1: visible last time, or too close to the camera to test
+        clipState.resize(groups.size());
+        for (Group i = 0; i < groups.size(); i++)
+        {
+            clipState[i] = classify(viewProjection, groups[i]);
+            if (clipState[i] == Outside)
+                frameStats.frustumCulled++;
+            else if (clipState[i] == CrossesNear || groups[i].visible)
+            {
+                drawGroup(i);
+                frameStats.drawn++;
+            }
+        }
+
+        // pass 2: hidden last time, query the box and draw on its result
+        for (Group i = 0; i < groups.size(); i++)
+        {
+            GroupState &g = groups[i];
+            if (clipState[i] != Inside || g.visible)
+                continue;
+            GLuint query = queryBox(viewProjection, g, true);
+            if (query == 0)
+            {
+                // every query is still in flight, stay conservative
+                drawGroup(i);
+                frameStats.unconditional++;
+                continue;
+            }
+            glBeginConditionalRender(query, conditionMode);
+            drawGroup(i);
+            glEndConditionalRender();
+            frameStats.conditional++;
+        }
+
+        // pass 3: recheck a slice of the visible groups against the complete depth buffer
+        for (Group i = 0; i < groups.size(); i++)
+        {
+            GroupState &g = groups[i];
+            if (clipState[i] == Inside && g.visible && (frame + i) % requeryInterval == 0)
+                queryBox(viewProjection, g, false);
+        }
+        endBoxPass();
+    }
+
+    bool visible(Group group) const { return groups[group].visible; }
+    size_t size() const { return groups.size(); }
+    const Stats &stats() const { return frameStats; }
+
+private:
+    enum ClipState : uint8_t
+    {
+        Outside,
+        Inside,
+        CrossesNear
+    };
+
+    struct GroupState
+    {
+        glm::vec3 min, max;
+        GLuint queries[QueriesPerGroup];
+        bool conditional[QueriesPerGroup] = {};
+        uint8_t pending = 0; // bit per query slot
+        uint8_t oldest = 0;  // ring position of the oldest query in flight
+        bool visible = true;
+    };
+
+    // Reads every result that is ready, oldest first. Queries finish in the order
+    // they were issued, so the first one not ready ends the group.
+    void poll()
+    {
+        for (GroupState &g : groups)
+        {
+            while (g.pending & (1u << g.oldest))
+            {
+                GLuint available = GL_FALSE;
+                glGetQueryObjectuiv(g.queries[g.oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    break;
+                GLuint samples = 0;
+                glGetQueryObjectuiv(g.queries[g.oldest], GL_QUERY_RESULT, &samples);
+                g.visible = samples != 0;
+                if (!g.visible && g.conditional[g.oldest])
+                    frameStats.skipped++;
+                g.pending &= ~(1u << g.oldest);
+                g.oldest = (g.oldest + 1) % QueriesPerGroup;
+            }
+        }
+    }
+
+    // Boxes crossing the near plane would be clipped and could report no samples
+    // although the group is right in front of the camera, those are just drawn
+    static ClipState classify(const glm::mat4 &viewProjection, const GroupState &g)
+    {
+        unsigned outside = 0x3f, nearCorners = 0;
+        for (int c = 0; c < 8; c++)
+        {
+            glm::vec4 p = viewProjection * glm::vec4(c & 1 ? g.max.x : g.min.x, c & 2 ? g.max.y : g.min.y, c & 4 ? g.max.z : g.min.z, 1.0f);
+            unsigned planes = (p.x < -p.w) | (p.x > p.w) << 1 | (p.y < -p.w) << 2 | (p.y > p.w) << 3 | (p.z < -p.w) << 4 | (p.z > p.w) << 5;
+            outside &= planes;
+            nearCorners += (planes >> 4) & 1;
+        }
+        if (outside)
+            return Outside;
+        return nearCorners ? CrossesNear : Inside;
+    }
+
+    // Issues a box query on the next free slot, 0 when all of them are in flight
+    GLuint queryBox(const glm::mat4 &viewProjection, GroupState &g, bool conditional)
+    {
+        if (g.pending == (1u << QueriesPerGroup) - 1)
+            return 0;
+        int slot = (g.oldest + std::popcount(g.pending)) % QueriesPerGroup;
+        beginBoxPass(viewProjection);
+        // pushed out a little so faces lying on the group's own surface still pass
+        glm::vec3 margin = (g.max - g.min) * 0.01f + glm::vec3(1e-3f);
+        glm::vec3 min = g.min - margin, max = g.max + margin;
+        glUniform3f(boxMinLocation, min.x, min.y, min.z);
+        glUniform3f(boxMaxLocation, max.x, max.y, max.z);
+        glBeginQuery(GL_ANY_SAMPLES_PASSED, g.queries[slot]);
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glEndQuery(GL_ANY_SAMPLES_PASSED);
+        g.conditional[slot] = conditional;
+        g.pending |= 1u << slot;
+        frameStats.queries++;
+        if (conditional)
+            endBoxPass();
+        return g.queries[slot];
+    }
+
+    // Box queries must not touch colour or depth. The caller's program, VAO and
+    // masks are saved on the first box and put back once the boxes are done.
+    void beginBoxPass(const glm::mat4 &viewProjection)
+    {
+        if (inBoxPass)
+            return;
+        inBoxPass = true;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &savedProgram);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &savedVao);
+        glGetIntegerv(GL_DEPTH_FUNC, &savedDepthFunc);
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &savedDepthMask);
+        glGetBooleanv(GL_COLOR_WRITEMASK, savedColorMask);
+        glUseProgram(program);
+        glUniformMatrix4fv(viewProjectionLocation, 1, GL_FALSE, &viewProjection[0][0]);
+        glBindVertexArray(vao);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_LEQUAL);
+    }
+
+    void endBoxPass()
+    {
+        if (!inBoxPass)
+            return;
+        inBoxPass = false;
+        glUseProgram(savedProgram);
+        glBindVertexArray(savedVao);
+        glColorMask(savedColorMask[0], savedColorMask[1], savedColorMask[2], savedColorMask[3]);
+        glDepthMask(savedDepthMask);
+        glDepthFunc(savedDepthFunc);
+    }
+
+    static constexpr const char *boxVertexShader =
+        "#version 330 core\n"
+        "uniform mat4 viewProjection;\n"
+        "uniform vec3 boxMin;\n"
+        "uniform vec3 boxMax;\n"
+        "// corner bits: 1 = x, 2 = y, 4 = z\n"
+        "const int corners[36] = int[36](0, 2, 3, 0, 3, 1, 4, 5, 7, 4, 7, 6, 0, 1, 5, 0, 5, 4,\n"
+        "                                2, 6, 7, 2, 7, 3, 0, 4, 6, 0, 6, 2, 1, 3, 7, 1, 7, 5);\n"
+        "void main()\n"
+        "{\n"
+        "    int c = corners[gl_VertexID];\n"
+        "    vec3 t = vec3(c & 1, (c >> 1) & 1, (c >> 2) & 1);\n"
+        "    gl_Position = viewProjection * vec4(mix(boxMin, boxMax, t), 1.0);\n"
+        "}\n";
+
+    static constexpr const char *boxFragmentShader =
+        "#version 330 core\n"
+        "out vec4 FragColor;\n"
+        "void main()\n"
+        "{\n"
+        "    FragColor = vec4(1.0);\n"
+        "}\n";
+
+    std::vector<GroupState> groups;
+    std::vector<ClipState> clipState;
+    Stats frameStats;
+    uint64_t frame = 0;
+    unsigned requeryInterval;
+    GLenum conditionMode;
+
+    GLuint program = 0, vao = 0;
+    GLint viewProjectionLocation = -1, boxMinLocation = -1, boxMaxLocation = -1;
+
+    bool inBoxPass = false;
+    GLint savedProgram = 0, savedVao = 0, savedDepthFunc = GL_LESS;
+    GLboolean savedDepthMask = GL_TRUE, savedColorMask[4] = {GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE};
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef __PNGWRITER_H__
+#define __PNGWRITER_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Minimal PNG encoder for frame dumps: 8 bit RGB or RGBA, no filtering and
+// stored (uncompressed) deflate blocks. Files are large but writing is cheap
+// and needs no zlib, and any PNG reader (stb_image included) can load them.
+namespace PngWriter
+{
+    inline uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0)
+    {
+        static const std::vector<uint32_t> table = []
+        {
+            std::vector<uint32_t> t(256);
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    inline void putBE32(std::vector<uint8_t> &out, uint32_t v)
+    {
+        out.push_back((uint8_t)(v >> 24));
+        out.push_back((uint8_t)(v >> 16));
+        out.push_back((uint8_t)(v >> 8));
+        out.push_back((uint8_t)v);
+    }
+
+    inline void chunk(std::ofstream &file, const char *type, const std::vector<uint8_t> &data)
+    {
+        std::vector<uint8_t> header;
+        putBE32(header, (uint32_t)data.size());
+        header.insert(header.end(), type, type + 4);
+        uint32_t crc = crc32(header.data() + 4, 4);
+        crc = crc32(data.data(), data.size(), crc);
+        std::vector<uint8_t> footer;
+        putBE32(footer, crc);
+        file.write((const char *)header.data(), header.size());
+        file.write((const char *)data.data(), data.size());
+        file.write((const char *)footer.data(), footer.size());
+    }
+
+    // pixels: rows top to bottom, tightly packed, channels 3 (RGB) or 4 (RGBA)
+    inline bool write(const std::string &path, int width, int height, int channels, const uint8_t *pixels)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::PNG::OPEN_FAILED " << path << std::endl;
+            return false;
+        }
+        static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+        file.write((const char *)signature, 8);
+
+        std::vector<uint8_t> ihdr;
+        putBE32(ihdr, (uint32_t)width);
+        putBE32(ihdr, (uint32_t)height);
+        ihdr.push_back(8);                       // bit depth
+        ihdr.push_back(channels == 4 ? 6 : 2);   // colour type
+        ihdr.push_back(0);                       // deflate
+        ihdr.push_back(0);                       // adaptive filtering (we only use "none")
+        ihdr.push_back(0);                       // no interlace
+        chunk(file, "IHDR", ihdr);
+
+        // the scanlines, each led by its filter type
+        size_t rowBytes = (size_t)width * channels;
+        std::vector<uint8_t> raw;
+        raw.reserve((rowBytes + 1) * height);
+        for (int y = 0; y < height; y++)
+        {
+            raw.push_back(0);
+            raw.insert(raw.end(), pixels + y * rowBytes, pixels + (y + 1) * rowBytes);
+        }
+
+        // zlib stream of stored blocks, up to 65535 bytes each
+        std::vector<uint8_t> idat = {0x78, 0x01};
+        idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+        size_t offset = 0;
+        do
+        {
+            size_t size = std::min<size_t>(65535, raw.size() - offset);
+            bool last = offset + size == raw.size();
+            idat.push_back(last ? 1 : 0);
+            idat.push_back((uint8_t)size);
+            idat.push_back((uint8_t)(size >> 8));
+            idat.push_back((uint8_t)~size);
+            idat.push_back((uint8_t)(~size >> 8));
+            idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+            offset += size;
+        } while (offset < raw.size());
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : raw)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        putBE32(idat, (b << 16) | a);
+        chunk(file, "IDAT", idat);
+        chunk(file, "IEND", {});
+
+        if (!file)
+            std::cout << "ERROR::PNG::WRITE_FAILED " << path << std::endl;
+        return (bool)file;
+    }
+}
+
+#endif
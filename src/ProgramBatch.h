@@ -0,0 +1,170 @@
+#ifndef __PROGRAMBATCH_H__
+#define __PROGRAMBATCH_H__
+
+#include "glad/glad.h"
+
+#include "Shader.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Builds many programs without serialising on the driver.
+//
+// Shader's constructor asks for GL_COMPILE_STATUS/GL_LINK_STATUS right after each
+// call, which forces the driver to finish that compile before the next one can
+// start. Here every compile and link is issued first and status is only read back
+// later: with GL_KHR_parallel_shader_compile poll() asks GL_COMPLETION_STATUS_KHR,
+// which never blocks, so programs trickle in over a few frames while the driver
+// compiles on its own threads. Without the extension poll() checks a limited
+// number of programs per call, so the stall is at least spread out.
+class ProgramBatch
+{
+public:
+    using Handle = size_t;
+
+    enum class State
+    {
+        Queued,
+        Compiling,
+        Ready,
+        Failed
+    };
+
+    // Lets the driver use as many compiler threads as it likes
+    static bool enableParallelCompile()
+    {
+        if (!GLAD_GL_KHR_parallel_shader_compile)
+            return false;
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+        return true;
+    }
+
+    // Queues a program, nothing is sent to GL until submit()
+    Handle add(const std::string &vertexCode, const std::string &fragCode, const std::string &defines = "")
+    {
+        Entry entry;
+        entry.vertexCode = Shader::injectDefines(vertexCode, defines);
+        entry.fragCode = Shader::injectDefines(fragCode, defines);
+        entries.push_back(std::move(entry));
+        return entries.size() - 1;
+    }
+
+    // Issues every compile, then every link, without querying any status in between
+    void submit()
+    {
+        for (Entry &e : entries)
+        {
+            if (e.state != State::Queued)
+                continue;
+            const char *vs = e.vertexCode.c_str();
+            const char *fs = e.fragCode.c_str();
+            e.vertex = glCreateShader(GL_VERTEX_SHADER);
+            glShaderSource(e.vertex, 1, &vs, NULL);
+            glCompileShader(e.vertex);
+            e.frag = glCreateShader(GL_FRAGMENT_SHADER);
+            glShaderSource(e.frag, 1, &fs, NULL);
+            glCompileShader(e.frag);
+        }
+        for (Entry &e : entries)
+        {
+            if (e.state != State::Queued)
+                continue;
+            e.program = glCreateProgram();
+            glAttachShader(e.program, e.vertex);
+            glAttachShader(e.program, e.frag);
+            glLinkProgram(e.program);
+            e.state = State::Compiling;
+            pending++;
+        }
+    }
+
+    // Moves finished programs to Ready/Failed and returns how many finished this call.
+    // Without the extension at most blockingBudget programs are checked, each check may block.
+    size_t poll(size_t blockingBudget = 4)
+    {
+        bool nonBlocking = GLAD_GL_KHR_parallel_shader_compile != 0;
+        size_t finished = 0, checked = 0;
+        for (Entry &e : entries)
+        {
+            if (e.state != State::Compiling)
+                continue;
+            if (nonBlocking)
+            {
+                GLint complete = GL_FALSE;
+                glGetProgramiv(e.program, GL_COMPLETION_STATUS_KHR, &complete);
+                if (!complete)
+                    continue;
+            }
+            else if (checked++ >= blockingBudget)
+                break;
+
+            resolve(e);
+            finished++;
+        }
+        return finished;
+    }
+
+    // Blocks until every submitted program has finished
+    void finish()
+    {
+        for (Entry &e : entries)
+            if (e.state == State::Compiling)
+                resolve(e);
+    }
+
+    bool done() const { return pending == 0; }
+    size_t size() const { return entries.size(); }
+    State state(Handle h) const { return entries[h].state; }
+
+    // 0 until the program is Ready
+    GLuint program(Handle h) const { return entries[h].state == State::Ready ? entries[h].program : 0; }
+
+private:
+    struct Entry
+    {
+        std::string vertexCode, fragCode;
+        GLuint vertex = 0, frag = 0, program = 0;
+        State state = State::Queued;
+    };
+
+    // Reads the final link status, prints logs for failures and releases the shader objects
+    void resolve(Entry &e)
+    {
+        GLint success;
+        char infoLog[512];
+        glGetProgramiv(e.program, GL_LINK_STATUS, &success);
+        if (success)
+            e.state = State::Ready;
+        else
+        {
+            // a failed compile shows up as a failed link, the useful log is on the shader
+            for (GLuint shader : {e.vertex, e.frag})
+            {
+                glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+                if (!success)
+                {
+                    glGetShaderInfoLog(shader, 512, NULL, infoLog);
+                    std::cout << "ERROR::SHADER::" << (shader == e.vertex ? "VERTEX" : "FRAGMENT") << "::COMPILATION_FAILED\n"
+                              << infoLog << std::endl;
+                }
+            }
+            glGetProgramInfoLog(e.program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
+                      << infoLog << std::endl;
+            glDeleteProgram(e.program);
+            e.state = State::Failed;
+        }
+        glDeleteShader(e.vertex);
+        glDeleteShader(e.frag);
+        e.vertex = e.frag = 0;
+        e.vertexCode.clear();
+        e.fragCode.clear();
+        pending--;
+    }
+
+    std::vector<Entry> entries;
+    size_t pending = 0;
+};
+
+#endif
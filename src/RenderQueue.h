@@ -0,0 +1,340 @@
+#ifndef __RENDERQUEUE_H__
+#define __RENDERQUEUE_H__
+
+#include "glad/glad.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// 64-bit draw sort key. Fields are packed most significant first so that a plain
+// integer sort groups draws by pass, then shader, then textures, then VAO, and
+// finally orders them by depth inside a batch.
+//
+// | pass : 4 | shader : 12 | texture set : 16 | vao : 12 | depth : 20 |
+namespace SortKey
+{
+    constexpr unsigned DepthBits = 20;
+    constexpr unsigned VaoBits = 12;
+    constexpr unsigned TextureBits = 16;
+    constexpr unsigned ShaderBits = 12;
+    constexpr unsigned PassBits = 4;
+
+    constexpr unsigned DepthShift = 0;
+    constexpr unsigned VaoShift = DepthShift + DepthBits;
+    constexpr unsigned TextureShift = VaoShift + VaoBits;
+    constexpr unsigned ShaderShift = TextureShift + TextureBits;
+    constexpr unsigned PassShift = ShaderShift + ShaderBits;
+    static_assert(PassShift + PassBits == 64, "sort key fields must fill 64 bits");
+
+    constexpr uint64_t mask(unsigned bits) { return (uint64_t(1) << bits) - 1; }
+
+    inline uint64_t make(unsigned pass, unsigned shader, unsigned textureSet, unsigned vao, uint32_t depth)
+    {
+        return (uint64_t(pass) & mask(PassBits)) << PassShift |
+               (uint64_t(shader) & mask(ShaderBits)) << ShaderShift |
+               (uint64_t(textureSet) & mask(TextureBits)) << TextureShift |
+               (uint64_t(vao) & mask(VaoBits)) << VaoShift |
+               (uint64_t(depth) & mask(DepthBits)) << DepthShift;
+    }
+
+    // maps a view space distance into the depth field. Opaque passes sort front to back,
+    // pass backToFront for blended geometry.
+    inline uint32_t quantizeDepth(float viewDepth, float nearPlane, float farPlane, bool backToFront = false)
+    {
+        float t = (viewDepth - nearPlane) / (farPlane - nearPlane);
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        uint32_t q = (uint32_t)(t * (float)mask(DepthBits));
+        return backToFront ? (uint32_t)mask(DepthBits) - q : q;
+    }
+
+    inline unsigned pass(uint64_t key) { return (unsigned)((key >> PassShift) & mask(PassBits)); }
+    inline unsigned shader(uint64_t key) { return (unsigned)((key >> ShaderShift) & mask(ShaderBits)); }
+    inline unsigned textureSet(uint64_t key) { return (unsigned)((key >> TextureShift) & mask(TextureBits)); }
+    inline unsigned vao(uint64_t key) { return (unsigned)((key >> VaoShift) & mask(VaoBits)); }
+    inline uint32_t depth(uint64_t key) { return (uint32_t)((key >> DepthShift) & mask(DepthBits)); }
+}
+
+// Textures bound together for a draw, one GL texture name per unit (0 leaves the unit alone)
+struct TextureSet
+{
+    static constexpr unsigned MaxUnits = 4;
+    std::array<GLuint, MaxUnits> units{};
+    GLenum target = GL_TEXTURE_2D;
+};
+
+// A single recorded draw. All GL state lives in the key, the command only carries per draw data.
+// Instanced draws take their transforms from the VAO's instance attributes instead of model.
+// A draw with a uniformOffset gets that range of the queue's draw uniform buffer bound
+// (see setDrawUniforms) instead of the model uniform.
+struct DrawCommand
+{
+    uint64_t key;
+    GLint first;
+    GLsizei count;
+    glm::mat4 model;
+    GLsizei instanceCount = 1;
+    GLintptr uniformOffset = -1;
+};
+
+// Counters for what executing the queue actually asked the driver to do
+struct RenderQueueStats
+{
+    size_t draws = 0;
+    size_t programChanges = 0;
+    size_t textureChanges = 0;
+    size_t vaoChanges = 0;
+
+    size_t stateChanges() const { return programChanges + textureChanges + vaoChanges; }
+};
+
+class RenderQueue
+{
+public:
+    // one recording bucket per thread. Padded to a cache line so neighbouring
+    // threads never write the same line while recording.
+    struct alignas(64) Bucket
+    {
+        std::vector<DrawCommand> commands;
+
+        void submit(const DrawCommand &cmd) { commands.push_back(cmd); }
+    };
+
+    explicit RenderQueue(unsigned threadCount = 1) : buckets(threadCount ? threadCount : 1) {}
+
+    // State tables. The returned index is what goes into the sort key.
+    unsigned registerProgram(GLuint program)
+    {
+        programs.push_back({program, glGetUniformLocation(program, "model")});
+        return (unsigned)programs.size() - 1;
+    }
+    // Points an existing slot at a rebuilt program, keys already built keep working
+    void replaceProgram(unsigned index, GLuint program)
+    {
+        programs[index] = {program, glGetUniformLocation(program, "model")};
+    }
+    unsigned registerTextureSet(const TextureSet &set)
+    {
+        textureSets.push_back(set);
+        return (unsigned)textureSets.size() - 1;
+    }
+    // Buffer that DrawCommand::uniformOffset points into, bound as size bytes at bindingPoint
+    void setDrawUniforms(GLuint buffer, GLuint bindingPoint, GLsizeiptr size)
+    {
+        drawUniforms = {buffer, bindingPoint, size};
+    }
+    unsigned registerVertexArray(GLuint vao)
+    {
+        vertexArrays.push_back(vao);
+        return (unsigned)vertexArrays.size() - 1;
+    }
+
+    unsigned threadCount() const { return (unsigned)buckets.size(); }
+
+    // Each recording thread owns exactly one bucket, so submission takes no locks
+    Bucket &bucket(unsigned thread) { return buckets[thread]; }
+    void submit(const DrawCommand &cmd, unsigned thread = 0) { buckets[thread].submit(cmd); }
+
+    // Clears every bucket, call once per frame before recording starts
+    void reset()
+    {
+        for (Bucket &b : buckets)
+            b.commands.clear();
+        commands.clear();
+        order.clear();
+    }
+
+    // Merges the buckets and radix sorts the result. Must be called after all
+    // recording threads are done with their buckets for this frame.
+    void sort()
+    {
+        // merge: every bucket is copied to its own slice given by a prefix sum,
+        // so no slot is ever contended and no lock is needed
+        size_t total = 0;
+        offsets.resize(buckets.size());
+        for (size_t b = 0; b < buckets.size(); b++)
+        {
+            offsets[b] = total;
+            total += buckets[b].commands.size();
+        }
+        commands.resize(total);
+        for (size_t b = 0; b < buckets.size(); b++)
+            std::copy(buckets[b].commands.begin(), buckets[b].commands.end(), commands.begin() + offsets[b]);
+
+        order.resize(total);
+        for (size_t i = 0; i < total; i++)
+            order[i] = {commands[i].key, (uint32_t)i};
+
+        radixSort();
+    }
+
+    // Issues the sorted draws, only touching GL state when the key says it changed
+    RenderQueueStats execute()
+    {
+        GLVisitor visitor{this};
+        return walk(visitor);
+    }
+
+    // Same walk as execute() without touching GL, used to measure batching quality
+    RenderQueueStats simulate() const
+    {
+        NullVisitor visitor;
+        return walk(visitor);
+    }
+
+    size_t size() const { return order.size(); }
+
+    // Key of the i-th draw in execution order
+    uint64_t sortedKey(size_t i) const { return order[i].key; }
+
+private:
+    struct ProgramEntry
+    {
+        GLuint id;
+        GLint modelLocation;
+    };
+
+    struct DrawUniforms
+    {
+        GLuint buffer = 0;
+        GLuint bindingPoint = 0;
+        GLsizeiptr size = 0;
+    };
+
+    struct SortItem
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // LSD radix sort, 8 bits per pass. Passes where every key has the same digit
+    // are skipped, which is the common case for the pass and high shader bytes.
+    void radixSort()
+    {
+        const size_t n = order.size();
+        if (n < 2)
+            return;
+        scratch.resize(n);
+
+        for (unsigned shift = 0; shift < 64; shift += 8)
+        {
+            size_t histogram[256] = {};
+            for (size_t i = 0; i < n; i++)
+                histogram[(order[i].key >> shift) & 0xFF]++;
+
+            if (histogram[(order[0].key >> shift) & 0xFF] == n)
+                continue;
+
+            size_t sum = 0;
+            for (size_t &bin : histogram)
+            {
+                size_t count = bin;
+                bin = sum;
+                sum += count;
+            }
+            for (size_t i = 0; i < n; i++)
+                scratch[histogram[(order[i].key >> shift) & 0xFF]++] = order[i];
+            order.swap(scratch);
+        }
+    }
+
+    struct GLVisitor
+    {
+        RenderQueue *queue;
+        GLint modelLocation = -1;
+
+        void program(unsigned index)
+        {
+            const ProgramEntry &p = queue->programs[index];
+            glUseProgram(p.id);
+            modelLocation = p.modelLocation;
+        }
+        void textures(unsigned index)
+        {
+            const TextureSet &set = queue->textureSets[index];
+            for (unsigned unit = 0; unit < TextureSet::MaxUnits; unit++)
+            {
+                if (set.units[unit] == 0)
+                    continue;
+                glActiveTexture(GL_TEXTURE0 + unit);
+                glBindTexture(set.target, set.units[unit]);
+            }
+        }
+        void vertexArray(unsigned index)
+        {
+            glBindVertexArray(queue->vertexArrays[index]);
+        }
+        void draw(const DrawCommand &cmd)
+        {
+            const DrawUniforms &u = queue->drawUniforms;
+            if (cmd.uniformOffset >= 0)
+                glBindBufferRange(GL_UNIFORM_BUFFER, u.bindingPoint, u.buffer, cmd.uniformOffset, u.size);
+            if (cmd.instanceCount > 1)
+            {
+                glDrawArraysInstanced(GL_TRIANGLES, cmd.first, cmd.count, cmd.instanceCount);
+                return;
+            }
+            if (cmd.uniformOffset < 0)
+                glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &cmd.model[0][0]);
+            glDrawArrays(GL_TRIANGLES, cmd.first, cmd.count);
+        }
+    };
+
+    struct NullVisitor
+    {
+        void program(unsigned) {}
+        void textures(unsigned) {}
+        void vertexArray(unsigned) {}
+        void draw(const DrawCommand &) {}
+    };
+
+    template <typename Visitor>
+    RenderQueueStats walk(Visitor &visitor) const
+    {
+        RenderQueueStats stats;
+        unsigned currentProgram = ~0u, currentTextures = ~0u, currentVao = ~0u;
+        for (const SortItem &item : order)
+        {
+            unsigned program = SortKey::shader(item.key);
+            unsigned textures = SortKey::textureSet(item.key);
+            unsigned vao = SortKey::vao(item.key);
+            if (program != currentProgram)
+            {
+                visitor.program(program);
+                currentProgram = program;
+                stats.programChanges++;
+            }
+            if (textures != currentTextures)
+            {
+                visitor.textures(textures);
+                currentTextures = textures;
+                stats.textureChanges++;
+            }
+            if (vao != currentVao)
+            {
+                visitor.vertexArray(vao);
+                currentVao = vao;
+                stats.vaoChanges++;
+            }
+            visitor.draw(commands[item.index]);
+            stats.draws++;
+        }
+        return stats;
+    }
+
+    std::vector<Bucket> buckets;
+    std::vector<size_t> offsets;
+    std::vector<DrawCommand> commands;
+    std::vector<SortItem> order;
+    std::vector<SortItem> scratch;
+
+    std::vector<ProgramEntry> programs;
+    std::vector<TextureSet> textureSets;
+    std::vector<GLuint> vertexArrays;
+    DrawUniforms drawUniforms;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __SCENECOMPONENTS_H__
+#define __SCENECOMPONENTS_H__
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+
+// Plain data components for EntityWorld. They hold ids and values only, the GL
+// objects they name are owned elsewhere.
+
+// Rotation around a fixed axis, the way main.cpp animates its cubes
+struct Transform
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    float angle = 0.0f; // radians
+    glm::vec3 axis = glm::vec3(1.0f, 0.3f, 0.5f);
+    float scale = 1.0f;
+};
+
+struct MeshRef
+{
+    uint32_t vao = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float radius = 1.0f; // bounding sphere in model space
+};
+
+struct MaterialRef
+{
+    uint32_t program = 0;
+    uint32_t textureLayer = 0;
+};
+
+// World space bounds, written from Transform and MeshRef
+struct Bounds
+{
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+};
+
+#endif
@@ -0,0 +1,553 @@
+#ifndef __SCENECONTAINER_H__
+#define __SCENECONTAINER_H__
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Objects with a transform and bounds, stored as dense parallel arrays (one per
+// field, so a pass over positions or bounds touches nothing else) and indexed by
+// a loose spatial hash.
+//
+// Every object sits in the one cell holding the centre of its world bounds. Cells
+// are cellSize wide and objects may be up to cellSize across, so an object pokes
+// at most half a cell out of its own cell and queries just widen by that margin.
+// Moving an object only touches the index when its centre crosses into another
+// cell. Objects larger than a cell go in a separate list every query checks.
+// Cells are also grouped in 4x4x4 blocks, so frustum queries can drop or take
+// whole regions at once. Pick cellSize a few times the typical object size, so
+// most cells hold several objects.
+//
+// Handles stay valid until remove(). Dense indices, the ones queries return, are
+// only stable until the next insert or remove: removing swaps the last object
+// into the hole.
+class SceneContainer
+{
+public:
+    struct Handle
+    {
+        uint32_t slot = ~0u;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle &other) const { return slot == other.slot && generation == other.generation; }
+        bool operator!=(const Handle &other) const { return !(*this == other); }
+    };
+
+    explicit SceneContainer(float cellSize = 4.0f) : cellSize(cellSize), inverseCellSize(1.0f / cellSize)
+    {
+        cells.push_back(Cell()); // cell 0 holds the oversized objects
+        table.assign(1024, TableEntry());
+    }
+
+    Handle insert(const glm::mat4 &transform, const glm::vec3 &localMin, const glm::vec3 &localMax, uint32_t userData = 0)
+    {
+        uint32_t slot;
+        if (!freeSlots.empty())
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            slot = (uint32_t)slotDense.size();
+            slotDense.push_back(0);
+            slotGeneration.push_back(0);
+        }
+        uint32_t dense = (uint32_t)transformArray.size();
+        slotDense[slot] = dense;
+
+        transformArray.push_back(transform);
+        localMinArray.push_back(localMin);
+        localMaxArray.push_back(localMax);
+        minArray.emplace_back();
+        maxArray.emplace_back();
+        userArray.push_back(userData);
+        denseSlot.push_back(slot);
+        cellOf.push_back(0);
+        cellPosition.push_back(0);
+
+        updateBounds(dense);
+        addToCell(dense, cellFor(dense));
+        return {slot, slotGeneration[slot]};
+    }
+
+    bool remove(Handle handle)
+    {
+        if (!contains(handle))
+            return false;
+        uint32_t dense = slotDense[handle.slot];
+        removeFromCell(dense);
+
+        uint32_t last = (uint32_t)transformArray.size() - 1;
+        if (dense != last)
+        {
+            // the last object takes over the hole, its cell entry must follow
+            transformArray[dense] = transformArray[last];
+            localMinArray[dense] = localMinArray[last];
+            localMaxArray[dense] = localMaxArray[last];
+            minArray[dense] = minArray[last];
+            maxArray[dense] = maxArray[last];
+            userArray[dense] = userArray[last];
+            denseSlot[dense] = denseSlot[last];
+            cellOf[dense] = cellOf[last];
+            cellPosition[dense] = cellPosition[last];
+            slotDense[denseSlot[dense]] = dense;
+            cells[cellOf[dense]].objects[cellPosition[dense]] = dense;
+        }
+        transformArray.pop_back();
+        localMinArray.pop_back();
+        localMaxArray.pop_back();
+        minArray.pop_back();
+        maxArray.pop_back();
+        userArray.pop_back();
+        denseSlot.pop_back();
+        cellOf.pop_back();
+        cellPosition.pop_back();
+
+        slotGeneration[handle.slot]++;
+        freeSlots.push_back(handle.slot);
+        return true;
+    }
+
+    bool contains(Handle handle) const
+    {
+        return handle.slot < slotGeneration.size() && slotGeneration[handle.slot] == handle.generation;
+    }
+
+    void setTransform(Handle handle, const glm::mat4 &transform)
+    {
+        uint32_t dense = slotDense[handle.slot];
+        transformArray[dense] = transform;
+        updateBounds(dense);
+        relocate(dense);
+    }
+
+    // Moves the object keeping its rotation and scale, cheaper than setTransform
+    void setPosition(Handle handle, const glm::vec3 &position)
+    {
+        uint32_t dense = slotDense[handle.slot];
+        glm::vec3 delta = position - glm::vec3(transformArray[dense][3]);
+        transformArray[dense][3] = glm::vec4(position, 1.0f);
+        minArray[dense] += delta;
+        maxArray[dense] += delta;
+        relocate(dense);
+    }
+
+    size_t size() const { return transformArray.size(); }
+
+    // Room for count objects, so filling a large scene does not keep regrowing the arrays
+    void reserve(size_t count)
+    {
+        transformArray.reserve(count);
+        localMinArray.reserve(count);
+        localMaxArray.reserve(count);
+        minArray.reserve(count);
+        maxArray.reserve(count);
+        userArray.reserve(count);
+        denseSlot.reserve(count);
+        cellOf.reserve(count);
+        cellPosition.reserve(count);
+        slotDense.reserve(count);
+        slotGeneration.reserve(count);
+    }
+
+    size_t indexOf(Handle handle) const { return slotDense[handle.slot]; }
+    Handle handleAt(size_t dense) const { return {denseSlot[dense], slotGeneration[denseSlot[dense]]}; }
+
+    // The dense arrays, all indexed by the same dense index
+    const std::vector<glm::mat4> &transforms() const { return transformArray; }
+    const std::vector<glm::vec3> &boundsMin() const { return minArray; }
+    const std::vector<glm::vec3> &boundsMax() const { return maxArray; }
+    const std::vector<uint32_t> &userData() const { return userArray; }
+
+    // Appends the dense index of every object whose bounds overlap [min, max]
+    void queryRange(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &out) const
+    {
+        testCell(cells[0], min, max, out);
+        glm::ivec3 lo = cellCoord(min - glm::vec3(cellSize * 0.5f)), hi = cellCoord(max + glm::vec3(cellSize * 0.5f));
+        lo = glm::max(lo, usedMin);
+        hi = glm::min(hi, usedMax);
+        if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z)
+            return;
+        uint64_t span = (uint64_t)(hi.x - lo.x + 1) * (hi.y - lo.y + 1) * (hi.z - lo.z + 1);
+        if (span > cells.size())
+        {
+            // a huge box: walking the cells that exist is cheaper than probing every coordinate
+            for (size_t c = 1; c < cells.size(); c++)
+            {
+                const Cell &cell = cells[c];
+                if (!cell.objects.empty() && cell.coord.x >= lo.x && cell.coord.x <= hi.x && cell.coord.y >= lo.y &&
+                    cell.coord.y <= hi.y && cell.coord.z >= lo.z && cell.coord.z <= hi.z)
+                    testCell(cell, min, max, out);
+            }
+            return;
+        }
+        for (int z = lo.z; z <= hi.z; z++)
+            for (int y = lo.y; y <= hi.y; y++)
+                for (int x = lo.x; x <= hi.x; x++)
+                {
+                    uint32_t c = findCell(glm::ivec3(x, y, z));
+                    if (c)
+                        testCell(cells[c], min, max, out);
+                }
+    }
+
+    // Appends every object whose bounds are not entirely outside one of the frustum planes
+    void queryFrustum(const glm::mat4 &viewProjection, std::vector<uint32_t> &out) const
+    {
+        glm::vec4 planes[6];
+        for (int i = 0; i < 3; i++)
+        {
+            glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+            glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+            planes[i * 2] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+        // 0 outside, 1 crossing, 2 inside every plane
+        auto classify = [&](const glm::vec3 &min, const glm::vec3 &max)
+        {
+            int result = 2;
+            for (const glm::vec4 &p : planes)
+            {
+                float farthest = p.x * (p.x > 0.0f ? max.x : min.x) + p.y * (p.y > 0.0f ? max.y : min.y) + p.z * (p.z > 0.0f ? max.z : min.z) + p.w;
+                if (farthest < 0.0f)
+                    return 0;
+                float nearest = p.x * (p.x > 0.0f ? min.x : max.x) + p.y * (p.y > 0.0f ? min.y : max.y) + p.z * (p.z > 0.0f ? min.z : max.z) + p.w;
+                if (nearest < 0.0f)
+                    result = 1;
+            }
+            return result;
+        };
+        auto addCell = [&](const Cell &cell, bool test)
+        {
+            for (uint32_t i : cell.objects)
+                if (!test || classify(minArray[i], maxArray[i]) != 0)
+                    out.push_back(i);
+        };
+
+        addCell(cells[0], true);
+        // blocks first, then their cells, then objects, skipping the tests below
+        // anything that is entirely inside
+        float margin = cellSize * 0.5f;
+        for (const Block &block : blocks)
+        {
+            glm::vec3 blockMin = glm::vec3(block.coord * BlockCells) * cellSize - glm::vec3(margin);
+            int blockState = classify(blockMin, blockMin + glm::vec3(BlockCells * cellSize + 2.0f * margin));
+            if (blockState == 0)
+                continue;
+            for (uint32_t c : block.cells)
+            {
+                const Cell &cell = cells[c];
+                if (cell.objects.empty())
+                    continue;
+                int cellState = blockState;
+                if (cellState == 1)
+                {
+                    glm::vec3 cellMin = glm::vec3(cell.coord) * cellSize - glm::vec3(margin);
+                    cellState = classify(cellMin, cellMin + glm::vec3(cellSize + 2.0f * margin));
+                }
+                if (cellState != 0)
+                    addCell(cell, cellState == 1);
+            }
+        }
+    }
+
+    // Nearest object whose bounds the ray hits within maxDistance. direction need not
+    // be normalised, distance comes back in units of its length.
+    bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, uint32_t &hit, float &distance) const
+    {
+        glm::vec3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+        float best = maxDistance;
+        bool found = false;
+        auto testObjects = [&](const Cell &cell)
+        {
+            for (uint32_t i : cell.objects)
+            {
+                float t;
+                if (rayBox(origin, inverse, minArray[i], maxArray[i], best, t))
+                {
+                    best = t;
+                    hit = i;
+                    found = true;
+                }
+            }
+        };
+        testObjects(cells[0]);
+
+        // clip the ray to the cells in use, grown by one for the loose margin
+        float tEnter, tExit;
+        glm::vec3 gridMin = glm::vec3(usedMin - glm::ivec3(1)) * cellSize, gridMax = glm::vec3(usedMax + glm::ivec3(2)) * cellSize;
+        if (cells.size() == 1 || !slab(origin, inverse, gridMin, gridMax, tEnter, tExit))
+        {
+            distance = best;
+            return found;
+        }
+        tExit = std::min(tExit, best);
+
+        // Amanatides-Woo walk. Whatever overlaps a cell has its centre in that cell or
+        // a neighbour, so the first cell looks at the 3x3x3 block around it and every
+        // step after that only at the 3x3 face of cells the block moved into
+        glm::vec3 start = origin + direction * std::max(tEnter, 0.0f);
+        glm::ivec3 coord = cellCoord(start);
+        glm::ivec3 step(direction.x > 0.0f ? 1 : -1, direction.y > 0.0f ? 1 : -1, direction.z > 0.0f ? 1 : -1);
+        glm::vec3 tMax, tDelta;
+        for (int a = 0; a < 3; a++)
+        {
+            float boundary = (coord[a] + (step[a] > 0 ? 1 : 0)) * cellSize;
+            tMax[a] = direction[a] != 0.0f ? (boundary - origin[a]) * inverse[a] : INFINITY;
+            tDelta[a] = direction[a] != 0.0f ? cellSize * std::abs(inverse[a]) : INFINITY;
+        }
+        for (int z = -1; z <= 1; z++)
+            for (int y = -1; y <= 1; y++)
+                for (int x = -1; x <= 1; x++)
+                    if (uint32_t c = findCell(coord + glm::ivec3(x, y, z)))
+                        testObjects(cells[c]);
+        while (true)
+        {
+            int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+            float tCell = tMax[axis];
+            if (tCell > std::min(tExit, best))
+                break;
+            tMax[axis] += tDelta[axis];
+            coord[axis] += step[axis];
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            glm::ivec3 face = coord;
+            face[axis] += step[axis];
+            for (int j = -1; j <= 1; j++)
+                for (int i = -1; i <= 1; i++)
+                {
+                    glm::ivec3 c = face;
+                    c[u] += i;
+                    c[v] += j;
+                    if (uint32_t index = findCell(c))
+                        testObjects(cells[index]);
+                }
+        }
+        distance = best;
+        return found;
+    }
+
+    size_t cellCount() const { return cells.size() - 1; }
+    size_t oversizedCount() const { return cells[0].objects.size(); }
+
+    // Heap bytes held by the arrays, cell lists and index, capacity included
+    size_t memoryBytes() const
+    {
+        auto bytes = [](const auto &v)
+        { return v.capacity() * sizeof(v[0]); };
+        size_t total = bytes(transformArray) + bytes(localMinArray) + bytes(localMaxArray) + bytes(minArray) + bytes(maxArray) +
+                       bytes(userArray) + bytes(denseSlot) + bytes(cellOf) + bytes(cellPosition) + bytes(slotDense) +
+                       bytes(slotGeneration) + bytes(freeSlots) + bytes(cells) + bytes(table) + bytes(blocks);
+        for (const Cell &cell : cells)
+            total += bytes(cell.objects);
+        for (const Block &block : blocks)
+            total += bytes(block.cells);
+        return total + blockLookup.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void *));
+    }
+
+private:
+    static constexpr int BlockCells = 4;
+
+    struct Cell
+    {
+        glm::ivec3 coord = glm::ivec3(0);
+        std::vector<uint32_t> objects;
+    };
+
+    // BlockCells^3 cells, a coarse level for frustum queries. Cells are never
+    // deleted, so a block's list only grows.
+    struct Block
+    {
+        glm::ivec3 coord;
+        std::vector<uint32_t> cells;
+    };
+
+    struct TableEntry
+    {
+        glm::ivec3 coord = glm::ivec3(0);
+        uint32_t cell = 0;
+    };
+
+    static bool slab(const glm::vec3 &origin, const glm::vec3 &inverse, const glm::vec3 &min, const glm::vec3 &max, float &tNear, float &tFar)
+    {
+        tNear = 0.0f;
+        tFar = INFINITY;
+        for (int a = 0; a < 3; a++)
+        {
+            float t0 = (min[a] - origin[a]) * inverse[a], t1 = (max[a] - origin[a]) * inverse[a];
+            // 0 * inf when the ray lies in a slab plane, count it as inside
+            if (t0 != t0 || t1 != t1)
+                continue;
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+        return tNear <= tFar;
+    }
+
+    static bool rayBox(const glm::vec3 &origin, const glm::vec3 &inverse, const glm::vec3 &min, const glm::vec3 &max, float limit, float &t)
+    {
+        float tNear, tFar;
+        if (!slab(origin, inverse, min, max, tNear, tFar) || tNear >= limit)
+            return false;
+        t = tNear;
+        return true;
+    }
+
+    void testCell(const Cell &cell, const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &out) const
+    {
+        for (uint32_t i : cell.objects)
+            if (minArray[i].x <= max.x && maxArray[i].x >= min.x && minArray[i].y <= max.y && maxArray[i].y >= min.y &&
+                minArray[i].z <= max.z && maxArray[i].z >= min.z)
+                out.push_back(i);
+    }
+
+    static int floorDiv(int a, int b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    glm::ivec3 cellCoord(const glm::vec3 &p) const
+    {
+        return glm::ivec3((int)std::floor(p.x * inverseCellSize), (int)std::floor(p.y * inverseCellSize), (int)std::floor(p.z * inverseCellSize));
+    }
+
+    static uint32_t hash(const glm::ivec3 &c)
+    {
+        uint32_t h = (uint32_t)c.x * 73856093u ^ (uint32_t)c.y * 19349663u ^ (uint32_t)c.z * 83492791u;
+        return h ^ (h >> 16);
+    }
+
+    // Open addressing with linear probing. Entries keep the coordinate next to the
+    // cell index so a probe never has to look at the cell itself, cell 0 marks a free entry.
+    uint32_t findCell(const glm::ivec3 &coord) const
+    {
+        size_t mask = table.size() - 1;
+        for (size_t i = hash(coord) & mask;; i = (i + 1) & mask)
+        {
+            const TableEntry &entry = table[i];
+            if (entry.cell == 0)
+                return 0;
+            if (entry.coord == coord)
+                return entry.cell;
+        }
+    }
+
+    uint32_t findOrAddCell(const glm::ivec3 &coord)
+    {
+        uint32_t c = findCell(coord);
+        if (c)
+            return c;
+        if ((cells.size() + 1) * 2 > table.size())
+            growTable();
+        Cell cell;
+        cell.coord = coord;
+        cells.push_back(std::move(cell));
+        c = (uint32_t)cells.size() - 1;
+        insertIntoTable(c);
+        glm::ivec3 blockCoord(floorDiv(coord.x, BlockCells), floorDiv(coord.y, BlockCells), floorDiv(coord.z, BlockCells));
+        // 21 bits per axis is plenty for block coordinates
+        uint64_t blockKey = (uint64_t)(blockCoord.x & 0x1fffff) << 42 | (uint64_t)(blockCoord.y & 0x1fffff) << 21 | (uint64_t)(blockCoord.z & 0x1fffff);
+        auto block = blockLookup.find(blockKey);
+        if (block == blockLookup.end())
+        {
+            block = blockLookup.emplace(blockKey, (uint32_t)blocks.size()).first;
+            blocks.push_back({blockCoord, {}});
+        }
+        blocks[block->second].cells.push_back(c);
+        usedMin = cells.size() == 2 ? coord : glm::min(usedMin, coord);
+        usedMax = cells.size() == 2 ? coord : glm::max(usedMax, coord);
+        return c;
+    }
+
+    void insertIntoTable(uint32_t c)
+    {
+        size_t mask = table.size() - 1;
+        size_t i = hash(cells[c].coord) & mask;
+        while (table[i].cell != 0)
+            i = (i + 1) & mask;
+        table[i] = {cells[c].coord, c};
+    }
+
+    void growTable()
+    {
+        table.assign(table.size() * 2, TableEntry());
+        for (uint32_t c = 1; c < cells.size(); c++)
+            insertIntoTable(c);
+    }
+
+    // World bounds of the local box under the transform
+    void updateBounds(uint32_t dense)
+    {
+        const glm::mat4 &m = transformArray[dense];
+        glm::vec3 centre = (localMinArray[dense] + localMaxArray[dense]) * 0.5f;
+        glm::vec3 half = (localMaxArray[dense] - localMinArray[dense]) * 0.5f;
+        glm::vec3 worldCentre = glm::vec3(m * glm::vec4(centre, 1.0f));
+        glm::vec3 worldHalf = glm::abs(glm::vec3(m[0])) * half.x + glm::abs(glm::vec3(m[1])) * half.y + glm::abs(glm::vec3(m[2])) * half.z;
+        minArray[dense] = worldCentre - worldHalf;
+        maxArray[dense] = worldCentre + worldHalf;
+    }
+
+    uint32_t cellFor(uint32_t dense)
+    {
+        glm::vec3 extent = maxArray[dense] - minArray[dense];
+        if (extent.x > cellSize || extent.y > cellSize || extent.z > cellSize)
+            return 0;
+        return findOrAddCell(cellCoord((minArray[dense] + maxArray[dense]) * 0.5f));
+    }
+
+    void addToCell(uint32_t dense, uint32_t c)
+    {
+        cellOf[dense] = c;
+        cellPosition[dense] = (uint32_t)cells[c].objects.size();
+        cells[c].objects.push_back(dense);
+    }
+
+    void removeFromCell(uint32_t dense)
+    {
+        std::vector<uint32_t> &objects = cells[cellOf[dense]].objects;
+        uint32_t position = cellPosition[dense];
+        objects[position] = objects.back();
+        cellPosition[objects[position]] = position;
+        objects.pop_back();
+    }
+
+    void relocate(uint32_t dense)
+    {
+        // the common case, still inside the same cell
+        uint32_t current = cellOf[dense];
+        glm::vec3 extent = maxArray[dense] - minArray[dense];
+        if (current != 0 && extent.x <= cellSize && extent.y <= cellSize && extent.z <= cellSize &&
+            cellCoord((minArray[dense] + maxArray[dense]) * 0.5f) == cells[current].coord)
+            return;
+        uint32_t c = cellFor(dense);
+        if (c == cellOf[dense])
+            return;
+        removeFromCell(dense);
+        addToCell(dense, c);
+    }
+
+    float cellSize, inverseCellSize;
+
+    // dense, one entry per object
+    std::vector<glm::mat4> transformArray;
+    std::vector<glm::vec3> localMinArray, localMaxArray;
+    std::vector<glm::vec3> minArray, maxArray;
+    std::vector<uint32_t> userArray;
+    std::vector<uint32_t> denseSlot;
+    std::vector<uint32_t> cellOf, cellPosition;
+
+    // handle slots
+    std::vector<uint32_t> slotDense, slotGeneration, freeSlots;
+
+    std::vector<Cell> cells;
+    std::vector<TableEntry> table;
+    std::vector<Block> blocks;
+    std::unordered_map<uint64_t, uint32_t> blockLookup;
+    glm::ivec3 usedMin = glm::ivec3(0), usedMax = glm::ivec3(0);
+};
+
+#endif
@@ -2,7 +2,9 @@
 #define __SHADER_H__
 
 #include "glad/glad.h"
+#include "glm/glm.hpp"
 
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -14,81 +16,92 @@ public:
     // Shader program ID
     unsigned int ID;
 
+    Shader() : ID(0) {}
+
+    // wraps an already linked program, e.g. one restored by ShaderCache
+    explicit Shader(unsigned int program) : ID(program) {}
+
     // constructor reads and builds the shader
     Shader(const char *vertexPath, const char *fragPath)
     {
         // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
+        std::string vertexCode = readFile(vertexPath);
+        std::string fragCode = readFile(fragPath);
+
+        // 2. Compile and link
+        ID = link(vertexCode.c_str(), fragCode.c_str());
+    }
+
+    // Reads a whole shader source file, prints an error and returns "" on failure
+    static std::string readFile(const char *path)
+    {
+        // size the string once and read straight into it, no stringstream copies
+        std::ifstream shaderFile(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = shaderFile ? (std::streamoff)shaderFile.tellg() : -1;
+        if (size < 0)
         {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragCode = fShaderStream.str();
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+            return std::string();
         }
-        catch (std::ifstream::failure e)
+        std::string code((size_t)size, '\0');
+        shaderFile.seekg(0);
+        if (!shaderFile.read(code.data(), size))
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+            return std::string();
         }
-        const char *vShaderCode = vertexCode.c_str();
-        const char *fShaderCode = fragCode.c_str();
+        return code;
+    }
 
-        // 2. Compile shaders
-        unsigned int vertex, frag;
+    // Compiles one stage, returns the shader object (printing the log on failure).
+    // A length of -1 means code is NUL-terminated, otherwise exactly length bytes are used.
+    static unsigned int compile(GLenum type, const char *code, GLint length = -1)
+    {
         int success;
         char infoLog[512];
 
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
+        unsigned int shader = glCreateShader(type);
+        glShaderSource(shader, 1, &code, length < 0 ? NULL : &length);
+        glCompileShader(shader);
         // print compile errors
-        glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
         if (!success)
         {
-            glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n"
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::" << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << "::COMPILATION_FAILED\n"
                       << infoLog << std::endl;
         };
+        return shader;
+    }
 
-        // fragment shader
-        frag = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(frag, 1, &fShaderCode, NULL);
-        glCompileShader(frag);
-        // print compile errors
-        glGetShaderiv(frag, GL_COMPILE_STATUS, &success);
-        if (!success)
-        {
-            glGetShaderInfoLog(frag, 512, NULL, infoLog);
-            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n"
-                      << infoLog << std::endl;
-        };
+    // Compiles both stages and links them into a program. Set retrievable when the
+    // program binary is going to be read back with glGetProgramBinary.
+    static unsigned int link(const char *vShaderCode, const char *fShaderCode, bool retrievable = false)
+    {
+        return link(vShaderCode, -1, fShaderCode, -1, retrievable);
+    }
+
+    // Same with explicit source lengths, for sources that aren't NUL-terminated (e.g. mapped files)
+    static unsigned int link(const char *vShaderCode, GLint vLength, const char *fShaderCode, GLint fLength, bool retrievable = false)
+    {
+        int success;
+        char infoLog[512];
+
+        unsigned int vertex = compile(GL_VERTEX_SHADER, vShaderCode, vLength);
+        unsigned int frag = compile(GL_FRAGMENT_SHADER, fShaderCode, fLength);
 
         // Shader program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, frag);
-        glLinkProgram(ID);
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, frag);
+        if (retrievable && GLAD_GL_ARB_get_program_binary)
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program);
         // print linking errors
-        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
         if (!success)
         {
-            glGetProgramInfoLog(ID, 512, NULL, infoLog);
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
             std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
                       << infoLog << std::endl;
         }
@@ -96,6 +109,20 @@ public:
         // Delete linked shaders
         glDeleteShader(vertex);
         glDeleteShader(frag);
+        return program;
+    }
+
+    // Inserts #define lines after the #version directive, which has to stay first,
+    // followed by a #line so compile errors keep the original line numbers
+    static std::string injectDefines(const std::string &source, const std::string &defines)
+    {
+        if (defines.empty())
+            return source;
+        size_t version = source.find("#version");
+        size_t insertAt = version == std::string::npos ? 0 : source.find('\n', version);
+        insertAt = insertAt == std::string::npos ? source.size() : insertAt + 1;
+        long nextLine = std::count(source.begin(), source.begin() + insertAt, '\n') + 1;
+        return source.substr(0, insertAt) + defines + (defines.back() == '\n' ? "" : "\n") + "#line " + std::to_string(nextLine) + "\n" + source.substr(insertAt);
     }
 
     void use()
@@ -0,0 +1,214 @@
+#ifndef __SHADERCACHE_H__
+#define __SHADERCACHE_H__
+
+#include "glad/glad.h"
+
+#include "Shader.h"
+#include "ShaderSource.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Persistent cache of linked program binaries (GL_ARB_get_program_binary).
+//
+// Programs are keyed by a hash of their sources, injected defines and the
+// driver's GL_RENDERER/GL_VERSION strings, so a driver update or a different
+// GPU simply misses instead of feeding the driver a blob it can't use. When the
+// driver still rejects a cached binary the program is rebuilt from source and
+// the entry rewritten.
+class ShaderCache
+{
+public:
+    struct Stats
+    {
+        unsigned hits = 0;
+        unsigned misses = 0;
+        unsigned rejected = 0;
+    };
+
+    explicit ShaderCache(const std::string &directory) : directory(directory)
+    {
+        GLint formats = 0;
+        if (GLAD_GL_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        supported = formats > 0;
+        if (supported)
+        {
+            std::error_code ec;
+            std::filesystem::create_directories(directory, ec);
+            const char *renderer = (const char *)glGetString(GL_RENDERER);
+            const char *version = (const char *)glGetString(GL_VERSION);
+            driverHash = hash(renderer ? renderer : "", hash(version ? version : "", FnvOffset));
+        }
+    }
+
+    // false when the driver exposes no binary formats, every call then compiles from source
+    bool enabled() const { return supported; }
+    const Stats &stats() const { return counters; }
+
+    // Reads both files and returns a linked program, from the cache when possible.
+    // Shader sources are a few KB, too small for mapping each one to beat a plain
+    // read (ShaderSourceBench); a ShaderArchive is what saves the opens.
+    unsigned int load(const char *vertexPath, const char *fragPath, const std::string &defines = "")
+    {
+        return program(Shader::readFile(vertexPath), Shader::readFile(fragPath), defines);
+    }
+
+    // Same with both sources taken straight out of a packed archive
+    unsigned int load(const ShaderArchive &archive, std::string_view vertexName, std::string_view fragName, const std::string &defines = "")
+    {
+        std::string_view vs = archive.find(vertexName), fs = archive.find(fragName);
+        if (vs.empty() || fs.empty())
+        {
+            std::cout << "ERROR::SHADER::ARCHIVE_MISSING " << (vs.empty() ? vertexName : fragName) << std::endl;
+            return 0;
+        }
+        return program(vs, fs, defines);
+    }
+
+    // Sources are only copied when defines have to be injected into a program
+    // that isn't cached, a hit hashes them in place
+    unsigned int program(std::string_view vertexCode, std::string_view fragCode, const std::string &defines = "")
+    {
+        unsigned int id = 0;
+        uint64_t key = hash(defines, hash(fragCode, hash(vertexCode, driverHash)));
+        std::string path = supported ? entryPath(key) : std::string();
+        if (supported && (id = restore(path, key)) != 0)
+        {
+            counters.hits++;
+            return id;
+        }
+
+        if (defines.empty())
+            id = Shader::link(vertexCode.data(), (GLint)vertexCode.size(), fragCode.data(), (GLint)fragCode.size(), supported);
+        else
+        {
+            std::string vs = Shader::injectDefines(std::string(vertexCode), defines);
+            std::string fs = Shader::injectDefines(std::string(fragCode), defines);
+            id = Shader::link(vs.c_str(), fs.c_str(), supported);
+        }
+        if (supported)
+        {
+            counters.misses++;
+            store(path, key, id);
+        }
+        return id;
+    }
+
+    // Removes every entry, used to measure cold starts
+    void clear()
+    {
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(directory, ec))
+            if (entry.path().extension() == ".bin")
+                std::filesystem::remove(entry.path(), ec);
+    }
+
+private:
+    static constexpr uint64_t FnvOffset = 1469598103934665603ull;
+
+    // 64-bit FNV-1a, chained through seed
+    static uint64_t hash(std::string_view data, uint64_t seed)
+    {
+        uint64_t h = seed;
+        for (unsigned char c : data)
+        {
+            h ^= c;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    std::string entryPath(uint64_t key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    // File layout: magic, key, binary format, length, blob
+    struct Header
+    {
+        char magic[4];
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    unsigned int restore(const std::string &path, uint64_t key)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = file ? (std::streamoff)file.tellg() : -1;
+        file.seekg(0);
+        Header header;
+        if (!file.read((char *)&header, sizeof(header)))
+            return 0;
+        if (memcmp(header.magic, "PBIN", 4) != 0 || header.key != key)
+            return 0;
+        if (header.length == 0 || header.length != size - (std::streamoff)sizeof(header))
+        {
+            // truncated or corrupt, drop it so the miss path writes a fresh one
+            counters.rejected++;
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            return 0;
+        }
+        std::vector<char> blob(header.length);
+        if (!file.read(blob.data(), blob.size()))
+            return 0;
+
+        unsigned int id = glCreateProgram();
+        glProgramBinary(id, header.format, blob.data(), (GLsizei)blob.size());
+        int success;
+        glGetProgramiv(id, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            // driver changed its mind about the blob, rebuild and overwrite it
+            counters.rejected++;
+            glDeleteProgram(id);
+            return 0;
+        }
+        return id;
+    }
+
+    void store(const std::string &path, uint64_t key, unsigned int id)
+    {
+        int success, length = 0;
+        glGetProgramiv(id, GL_LINK_STATUS, &success);
+        glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!success || length <= 0)
+            return;
+
+        std::vector<char> blob(length);
+        GLenum format = 0;
+        glGetProgramBinary(id, length, NULL, &format, blob.data());
+
+        Header header = {{'P', 'B', 'I', 'N'}, key, (uint32_t)format, (uint32_t)length};
+        // write to a temp file and rename, so a crash never leaves a truncated entry
+        std::string temp = path + ".tmp";
+        {
+            std::ofstream file(temp, std::ios::binary);
+            file.write((const char *)&header, sizeof(header));
+            file.write(blob.data(), blob.size());
+            if (!file)
+                return;
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp, path, ec);
+    }
+
+    std::string directory;
+    bool supported = false;
+    uint64_t driverHash = FnvOffset;
+    Stats counters;
+};
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef __SHADERHOTRELOAD_H__
+#define __SHADERHOTRELOAD_H__
+
+#include "glad/glad.h"
+
+#include "Shader.h"
+#include "ProgramBatch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Rebuilds shaders when their source files change, without restarting.
+//
+// A watcher thread (inotify on Linux, timestamp polling elsewhere) notices the
+// save and reads the new sources, so no file IO happens on the render thread.
+// update() runs once per frame at the frame boundary and swaps the new program
+// into the Shader only once it linked, so a typo keeps the old program on screen
+// instead of a black frame.
+//
+// Given a context that shares objects with the render one, the watcher thread
+// compiles and links there and the frame never waits on the driver. Without it
+// the sources go to a ProgramBatch on the render thread, which only stays off the
+// frame with GL_KHR_parallel_shader_compile; otherwise each poll can block on a link.
+class ShaderHotReload
+{
+public:
+    // Called on the render thread with the rebuilt program before it replaces the old
+    // one, to check it and restore uniforms or re-register it. Returning false
+    // rejects it and the previous program stays.
+    using ReloadCallback = std::function<bool(Shader &)>;
+
+    // Called on the watcher thread: make the shared context current (true) or release it (false)
+    using ContextCallback = std::function<void(bool)>;
+
+    explicit ShaderHotReload(ContextCallback compileContext = ContextCallback()) : compileContext(std::move(compileContext))
+    {
+        worker = std::thread([this]
+                             { watchLoop(); });
+    }
+
+    ~ShaderHotReload()
+    {
+        stop();
+#ifdef __linux__
+        if (inotifyFd >= 0)
+            close(inotifyFd);
+#endif
+    }
+
+    // Joins the watcher thread, which releases the compile context. Call before that context is destroyed.
+    void stop()
+    {
+        running = false;
+        if (worker.joinable())
+            worker.join();
+    }
+
+    ShaderHotReload(const ShaderHotReload &) = delete;
+    ShaderHotReload &operator=(const ShaderHotReload &) = delete;
+
+    // Rebuilds shader from these files whenever either of them is saved
+    void watch(Shader &shader, const std::string &vertexPath, const std::string &fragPath, ReloadCallback onReload = ReloadCallback())
+    {
+        auto w = std::make_shared<Watched>();
+        w->shader = &shader;
+        w->vertexPath = std::filesystem::absolute(vertexPath).lexically_normal();
+        w->fragPath = std::filesystem::absolute(fragPath).lexically_normal();
+        w->onReload = std::move(onReload);
+        std::error_code ec;
+        w->vertexTime = std::filesystem::last_write_time(w->vertexPath, ec);
+        w->fragTime = std::filesystem::last_write_time(w->fragPath, ec);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        watched.push_back(w);
+        directoriesChanged = true;
+    }
+
+    // Call once per frame between frames. Returns the number of programs swapped in.
+    size_t update()
+    {
+        std::vector<Pending> ready;
+        std::vector<Linked> built;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(pending);
+            built.swap(linked);
+        }
+
+        size_t swapped = 0;
+        for (Linked &l : built)
+            swapped += swapIn(*l.target, l.program, l.detected);
+
+        for (Pending &p : ready)
+            inflight.push_back({batch.add(p.vertexCode, p.fragCode), p.target, p.detected});
+        if (!ready.empty())
+            batch.submit();
+
+        if (inflight.empty())
+            return swapped;
+
+        batch.poll(1);
+        for (size_t i = 0; i < inflight.size();)
+        {
+            Inflight &f = inflight[i];
+            ProgramBatch::State state = batch.state(f.handle);
+            if (state == ProgramBatch::State::Compiling)
+            {
+                i++;
+                continue;
+            }
+            swapped += swapIn(*f.target, batch.program(f.handle), f.detected);
+            inflight.erase(inflight.begin() + i);
+        }
+        if (inflight.empty())
+            batch = ProgramBatch();
+        return swapped;
+    }
+
+private:
+    struct Watched
+    {
+        Shader *shader;
+        std::filesystem::path vertexPath, fragPath;
+        std::filesystem::file_time_type vertexTime, fragTime;
+        ReloadCallback onReload;
+    };
+
+    struct Pending
+    {
+        std::shared_ptr<Watched> target;
+        std::string vertexCode, fragCode;
+        std::chrono::steady_clock::time_point detected;
+    };
+
+    struct Inflight
+    {
+        ProgramBatch::Handle handle;
+        std::shared_ptr<Watched> target;
+        std::chrono::steady_clock::time_point detected;
+    };
+
+    // Built on the watcher thread, 0 if it failed to link
+    struct Linked
+    {
+        std::shared_ptr<Watched> target;
+        GLuint program;
+        std::chrono::steady_clock::time_point detected;
+    };
+
+    // Render thread: hands program to the callback and replaces the old one if it's accepted
+    bool swapIn(Watched &target, GLuint program, std::chrono::steady_clock::time_point detected)
+    {
+        if (program == 0)
+        {
+            std::cout << "ERROR::SHADER::RELOAD_FAILED keeping the previous program" << std::endl;
+            return false;
+        }
+        Shader rebuilt(program);
+        if (target.onReload && !target.onReload(rebuilt))
+        {
+            std::cout << "ERROR::SHADER::RELOAD_REJECTED keeping the previous program" << std::endl;
+            glDeleteProgram(rebuilt.ID);
+            return false;
+        }
+        glDeleteProgram(target.shader->ID);
+        target.shader->ID = rebuilt.ID;
+        double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - detected).count();
+        std::cout << "Reloaded " << target.fragPath.filename().string() << " in " << latency << " ms" << std::endl;
+        return true;
+    }
+
+    // Watcher thread, with the compile context current. glFinish so the program is
+    // complete before the render context first uses it.
+    GLuint link(const Pending &p)
+    {
+        GLuint program = Shader::link(p.vertexCode.c_str(), p.fragCode.c_str());
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+        glFinish();
+        return program;
+    }
+
+    // Runs on the watcher thread: wait for a change, then read the sources here
+    void watchLoop()
+    {
+        if (compileContext)
+            compileContext(true);
+        while (running)
+        {
+            std::vector<std::filesystem::path> changed = waitForChanges();
+            if (changed.empty())
+                continue;
+            auto detected = std::chrono::steady_clock::now();
+
+            std::vector<std::shared_ptr<Watched>> targets;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto &w : watched)
+                    for (const auto &path : changed)
+                        if (path == w->vertexPath || path == w->fragPath)
+                        {
+                            targets.push_back(w);
+                            break;
+                        }
+            }
+
+            for (auto &w : targets)
+            {
+                // copied rather than mapped: the editor may truncate the file while the
+                // build is pending, and touching a mapped page past the new end is SIGBUS
+                Pending p{w, Shader::readFile(w->vertexPath.string().c_str()), Shader::readFile(w->fragPath.string().c_str()), detected};
+                // editors often truncate before writing, don't build a half saved file
+                if (p.vertexCode.empty() || p.fragCode.empty())
+                    continue;
+                if (compileContext)
+                {
+                    Linked l{w, link(p), detected};
+                    std::lock_guard<std::mutex> lock(mutex);
+                    linked.push_back(l);
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.push_back(std::move(p));
+            }
+        }
+        if (compileContext)
+            compileContext(false);
+    }
+
+#ifdef __linux__
+    // Blocks up to 100 ms for inotify events on the watched directories. Editors
+    // commonly save by writing a temp file and renaming it over the original, so
+    // the directory is watched rather than the file itself.
+    std::vector<std::filesystem::path> waitForChanges()
+    {
+        std::vector<std::filesystem::path> changed;
+        if (inotifyFd < 0)
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            return changed;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (directoriesChanged)
+            {
+                for (auto &w : watched)
+                    for (const auto &path : {w->vertexPath, w->fragPath})
+                    {
+                        std::filesystem::path dir = path.parent_path();
+                        if (std::find(watchDirs.begin(), watchDirs.end(), dir) != watchDirs.end())
+                            continue;
+                        int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                        if (wd >= 0)
+                        {
+                            watchDirs.push_back(dir);
+                            watchIds.push_back(wd);
+                        }
+                    }
+                directoriesChanged = false;
+            }
+        }
+
+        pollfd pfd = {inotifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0)
+            return changed;
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *p = buffer; p < buffer + length;)
+            {
+                const inotify_event *event = (const inotify_event *)p;
+                for (size_t i = 0; i < watchIds.size(); i++)
+                    if (watchIds[i] == event->wd && event->len > 0)
+                        changed.push_back(watchDirs[i] / event->name);
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+
+    int inotifyFd = -1;
+    std::vector<std::filesystem::path> watchDirs;
+    std::vector<int> watchIds;
+#else
+    // No inotify: compare modification times every 100 ms
+    std::vector<std::filesystem::path> waitForChanges()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::vector<std::filesystem::path> changed;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::error_code ec;
+        for (auto &w : watched)
+        {
+            auto vertexTime = std::filesystem::last_write_time(w->vertexPath, ec);
+            auto fragTime = std::filesystem::last_write_time(w->fragPath, ec);
+            if (vertexTime != w->vertexTime)
+                changed.push_back(w->vertexPath);
+            if (fragTime != w->fragTime)
+                changed.push_back(w->fragPath);
+            w->vertexTime = vertexTime;
+            w->fragTime = fragTime;
+        }
+        return changed;
+    }
+#endif
+
+    std::thread worker;
+    std::atomic<bool> running{true};
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Watched>> watched;
+    std::vector<Pending> pending;
+    std::vector<Linked> linked;
+    bool directoriesChanged = false;
+    ContextCallback compileContext;
+
+    // render thread only
+    ProgramBatch batch;
+    std::vector<Inflight> inflight;
+};
+
+#endif
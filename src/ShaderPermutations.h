@@ -0,0 +1,203 @@
+#ifndef __SHADERPERMUTATIONS_H__
+#define __SHADERPERMUTATIONS_H__
+
+#include "glad/glad.h"
+
+#include "Shader.h"
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Expands #include "file" (relative to the including file, each file pasted once)
+// and collects "#pragma permutation NAME" declarations, which are blanked in the
+// output. Included files must not carry their own #version line.
+//
+// Each file gets a GLSL source string number, its index in Result::files, and
+// "#line" directives around every include keep compile errors pointing at the
+// right file and line.
+class ShaderPreprocessor
+{
+public:
+    struct Result
+    {
+        std::string source;
+        std::vector<std::string> permutations;
+        std::vector<std::string> files; // by source string number
+    };
+
+    static Result process(const std::string &path)
+    {
+        Result result;
+        expand(std::filesystem::path(path), result);
+        return result;
+    }
+
+private:
+    static void expand(const std::filesystem::path &path, Result &result)
+    {
+        std::string canonical = std::filesystem::absolute(path).lexically_normal().string();
+        if (std::find(result.files.begin(), result.files.end(), canonical) != result.files.end())
+            return;
+        size_t file = result.files.size();
+        result.files.push_back(canonical);
+        if (file > 0)
+            result.source += "#line 1 " + std::to_string(file) + "\n";
+
+        std::string code = Shader::readFile(path.string().c_str());
+        std::string_view text = code;
+        for (int number = 1; !text.empty(); number++)
+        {
+            size_t end = text.find('\n');
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+            size_t start = line.find_first_not_of(" \t");
+            if (start != std::string::npos && line[start] == '#')
+            {
+                std::istringstream directive(std::string(line.substr(start + 1)));
+                std::string word;
+                directive >> word;
+                if (word == "include")
+                {
+                    size_t open = line.find('"'), close = line.rfind('"');
+                    if (open == std::string::npos || close <= open)
+                    {
+                        std::cout << "ERROR::SHADER::BAD_INCLUDE " << line << std::endl;
+                        result.source += '\n';
+                        continue;
+                    }
+                    expand(path.parent_path() / line.substr(open + 1, close - open - 1), result);
+                    result.source += "#line " + std::to_string(number + 1) + " " + std::to_string(file) + "\n";
+                    continue;
+                }
+                std::string name;
+                if (word == "pragma" && directive >> word && word == "permutation" && directive >> name)
+                {
+                    if (std::find(result.permutations.begin(), result.permutations.end(), name) == result.permutations.end())
+                        result.permutations.push_back(name);
+                    result.source += '\n';
+                    continue;
+                }
+            }
+            result.source += line;
+            result.source += '\n';
+        }
+    }
+};
+
+// Every variant of one vertex/fragment pair, built on first use.
+//
+// The sources are preprocessed once. Each "#pragma permutation NAME" found in
+// either stage becomes one bit of a 64-bit key, and get(key) compiles the variant
+// with "#define NAME 1" for every set bit the first time that key is asked for.
+// Resolve keys with key() once at setup; at draw time get() is a single hash
+// lookup, and startup only pays for the variants the scene actually uses.
+class ShaderPermutations
+{
+public:
+    using Key = uint64_t;
+
+    // Optional cache makes a warm start restore binaries instead of compiling
+    ShaderPermutations(const char *vertexPath, const char *fragPath, ShaderCache *cache = nullptr) : cache(cache)
+    {
+        ShaderPreprocessor::Result vs = ShaderPreprocessor::process(vertexPath);
+        ShaderPreprocessor::Result fs = ShaderPreprocessor::process(fragPath);
+        vertexCode = std::move(vs.source);
+        fragCode = std::move(fs.source);
+        vertexFiles = std::move(vs.files);
+        fragFiles = std::move(fs.files);
+        names = std::move(vs.permutations);
+        for (std::string &name : fs.permutations)
+            if (std::find(names.begin(), names.end(), name) == names.end())
+                names.push_back(std::move(name));
+        if (names.size() > 64)
+        {
+            std::cout << "ERROR::SHADER::TOO_MANY_PERMUTATIONS " << names.size() << std::endl;
+            names.resize(64);
+        }
+    }
+
+    ~ShaderPermutations()
+    {
+        for (auto &variant : variants)
+            glDeleteProgram(variant.second.ID);
+    }
+
+    ShaderPermutations(const ShaderPermutations &) = delete;
+    ShaderPermutations &operator=(const ShaderPermutations &) = delete;
+
+    // Builds a key from permutation names, unknown names are reported and ignored
+    Key key(std::initializer_list<const char *> enabled) const
+    {
+        Key k = 0;
+        for (const char *name : enabled)
+        {
+            auto it = std::find(names.begin(), names.end(), name);
+            if (it == names.end())
+                std::cout << "ERROR::SHADER::UNKNOWN_PERMUTATION " << name << std::endl;
+            else
+                k |= Key(1) << (it - names.begin());
+        }
+        return k;
+    }
+
+    // The variant for key, compiled now if this is the first time it's used
+    Shader &get(Key k)
+    {
+        auto it = variants.find(k);
+        if (it != variants.end())
+            return it->second;
+
+        std::string defines = definesFor(k);
+        unsigned int program = cache ? cache->program(vertexCode, fragCode, defines)
+                                     : Shader::link(Shader::injectDefines(vertexCode, defines).c_str(), Shader::injectDefines(fragCode, defines).c_str());
+        int linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            // the logs above number files by source string
+            std::cout << "ERROR::SHADER::PERMUTATION_FAILED " << definesFor(k);
+            for (size_t i = 0; i < vertexFiles.size(); i++)
+                std::cout << "  vertex " << i << ": " << vertexFiles[i] << std::endl;
+            for (size_t i = 0; i < fragFiles.size(); i++)
+                std::cout << "  fragment " << i << ": " << fragFiles[i] << std::endl;
+        }
+        return variants.emplace(k, Shader(program)).first->second;
+    }
+
+    // "#define NAME 1" lines for every bit in key
+    std::string definesFor(Key k) const
+    {
+        std::string defines;
+        for (size_t i = 0; i < names.size(); i++)
+            if (k & (Key(1) << i))
+                defines += "#define " + names[i] + " 1\n";
+        return defines;
+    }
+
+    const std::vector<std::string> &permutations() const { return names; }
+    size_t compiled() const { return variants.size(); }
+
+private:
+    // keys are small bitmasks, spreading them further buys nothing
+    struct IdentityHash
+    {
+        size_t operator()(Key k) const { return (size_t)(k ^ (k >> 32)); }
+    };
+
+    std::string vertexCode, fragCode;
+    std::vector<std::string> vertexFiles, fragFiles;
+    std::vector<std::string> names;
+    std::unordered_map<Key, Shader, IdentityHash> variants;
+    ShaderCache *cache;
+};
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef __SHADERSOURCE_H__
+#define __SHADERSOURCE_H__
+
+#include "glad/glad.h"
+
+#include "Shader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LEARNOPENGL_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Where mmap exists the pages are mapped straight
+// from the page cache, so the bytes handed to glShaderSource are never copied;
+// elsewhere the file is read into one buffer with a single sized read. Mapping has
+// a fixed cost that a plain read of a few KB doesn't, so it pays off for archives
+// and large files, not for single shader sources.
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *path)
+    {
+#ifdef LEARNOPENGL_MMAP
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0)
+        {
+            length = (size_t)info.st_size;
+            if (length == 0)
+                ok = true;
+            else
+            {
+                void *mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (mapped != MAP_FAILED)
+                {
+                    madvise(mapped, length, MADV_SEQUENTIAL);
+                    bytes = (const char *)mapped;
+                    ok = true;
+                }
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = file ? (std::streamoff)file.tellg() : -1;
+        if (size < 0)
+            return;
+        buffer.resize((size_t)size);
+        file.seekg(0);
+        if (!file.read(buffer.data(), size))
+            return;
+        bytes = buffer.data();
+        length = buffer.size();
+        ok = true;
+#endif
+    }
+
+    ~MappedFile() { release(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            bytes = other.bytes;
+            length = other.length;
+            ok = other.ok;
+#ifndef LEARNOPENGL_MMAP
+            buffer = std::move(other.buffer);
+            bytes = buffer.data();
+#endif
+            other.bytes = nullptr;
+            other.length = 0;
+            other.ok = false;
+        }
+        return *this;
+    }
+
+    bool valid() const { return ok; }
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(bytes, length); }
+
+private:
+    void release()
+    {
+#ifdef LEARNOPENGL_MMAP
+        if (bytes)
+            munmap((void *)bytes, length);
+#endif
+        bytes = nullptr;
+    }
+
+    const char *bytes = nullptr;
+    size_t length = 0;
+    bool ok = false;
+#ifndef LEARNOPENGL_MMAP
+    std::vector<char> buffer;
+#endif
+};
+
+// Maps both files and links them, passing explicit lengths so nothing is copied
+// to add a terminator. Returns 0 when either file can't be opened.
+inline unsigned int linkMappedFiles(const char *vertexPath, const char *fragPath)
+{
+    MappedFile vs(vertexPath), fs(fragPath);
+    if (!vs.valid() || !fs.valid())
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        return 0;
+    }
+    return Shader::link(vs.data(), (GLint)vs.size(), fs.data(), (GLint)fs.size());
+}
+
+// Every shader source packed into one file, so startup does a single open/mmap
+// instead of two per program. Sources are stored without terminators and looked
+// up by name with a binary search over the sorted table; nothing is copied.
+//
+// Layout (little endian): "SARC", uint32 count, count * Entry, name bytes, source bytes.
+// Offsets in Entry are from the start of the file.
+class ShaderArchive
+{
+public:
+    struct Entry
+    {
+        uint32_t nameOffset, nameLength;
+        uint32_t dataOffset, dataLength;
+    };
+
+    // Packs files under root, named by their path relative to root with '/' separators
+    static bool write(const std::string &outPath, const std::string &root, std::vector<std::string> files)
+    {
+        struct Source
+        {
+            std::string name, code;
+        };
+        std::vector<Source> sources;
+        for (const std::string &file : files)
+        {
+            std::string name = std::filesystem::path(file).lexically_relative(root).generic_string();
+            sources.push_back({name, Shader::readFile(file.c_str())});
+        }
+        std::sort(sources.begin(), sources.end(), [](const Source &a, const Source &b)
+                  { return a.name < b.name; });
+
+        uint32_t count = (uint32_t)sources.size();
+        std::vector<Entry> entries(count);
+        uint32_t offset = 8 + count * (uint32_t)sizeof(Entry);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            entries[i].nameOffset = offset;
+            entries[i].nameLength = (uint32_t)sources[i].name.size();
+            offset += entries[i].nameLength;
+        }
+        for (uint32_t i = 0; i < count; i++)
+        {
+            entries[i].dataOffset = offset;
+            entries[i].dataLength = (uint32_t)sources[i].code.size();
+            offset += entries[i].dataLength;
+        }
+
+        std::ofstream out(outPath, std::ios::binary);
+        out.write("SARC", 4);
+        out.write((const char *)&count, sizeof(count));
+        out.write((const char *)entries.data(), entries.size() * sizeof(Entry));
+        for (const Source &s : sources)
+            out.write(s.name.data(), s.name.size());
+        for (const Source &s : sources)
+            out.write(s.code.data(), s.code.size());
+        return (bool)out;
+    }
+
+    explicit ShaderArchive(const char *path) : file(path)
+    {
+        if (!file.valid() || file.size() < 8 || memcmp(file.data(), "SARC", 4) != 0)
+        {
+            std::cout << "ERROR::SHADER::ARCHIVE_INVALID " << path << std::endl;
+            return;
+        }
+        uint32_t n;
+        memcpy(&n, file.data() + 4, sizeof(n));
+        if (8 + (uint64_t)n * sizeof(Entry) > file.size())
+        {
+            std::cout << "ERROR::SHADER::ARCHIVE_INVALID " << path << std::endl;
+            return;
+        }
+        entries = (const Entry *)(file.data() + 8);
+        for (uint32_t i = 0; i < n; i++)
+            if ((uint64_t)entries[i].nameOffset + entries[i].nameLength > file.size() ||
+                (uint64_t)entries[i].dataOffset + entries[i].dataLength > file.size())
+            {
+                std::cout << "ERROR::SHADER::ARCHIVE_INVALID " << path << std::endl;
+                entries = nullptr;
+                return;
+            }
+        count = n;
+    }
+
+    bool valid() const { return entries != nullptr; }
+    size_t size() const { return count; }
+
+    // Source for name, empty when the archive doesn't contain it
+    std::string_view find(std::string_view name) const
+    {
+        size_t lo = 0, hi = count;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            std::string_view candidate = nameOf(entries[mid]);
+            if (candidate == name)
+                return std::string_view(file.data() + entries[mid].dataOffset, entries[mid].dataLength);
+            if (candidate < name)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return std::string_view();
+    }
+
+    // Links two archived sources straight out of the mapping, 0 if either is missing
+    unsigned int program(std::string_view vertexName, std::string_view fragName, bool retrievable = false) const
+    {
+        std::string_view vs = find(vertexName), fs = find(fragName);
+        if (vs.empty() || fs.empty())
+        {
+            std::cout << "ERROR::SHADER::ARCHIVE_MISSING " << (vs.empty() ? vertexName : fragName) << std::endl;
+            return 0;
+        }
+        return Shader::link(vs.data(), (GLint)vs.size(), fs.data(), (GLint)fs.size(), retrievable);
+    }
+
+private:
+    std::string_view nameOf(const Entry &e) const { return std::string_view(file.data() + e.nameOffset, e.nameLength); }
+
+    MappedFile file;
+    // points into the mapping, Entry is four uint32_t so the 8 byte header keeps it aligned
+    const Entry *entries = nullptr;
+    uint32_t count = 0;
+};
+
+#endif
@@ -0,0 +1,561 @@
+#ifndef __SOFTWARERASTERIZER_H__
+#define __SOFTWARERASTERIZER_H__
+
+#include "glm/glm.hpp"
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// CPU fallback for the subset of GL the lessons use, for machines without a GPU
+// and for golden-image tests: depth tested (GL_LESS), textured triangles with
+// the projection * view * model transform of lessonshader's MVP variant and its
+// mix(texture1, texture2, 0.2) fragment stage. Both faces are drawn, as GL does
+// with culling off, and textures are sampled GL_REPEAT/GL_LINEAR without mips.
+
+// RGBA8 texture, rows stored the way they were uploaded (v = 0 is the first row)
+struct SoftwareTexture
+{
+    int width = 0, height = 0;
+    std::vector<uint8_t> texels;
+
+    SoftwareTexture() = default;
+    SoftwareTexture(const uint8_t *pixels, int width, int height, int channels) : width(width), height(height), texels((size_t)width * height * 4)
+    {
+        for (size_t i = 0; i < (size_t)width * height; i++)
+            for (int c = 0; c < 4; c++)
+                texels[i * 4 + c] = c < channels ? pixels[i * channels + c] : (c == 3 ? 255 : pixels[i * channels]);
+    }
+
+    // bilinear, repeating, returned in 0..255
+    glm::vec4 sample(float u, float v) const
+    {
+        float x = u * width - 0.5f, y = v * height - 0.5f;
+        int ix = floorToInt(x), iy = floorToInt(y);
+        float tx = x - (float)ix, ty = y - (float)iy;
+        int x0 = wrap(ix, width), x1 = wrap(ix + 1, width);
+        int y0 = wrap(iy, height), y1 = wrap(iy + 1, height);
+        const uint8_t *a = texel(x0, y0), *b = texel(x1, y0), *c = texel(x0, y1), *d = texel(x1, y1);
+        float wa = (1.0f - tx) * (1.0f - ty), wb = tx * (1.0f - ty), wc = (1.0f - tx) * ty, wd = tx * ty;
+        auto blend = [&](int channel)
+        { return a[channel] * wa + b[channel] * wb + c[channel] * wc + d[channel] * wd; };
+        return glm::vec4(blend(0), blend(1), blend(2), blend(3));
+    }
+
+private:
+    static int floorToInt(float f)
+    {
+        int i = (int)f;
+        return i - (f < (float)i);
+    }
+
+    // coordinates are nearly always in range already, only pay for the modulo when not
+    static int wrap(int i, int size)
+    {
+        if ((unsigned)i < (unsigned)size)
+            return i;
+        i %= size;
+        return i < 0 ? i + size : i;
+    }
+
+    const uint8_t *texel(int x, int y) const { return &texels[((size_t)y * width + x) * 4]; }
+};
+
+// Colour (RGBA8) and depth, rows top to bottom. Rows are padded to a multiple
+// of 8 pixels so the rasterizer can always work on whole 8 pixel spans.
+struct SoftwareFramebuffer
+{
+    int width, height, stride;
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+
+    SoftwareFramebuffer(int width, int height)
+        : width(width), height(height), stride((width + 7) & ~7), color((size_t)stride * height), depth((size_t)stride * height) {}
+
+    void clear(glm::vec4 clearColor, float clearDepth = 1.0f)
+    {
+        std::fill(color.begin(), color.end(), pack(clearColor * 255.0f));
+        std::fill(depth.begin(), depth.end(), clearDepth);
+    }
+
+    // tightly packed RGB, top row first, as glReadPixels would give it after a flip
+    std::vector<uint8_t> rgb() const
+    {
+        std::vector<uint8_t> out((size_t)width * height * 3);
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+            {
+                uint32_t c = color[(size_t)y * stride + x];
+                uint8_t *o = &out[((size_t)y * width + x) * 3];
+                o[0] = (uint8_t)c;
+                o[1] = (uint8_t)(c >> 8);
+                o[2] = (uint8_t)(c >> 16);
+            }
+        return out;
+    }
+
+    static uint32_t pack(glm::vec4 c)
+    {
+        auto channel = [](float v)
+        { return (uint32_t)std::clamp(v + 0.5f, 0.0f, 255.0f); };
+        return channel(c.x) | channel(c.y) << 8 | channel(c.z) << 16 | channel(c.w) << 24;
+    }
+};
+
+// Same layout as the lessons' vertex arrays: position then texture coordinate
+struct SoftwareVertex
+{
+    glm::vec3 position;
+    glm::vec2 texCoord;
+};
+
+// Draws are collected by draw(), then flush() rasterizes them:
+//   - triangles are transformed, clipped to the frustum and set up in parallel,
+//     then binned in submission order into 64x64 pixel tiles
+//   - tiles are rasterized in parallel on the JobSystem, each by one worker, so
+//     no two threads ever touch the same pixel
+//   - inside a tile, edge functions and the depth test are evaluated for 8
+//     pixels at a time (AVX2, or two SSE4.1 halves, or plain C++), and only
+//     covered pixels that pass the depth test are shaded
+// Edge functions use 28.4 fixed point and the top-left fill rule, so shared
+// edges are never drawn twice or skipped.
+class SoftwareRasterizer
+{
+public:
+    static constexpr int TileSize = 64;
+    // keeps every 28.4 edge function value inside 32 bits
+    static constexpr int MaxSize = 1920;
+
+    explicit SoftwareRasterizer(JobSystem &jobs) : jobs(jobs)
+    {
+#ifdef LEARNOPENGL_X86
+        if (CpuFeatures::hasAVX2())
+            coverSpan = coverSpanAVX2;
+        else if (CpuFeatures::hasSSE41())
+            coverSpan = coverSpanSSE41;
+#endif
+    }
+
+    void setViewProjection(const glm::mat4 &view, const glm::mat4 &projection) { viewProjection = projection * view; }
+
+    // Both textures must stay alive until flush()
+    void setTextures(const SoftwareTexture *texture1, const SoftwareTexture *texture2)
+    {
+        textures[0] = texture1;
+        textures[1] = texture2;
+    }
+
+    // Non-indexed triangles, like glDrawArrays(GL_TRIANGLES, 0, count)
+    void draw(const SoftwareVertex *vertices, size_t count, const glm::mat4 &model)
+    {
+        draws.push_back({vertices, count / 3, viewProjection * model, {textures[0], textures[1]}});
+    }
+
+    // Rasterizes everything drawn since the last flush into target. Returns false,
+    // leaving target untouched, when it is larger than MaxSize.
+    bool flush(SoftwareFramebuffer &target)
+    {
+        if (target.width > MaxSize || target.height > MaxSize)
+        {
+            std::cout << "ERROR::SOFTWARERASTERIZER::FRAMEBUFFER_TOO_LARGE " << target.width << "x" << target.height << std::endl;
+            draws.clear();
+            return false;
+        }
+        framebuffer = &target;
+        tilesX = (target.width + TileSize - 1) / TileSize;
+        tilesY = (target.height + TileSize - 1) / TileSize;
+        bins.resize((size_t)tilesX * tilesY);
+        for (std::vector<uint32_t> &bin : bins)
+            bin.clear();
+
+        setupTriangles();
+        binTriangles();
+
+        jobs.parallelFor(0, bins.size(), 1, [this](size_t first, size_t last)
+                         {
+            uint64_t shaded = 0;
+            for (size_t tile = first; tile < last; tile++)
+                shaded += rasterizeTile(tile);
+            fragments.fetch_add(shaded, std::memory_order_relaxed); });
+
+        draws.clear();
+        return true;
+    }
+
+    // fragments that passed the depth test and were shaded, since the last reset
+    uint64_t shadedFragments() const { return fragments.load(std::memory_order_relaxed); }
+    void resetStats() { fragments = 0; }
+
+    const char *simdPath() const
+    {
+#ifdef LEARNOPENGL_X86
+        if (coverSpan == coverSpanAVX2)
+            return "AVX2";
+        if (coverSpan == coverSpanSSE41)
+            return "SSE4.1";
+#endif
+        return "scalar";
+    }
+
+private:
+    struct Draw
+    {
+        const SoftwareVertex *vertices;
+        size_t triangles;
+        glm::mat4 mvp;
+        const SoftwareTexture *textures[2];
+    };
+
+    // screen space attribute plane, value = a * x + b * y + c at pixel centres
+    struct Plane
+    {
+        float a, b, c;
+        // grouped like the SIMD paths compute it (AVX2 may still fuse the multiply-add,
+        // so depths can differ in the last bit between paths)
+        float at(float x, float y) const { return a * x + (b * y + c); }
+    };
+
+    // A clipped, snapped triangle ready to rasterize
+    struct Triangle
+    {
+        int minX, minY, maxX, maxY; // inclusive pixel bounds
+        // edge i: e = stepX * x + stepY * y + offset at the centre of pixel (x, y), inside when all >= 0
+        int32_t stepX[3], stepY[3], offset[3];
+        Plane depth, invW, uOverW, vOverW;
+        uint32_t draw;
+    };
+
+    struct ClipVertex
+    {
+        glm::vec4 position;
+        glm::vec2 texCoord;
+    };
+
+    // returns the lanes of the 8 pixel span starting at x, y that are inside the
+    // triangle and closer than depth[0..7], and writes their depth
+    using CoverSpanFn = unsigned (*)(const Triangle &, int x, int y, float *depth);
+
+    static constexpr int SubpixelBits = 4;
+    static constexpr int Subpixel = 1 << SubpixelBits;
+
+    // --- setup ---
+
+    void setupTriangles()
+    {
+        size_t total = 0;
+        for (const Draw &d : draws)
+            total += d.triangles;
+
+        // fixed size chunks of the input, each set up into its own list so the
+        // lists can be concatenated in submission order afterwards
+        const size_t chunkSize = 256;
+        size_t chunks = (total + chunkSize - 1) / chunkSize;
+        chunkTriangles.resize(chunks);
+        drawStart.clear();
+        size_t start = 0;
+        for (const Draw &d : draws)
+        {
+            drawStart.push_back(start);
+            start += d.triangles;
+        }
+
+        jobs.parallelFor(0, chunks, 1, [&](size_t first, size_t last)
+                         {
+            for (size_t chunk = first; chunk < last; chunk++)
+            {
+                std::vector<Triangle> &out = chunkTriangles[chunk];
+                out.clear();
+                size_t begin = chunk * chunkSize, end = std::min(total, begin + chunkSize);
+                // first draw containing begin
+                size_t d = std::upper_bound(drawStart.begin(), drawStart.end(), begin) - drawStart.begin() - 1;
+                for (size_t t = begin; t < end; t++)
+                {
+                    while (t >= drawStart[d] + draws[d].triangles)
+                        d++;
+                    setupTriangle((uint32_t)d, t - drawStart[d], out);
+                }
+            } });
+    }
+
+    void setupTriangle(uint32_t drawIndex, size_t index, std::vector<Triangle> &out) const
+    {
+        const Draw &d = draws[drawIndex];
+        ClipVertex polygon[9], scratch[9];
+        for (int i = 0; i < 3; i++)
+        {
+            const SoftwareVertex &v = d.vertices[index * 3 + i];
+            polygon[i] = {d.mvp * glm::vec4(v.position, 1.0f), v.texCoord};
+        }
+        int count = clip(polygon, scratch, 3);
+        // fan out whatever is left of the triangle
+        for (int i = 1; i + 1 < count; i++)
+            setupClipped(drawIndex, polygon[0], polygon[i], polygon[i + 1], out);
+    }
+
+    // Sutherland-Hodgman against the six clip planes, result ends up in polygon
+    static int clip(ClipVertex *polygon, ClipVertex *scratch, int count)
+    {
+        for (int plane = 0; plane < 6 && count > 0; plane++)
+        {
+            auto distance = [plane](const glm::vec4 &p)
+            {
+                float coordinate = plane < 2 ? p.x : plane < 4 ? p.y : p.z;
+                return (plane & 1) ? p.w - coordinate : p.w + coordinate;
+            };
+            int outCount = 0;
+            for (int i = 0; i < count; i++)
+            {
+                const ClipVertex &a = polygon[i], &b = polygon[(i + 1) % count];
+                float da = distance(a.position), db = distance(b.position);
+                if (da >= 0.0f)
+                    scratch[outCount++] = a;
+                if ((da >= 0.0f) != (db >= 0.0f))
+                {
+                    float t = da / (da - db);
+                    scratch[outCount++] = {glm::mix(a.position, b.position, t), glm::mix(a.texCoord, b.texCoord, t)};
+                }
+            }
+            std::copy(scratch, scratch + outCount, polygon);
+            count = outCount;
+        }
+        return count;
+    }
+
+    void setupClipped(uint32_t drawIndex, const ClipVertex &c0, const ClipVertex &c1, const ClipVertex &c2, std::vector<Triangle> &out) const
+    {
+        const ClipVertex *clipped[3] = {&c0, &c1, &c2};
+        const int width = framebuffer->width, height = framebuffer->height;
+        int32_t x[3], y[3];
+        float z[3], invW[3], u[3], v[3];
+        for (int i = 0; i < 3; i++)
+        {
+            const glm::vec4 &p = clipped[i]->position;
+            invW[i] = 1.0f / p.w;
+            // NDC to window, y flipped so row 0 is the top; clipping can leave a rounding error's worth outside
+            float sx = (p.x * invW[i] * 0.5f + 0.5f) * width, sy = (0.5f - p.y * invW[i] * 0.5f) * height;
+            x[i] = std::clamp((int32_t)std::lround(sx * Subpixel), 0, width * Subpixel);
+            y[i] = std::clamp((int32_t)std::lround(sy * Subpixel), 0, height * Subpixel);
+            z[i] = p.z * invW[i] * 0.5f + 0.5f;
+            u[i] = clipped[i]->texCoord.x * invW[i];
+            v[i] = clipped[i]->texCoord.y * invW[i];
+        }
+
+        // twice the signed area, made positive so both faces share one inside test
+        int64_t area = (int64_t)(x[1] - x[0]) * (y[2] - y[0]) - (int64_t)(y[1] - y[0]) * (x[2] - x[0]);
+        if (area == 0)
+            return;
+        if (area < 0)
+        {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(z[1], z[2]);
+            std::swap(invW[1], invW[2]);
+            std::swap(u[1], u[2]);
+            std::swap(v[1], v[2]);
+            area = -area;
+        }
+
+        Triangle t;
+        t.draw = drawIndex;
+        // pixels whose centres might be covered
+        t.minX = std::max(0, (std::min({x[0], x[1], x[2]}) - Subpixel / 2) >> SubpixelBits);
+        t.minY = std::max(0, (std::min({y[0], y[1], y[2]}) - Subpixel / 2) >> SubpixelBits);
+        t.maxX = std::min(width - 1, (std::max({x[0], x[1], x[2]}) - Subpixel / 2) >> SubpixelBits);
+        t.maxY = std::min(height - 1, (std::max({y[0], y[1], y[2]}) - Subpixel / 2) >> SubpixelBits);
+        if (t.minX > t.maxX || t.minY > t.maxY)
+            return;
+
+        // edge i runs from vertex i+1 to i+2, so it's zero at both and weighs vertex i
+        float a[3], b[3], c[3];
+        const float invArea = 1.0f / (float)area;
+        for (int i = 0; i < 3; i++)
+        {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            int32_t dx = x[k] - x[j], dy = y[k] - y[j];
+            // e(p) = dx * (p.y - y[j]) - dy * (p.x - x[j]) in subpixels, evaluated at (16x + 8, 16y + 8)
+            // (the value at pixel (0, 0), so it fits 32 bits even though the products may not)
+            int32_t c0 = (int32_t)((int64_t)dy * x[j] - (int64_t)dx * y[j]);
+            t.stepX[i] = -dy * Subpixel;
+            t.stepY[i] = dx * Subpixel;
+            t.offset[i] = c0 + (-dy + dx) * (Subpixel / 2);
+            // top-left rule: pixels exactly on an edge only belong to top or left edges
+            bool topLeft = (dy == 0 && dx > 0) || dy < 0;
+            if (!topLeft)
+                t.offset[i] -= 1;
+            a[i] = (float)t.stepX[i] * invArea;
+            b[i] = (float)t.stepY[i] * invArea;
+            c[i] = (float)(c0 + (-dy + dx) * (Subpixel / 2)) * invArea;
+        }
+        auto plane = [&](const float *value)
+        {
+            return Plane{a[0] * value[0] + a[1] * value[1] + a[2] * value[2],
+                         b[0] * value[0] + b[1] * value[1] + b[2] * value[2],
+                         c[0] * value[0] + c[1] * value[1] + c[2] * value[2]};
+        };
+        t.depth = plane(z);
+        t.invW = plane(invW);
+        t.uOverW = plane(u);
+        t.vOverW = plane(v);
+        out.push_back(t);
+    }
+
+    // --- binning ---
+
+    void binTriangles()
+    {
+        triangles.clear();
+        for (std::vector<Triangle> &chunk : chunkTriangles)
+            triangles.insert(triangles.end(), chunk.begin(), chunk.end());
+        for (uint32_t i = 0; i < triangles.size(); i++)
+        {
+            const Triangle &t = triangles[i];
+            for (int ty = t.minY / TileSize; ty <= t.maxY / TileSize; ty++)
+                for (int tx = t.minX / TileSize; tx <= t.maxX / TileSize; tx++)
+                    bins[(size_t)ty * tilesX + tx].push_back(i);
+        }
+    }
+
+    // --- rasterization ---
+
+    uint64_t rasterizeTile(size_t tile)
+    {
+        const int tileX = (int)(tile % tilesX) * TileSize, tileY = (int)(tile / tilesX) * TileSize;
+        const int tileMaxX = std::min(framebuffer->width, tileX + TileSize) - 1;
+        const int tileMaxY = std::min(framebuffer->height, tileY + TileSize) - 1;
+        uint64_t shaded = 0;
+        for (uint32_t index : bins[tile])
+        {
+            const Triangle &t = triangles[index];
+            // spans start on multiples of 8, tiles and rows are padded to match
+            int x0 = std::max(t.minX, tileX) & ~7, x1 = std::min(t.maxX, tileMaxX);
+            int y0 = std::max(t.minY, tileY), y1 = std::min(t.maxY, tileMaxY);
+            for (int y = y0; y <= y1; y++)
+            {
+                float *depthRow = &framebuffer->depth[(size_t)y * framebuffer->stride];
+                for (int x = x0; x <= x1; x += 8)
+                {
+                    // lanes past the right edge land in the row padding, and are never covered
+                    unsigned mask = coverSpan(t, x, y, depthRow + x);
+                    while (mask)
+                    {
+                        int lane = std::countr_zero(mask);
+                        mask &= mask - 1;
+                        shade(t, x + lane, y);
+                        shaded++;
+                    }
+                }
+            }
+        }
+        return shaded;
+    }
+
+    // lessonshader.fs: mix(texture(texture1, uv), texture(texture2, uv), 0.2)
+    void shade(const Triangle &t, int x, int y) const
+    {
+        float px = (float)x, py = (float)y;
+        float w = 1.0f / t.invW.at(px, py);
+        float u = t.uOverW.at(px, py) * w, v = t.vOverW.at(px, py) * w;
+        const Draw &d = draws[t.draw];
+        glm::vec4 color = glm::mix(d.textures[0]->sample(u, v), d.textures[1]->sample(u, v), 0.2f);
+        framebuffer->color[(size_t)y * framebuffer->stride + x] = SoftwareFramebuffer::pack(color);
+    }
+
+    static unsigned coverSpanScalar(const Triangle &t, int x, int y, float *depth)
+    {
+        unsigned mask = 0;
+        for (int lane = 0; lane < 8; lane++)
+        {
+            int px = x + lane;
+            bool inside = true;
+            for (int i = 0; i < 3; i++)
+                inside &= t.stepX[i] * px + t.stepY[i] * y + t.offset[i] >= 0;
+            if (!inside)
+                continue;
+            float z = t.depth.at((float)px, (float)y);
+            if (z < depth[lane])
+            {
+                depth[lane] = z;
+                mask |= 1u << lane;
+            }
+        }
+        return mask;
+    }
+
+#ifdef LEARNOPENGL_X86
+    TARGET_AVX2 static unsigned coverSpanAVX2(const Triangle &t, int x, int y, float *depth)
+    {
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i px = _mm256_add_epi32(_mm256_set1_epi32(x), lanes);
+        // the sign bit of (e0 | e1 | e2) is clear only when all three are >= 0
+        __m256i inside = _mm256_setzero_si256();
+        for (int i = 0; i < 3; i++)
+        {
+            __m256i e = _mm256_add_epi32(_mm256_mullo_epi32(px, _mm256_set1_epi32(t.stepX[i])), _mm256_set1_epi32(t.stepY[i] * y + t.offset[i]));
+            inside = _mm256_or_si256(inside, e);
+        }
+        unsigned covered = ~(unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(inside)) & 0xff;
+        if (!covered)
+            return 0;
+        __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(px), _mm256_set1_ps(t.depth.a)), _mm256_set1_ps(t.depth.b * (float)y + t.depth.c));
+        __m256 old = _mm256_loadu_ps(depth);
+        unsigned mask = covered & (unsigned)_mm256_movemask_ps(_mm256_cmp_ps(z, old, _CMP_LT_OQ));
+        // write the new depth into passing lanes only
+        __m256i laneBits = _mm256_and_si256(_mm256_set1_epi32((int)mask), _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128));
+        __m256 pass = _mm256_castsi256_ps(_mm256_cmpgt_epi32(laneBits, _mm256_setzero_si256()));
+        _mm256_storeu_ps(depth, _mm256_blendv_ps(old, z, pass));
+        return mask;
+    }
+
+    TARGET_SSE41 static unsigned coverSpanSSE41(const Triangle &t, int x, int y, float *depth)
+    {
+        unsigned mask = 0;
+        for (int half = 0; half < 2; half++)
+        {
+            const __m128i px = _mm_add_epi32(_mm_set1_epi32(x + half * 4), _mm_setr_epi32(0, 1, 2, 3));
+            __m128i inside = _mm_setzero_si128();
+            for (int i = 0; i < 3; i++)
+            {
+                __m128i e = _mm_add_epi32(_mm_mullo_epi32(px, _mm_set1_epi32(t.stepX[i])), _mm_set1_epi32(t.stepY[i] * y + t.offset[i]));
+                inside = _mm_or_si128(inside, e);
+            }
+            unsigned covered = ~(unsigned)_mm_movemask_ps(_mm_castsi128_ps(inside)) & 0xf;
+            if (!covered)
+                continue;
+            float *d = depth + half * 4;
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(px), _mm_set1_ps(t.depth.a)), _mm_set1_ps(t.depth.b * (float)y + t.depth.c));
+            __m128 old = _mm_loadu_ps(d);
+            unsigned pass = covered & (unsigned)_mm_movemask_ps(_mm_cmplt_ps(z, old));
+            __m128i laneBits = _mm_and_si128(_mm_set1_epi32((int)pass), _mm_setr_epi32(1, 2, 4, 8));
+            _mm_storeu_ps(d, _mm_blendv_ps(old, z, _mm_castsi128_ps(_mm_cmpgt_epi32(laneBits, _mm_setzero_si128()))));
+            mask |= pass << (half * 4);
+        }
+        return mask;
+    }
+#endif
+
+    JobSystem &jobs;
+    CoverSpanFn coverSpan = coverSpanScalar;
+
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    const SoftwareTexture *textures[2] = {nullptr, nullptr};
+    std::vector<Draw> draws;
+    std::vector<size_t> drawStart;
+
+    SoftwareFramebuffer *framebuffer = nullptr;
+    int tilesX = 0, tilesY = 0;
+    std::vector<std::vector<Triangle>> chunkTriangles;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<uint32_t>> bins;
+
+    std::atomic<uint64_t> fragments{0};
+};
+
+#endif
@@ -0,0 +1,322 @@
+#ifndef __TEXTUREARRAY_H__
+#define __TEXTUREARRAY_H__
+
+#include "glad/glad.h"
+
+#include "glm/glm.hpp"
+
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Where a texture ended up inside a GL_TEXTURE_2D_ARRAY: the layer and the
+// sub rectangle of that layer as (u offset, v offset, u scale, v scale)
+struct TextureRegion
+{
+    float layer;
+    glm::vec4 rect;
+};
+
+// Skyline bottom-left rectangle packer. Keeps the top edge of everything placed
+// so far as a list of horizontal segments and puts each new rectangle where it
+// ends up lowest, which keeps wasted space low for mixed size textures.
+class SkylinePacker
+{
+public:
+    SkylinePacker(int width, int height) : width(width), height(height)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        skyline.clear();
+        skyline.push_back({0, 0, width});
+    }
+
+    // Finds room for a w*h rectangle, returns false when the page is full
+    bool pack(int w, int h, int &outX, int &outY)
+    {
+        int bestIndex = -1, bestX = 0, bestY = height, bestWidth = width + 1;
+        for (size_t i = 0; i < skyline.size(); i++)
+        {
+            int y;
+            if (!fits(i, w, h, y))
+                continue;
+            if (y < bestY || (y == bestY && skyline[i].width < bestWidth))
+            {
+                bestIndex = (int)i;
+                bestX = skyline[i].x;
+                bestY = y;
+                bestWidth = skyline[i].width;
+            }
+        }
+        if (bestIndex < 0)
+            return false;
+
+        addLevel(bestIndex, bestX, bestY + h, w);
+        outX = bestX;
+        outY = bestY;
+        return true;
+    }
+
+private:
+    struct Segment
+    {
+        int x, y, width;
+    };
+
+    // Can a rect starting at segment i sit on the skyline? y is the resulting bottom edge.
+    bool fits(size_t i, int w, int h, int &y) const
+    {
+        int x = skyline[i].x;
+        if (x + w > width)
+            return false;
+        int remaining = w;
+        y = skyline[i].y;
+        while (remaining > 0)
+        {
+            if (i >= skyline.size())
+                return false;
+            y = std::max(y, skyline[i].y);
+            if (y + h > height)
+                return false;
+            remaining -= skyline[i].width;
+            i++;
+        }
+        return true;
+    }
+
+    void addLevel(int index, int x, int y, int w)
+    {
+        skyline.insert(skyline.begin() + index, {x, y, w});
+
+        // trim or remove the segments now hidden under the new one
+        for (size_t i = index + 1; i < skyline.size();)
+        {
+            Segment &prev = skyline[i - 1];
+            Segment &cur = skyline[i];
+            if (cur.x >= prev.x + prev.width)
+                break;
+            int shrink = prev.x + prev.width - cur.x;
+            cur.x += shrink;
+            cur.width -= shrink;
+            if (cur.width > 0)
+                break;
+            skyline.erase(skyline.begin() + i);
+        }
+
+        // merge neighbours at the same height
+        for (size_t i = 0; i + 1 < skyline.size();)
+        {
+            if (skyline[i].y == skyline[i + 1].y)
+            {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + i + 1);
+            }
+            else
+                i++;
+        }
+    }
+
+    int width, height;
+    std::vector<Segment> skyline;
+};
+
+// Collects textures into the layers of one GL_TEXTURE_2D_ARRAY so every material
+// can be sampled through a single binding.
+//
+// Textures matching the layer size get a layer to themselves. Anything else is
+// packed into shared atlas layers with a border of replicated edge texels, so
+// sampling lower mip levels doesn't pull in colour from a neighbouring texture.
+class TextureArrayBuilder
+{
+public:
+    TextureArrayBuilder(int layerWidth, int layerHeight, int padding = 4)
+        : layerWidth(layerWidth), layerHeight(layerHeight), padding(padding)
+    {
+    }
+
+    // Copies the image (1 to 4 channels, 8 bits each) into the array and returns where it landed.
+    // Mip options only apply to textures that get a layer of their own.
+    TextureRegion add(const unsigned char *pixels, int width, int height, int channels, const MipOptions &mips = MipOptions())
+    {
+        if (width == layerWidth && height == layerHeight)
+        {
+            layers.push_back(Layer{std::vector<unsigned char>((size_t)layerWidth * layerHeight * 4), nullptr, mips});
+            blit(layers.back().pixels, pixels, width, height, channels, 0, 0);
+            return {(float)(layers.size() - 1), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)};
+        }
+
+        // keep packed rects aligned to the padding so mip boundaries line up with the borders
+        int paddedW = align(width + 2 * padding), paddedH = align(height + 2 * padding);
+        int x = 0, y = 0;
+        size_t layer = 0;
+        for (; layer < layers.size(); layer++)
+            if (layers[layer].packer && layers[layer].packer->pack(paddedW, paddedH, x, y))
+                break;
+        if (layer == layers.size())
+        {
+            MipOptions atlasMips;
+            atlasMips.maxLevels = maxBleedFreeLevel() + 1;
+            layers.push_back(Layer{std::vector<unsigned char>((size_t)layerWidth * layerHeight * 4),
+                                   std::make_shared<SkylinePacker>(layerWidth, layerHeight), atlasMips});
+            if (!layers.back().packer->pack(paddedW, paddedH, x, y))
+            {
+                std::cout << "ERROR::TEXTUREARRAY::IMAGE_LARGER_THAN_LAYER" << std::endl;
+                layers.pop_back();
+                return {0.0f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)};
+            }
+        }
+
+        blit(layers[layer].pixels, pixels, width, height, channels, x + padding, y + padding);
+        return {(float)layer, glm::vec4((float)(x + padding) / layerWidth, (float)(y + padding) / layerHeight,
+                                        (float)width / layerWidth, (float)height / layerHeight)};
+    }
+
+    int layerCount() const { return (int)layers.size(); }
+
+    // Builds every layer's mip chain on the CPU. Doesn't touch GL, so it can run on a
+    // loader thread ahead of build(). Layers are filtered one after another, each
+    // spread over all cores.
+    void generateMips()
+    {
+        // every layer of an array shares one level count, so cap them all to the shortest chain
+        int levels = 0;
+        for (const Layer &layer : layers)
+            if (layer.mips.maxLevels > 0)
+                levels = levels == 0 ? layer.mips.maxLevels : std::min(levels, layer.mips.maxLevels);
+
+        chains.clear();
+        for (const Layer &layer : layers)
+        {
+            MipOptions options = layer.mips;
+            options.maxLevels = levels;
+            chains.push_back(MipGenerator::generate(layer.pixels.data(), layerWidth, layerHeight, options));
+        }
+    }
+
+    // Uploads every layer and all of its levels as RGBA8, returns the texture name
+    GLuint build()
+    {
+        if (chains.size() != layers.size())
+            generateMips();
+        GLint levels = chains.empty() ? 1 : (GLint)chains[0].levels.size();
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (GLint level = 0; level < levels; level++)
+        {
+            const MipChain::Level &size = chains[0].levels[level];
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size.width, size.height, (GLsizei)layers.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            for (size_t i = 0; i < chains.size(); i++)
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, (GLint)i, size.width, size.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, chains[i].levels[level].pixels.data());
+        }
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        return texture;
+    }
+
+private:
+    struct Layer
+    {
+        std::vector<unsigned char> pixels;
+        std::shared_ptr<SkylinePacker> packer; // null for layers holding one full size texture
+        MipOptions mips;
+    };
+
+    int align(int v) const
+    {
+        int a = padding > 0 ? padding : 1;
+        return (v + a - 1) / a * a;
+    }
+
+    // past this level the padding is less than a texel and packed textures start to bleed
+    int maxBleedFreeLevel() const
+    {
+        int level = 0;
+        while ((padding >> (level + 1)) > 0)
+            level++;
+        return level;
+    }
+
+    // Expands to RGBA8 at (dstX, dstY) and replicates the edge texels out into the padding
+    void blit(std::vector<unsigned char> &dst, const unsigned char *src, int width, int height, int channels, int dstX, int dstY) const
+    {
+        int x0 = std::max(0, dstX - padding), x1 = std::min(layerWidth, dstX + width + padding);
+        int y0 = std::max(0, dstY - padding), y1 = std::min(layerHeight, dstY + height + padding);
+        for (int y = y0; y < y1; y++)
+        {
+            int sy = std::clamp(y - dstY, 0, height - 1);
+            for (int x = x0; x < x1; x++)
+            {
+                int sx = std::clamp(x - dstX, 0, width - 1);
+                const unsigned char *s = src + ((size_t)sy * width + sx) * channels;
+                unsigned char *d = dst.data() + ((size_t)y * layerWidth + x) * 4;
+                switch (channels)
+                {
+                case 1:
+                    d[0] = d[1] = d[2] = s[0], d[3] = 255;
+                    break;
+                case 2:
+                    d[0] = d[1] = d[2] = s[0], d[3] = s[1];
+                    break;
+                case 3:
+                    d[0] = s[0], d[1] = s[1], d[2] = s[2], d[3] = 255;
+                    break;
+                default:
+                    memcpy(d, s, 4);
+                    break;
+                }
+            }
+        }
+    }
+
+    int layerWidth, layerHeight, padding;
+    std::vector<Layer> layers;
+    std::vector<MipChain> chains;
+};
+
+// Per instance vertex data for drawing array textured meshes in one instanced call.
+// Each instance carries its model matrix and the regions for both material slots.
+struct TexturedInstance
+{
+    glm::mat4 model;
+    glm::vec4 rect1;
+    glm::vec4 rect2;
+    glm::vec2 layers;
+};
+
+// Points attribute locations [first, first + 7) at a buffer of TexturedInstance,
+// matching the layout in shaders/instancedshader.vs. The instance VBO must be bound.
+inline void setupTexturedInstanceAttributes(GLuint first)
+{
+    const GLsizei stride = sizeof(TexturedInstance);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(first + column, 4, GL_FLOAT, GL_FALSE, stride, (void *)(offsetof(TexturedInstance, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(first + column);
+        glVertexAttribDivisor(first + column, 1);
+    }
+    glVertexAttribPointer(first + 4, 4, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(TexturedInstance, rect1));
+    glVertexAttribPointer(first + 5, 4, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(TexturedInstance, rect2));
+    glVertexAttribPointer(first + 6, 2, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(TexturedInstance, layers));
+    for (GLuint a = first + 4; a < first + 7; a++)
+    {
+        glEnableVertexAttribArray(a);
+        glVertexAttribDivisor(a, 1);
+    }
+}
+
+#endif
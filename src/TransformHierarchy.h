@@ -0,0 +1,302 @@
+#ifndef __TRANSFORMHIERARCHY_H__
+#define __TRANSFORMHIERARCHY_H__
+
+#include "JobSystem.h"
+
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Parent-child transforms kept in breadth-first order: every parent comes before
+// its children, the children of a node are contiguous and each depth is one range.
+// World matrices are world[parent] * local, so a single forward pass computes them.
+//
+// setLocal only flags the node. update() then recomputes the flagged nodes and their
+// descendants, either with a dense pass over every level that skips clean nodes, or,
+// when few nodes changed, by following just the changed subtrees through the child
+// ranges. Nodes on one level never depend on each other, so with a JobSystem each
+// level, whichever subtrees it holds, is spread over the workers.
+//
+// Node ids are stable; adding nodes re-sorts the arrays on the next update.
+class TransformHierarchy
+{
+public:
+    using Node = uint32_t;
+    static constexpr Node NoParent = ~0u;
+
+    enum class Propagation
+    {
+        Auto,   // sparse below sparseFraction of the nodes flagged, dense otherwise
+        Dense,  // one pass per level over all the nodes
+        Sparse, // visit the flagged subtrees only
+    };
+
+    // TransformHierarchyBench on 1M nodes: sparse wins at 0.2% flagged (2.2 vs 2.8 ms), breaks even
+    // around 0.5% and loses from 1% up (10.8 vs 9.9 ms), so switch a little below the crossover
+    explicit TransformHierarchy(float sparseFraction = 1.0f / 256.0f) : sparseFraction(sparseFraction) {}
+
+    // parent must already exist, so parents always have lower ids than their children
+    Node add(const glm::mat4 &local, Node parent = NoParent)
+    {
+        Node node = (Node)parentById.size();
+        parentById.push_back(parent < node ? parent : NoParent);
+        indexById.push_back(NoParent);
+        pendingLocal.push_back(local);
+        sorted = false;
+        return node;
+    }
+
+    void setLocal(Node node, const glm::mat4 &local)
+    {
+        if (!sorted)
+            sort();
+        uint32_t i = indexById[node];
+        locals[i] = local;
+        if (!dirty[i])
+        {
+            dirty[i] = 1;
+            dirtyList.push_back(i);
+        }
+    }
+
+    const glm::mat4 &local(Node node)
+    {
+        if (!sorted)
+            sort();
+        return locals[indexById[node]];
+    }
+
+    // As of the last update()
+    const glm::mat4 &world(Node node)
+    {
+        if (!sorted)
+            sort();
+        return worlds[indexById[node]];
+    }
+
+    Node parent(Node node) const { return parentById[node]; }
+    size_t size() const { return parentById.size(); }
+    size_t depth() const { return levelStart.empty() ? 0 : levelStart.size() - 1; }
+
+    // Breadth-first position of a node in worldMatrices()
+    uint32_t indexOf(Node node)
+    {
+        if (!sorted)
+            sort();
+        return indexById[node];
+    }
+
+    const std::vector<glm::mat4> &worldMatrices() const { return worlds; }
+
+    void setPropagation(Propagation mode) { propagation = mode; }
+
+    // Nodes whose world matrix the last update() recomputed
+    size_t lastUpdated() const { return updated; }
+
+    void update() { update(nullptr); }
+    void update(JobSystem &jobs) { update(&jobs); }
+
+private:
+    void update(JobSystem *jobs)
+    {
+        if (!sorted)
+            sort();
+        updated = 0;
+        if (dirtyList.empty())
+            return;
+        bool sparse = propagation == Propagation::Sparse ||
+                      (propagation == Propagation::Auto && dirtyList.size() < sparseFraction * parents.size());
+        if (sparse)
+            updateSparse(jobs);
+        else
+            updateDense(jobs);
+        dirtyList.clear();
+    }
+
+    void updateDense(JobSystem *jobs)
+    {
+        for (size_t l = 0; l + 1 < levelStart.size(); l++)
+        {
+            auto pass = [&](size_t first, size_t last)
+            {
+                size_t count = 0;
+                for (size_t i = first; i < last; i++)
+                {
+                    uint32_t p = parents[i];
+                    if (p == NoParent)
+                    {
+                        if (dirty[i])
+                        {
+                            worlds[i] = locals[i];
+                            count++;
+                        }
+                    }
+                    else if (dirty[i] | dirty[p])
+                    {
+                        worlds[i] = worlds[p] * locals[i];
+                        dirty[i] = 1; // passes the change on to the next level
+                        count++;
+                    }
+                }
+                return count;
+            };
+            if (jobs)
+            {
+                std::atomic<size_t> count{0};
+                jobs->parallelFor(levelStart[l], levelStart[l + 1], 2048, [&](size_t first, size_t last)
+                                  { count.fetch_add(pass(first, last), std::memory_order_relaxed); });
+                updated += count.load();
+            }
+            else
+                updated += pass(levelStart[l], levelStart[l + 1]);
+        }
+        std::memset(dirty.data(), 0, dirty.size());
+    }
+
+    void updateSparse(JobSystem *jobs)
+    {
+        // Only flagged nodes with no flagged ancestor start a subtree, so the
+        // subtrees are disjoint and cover everything that changed
+        roots.clear();
+        for (uint32_t i : dirtyList)
+        {
+            uint32_t p = parents[i];
+            while (p != NoParent && !dirty[p])
+                p = parents[p];
+            if (p == NoParent)
+                roots.push_back(i);
+        }
+        std::sort(roots.begin(), roots.end());
+
+        // Level by level, the subtree roots of the level merged with the children of
+        // the nodes done on the level above. Both lists are in breadth-first order,
+        // so each level is visited front to back rather than one subtree at a time.
+        size_t r = 0;
+        frontier.clear();
+        for (size_t l = 0; l + 1 < levelStart.size() && (r < roots.size() || !frontier.empty()); l++)
+        {
+            size_t begin = r;
+            while (r < roots.size() && roots[r] < levelStart[l + 1])
+                r++;
+            current.resize(frontier.size() + r - begin);
+            std::merge(frontier.begin(), frontier.end(), roots.begin() + begin, roots.begin() + r, current.begin());
+
+            childOffsets.resize(current.size() + 1);
+            childOffsets[0] = 0;
+            for (size_t k = 0; k < current.size(); k++)
+                childOffsets[k + 1] = childOffsets[k] + childCount[current[k]];
+            frontier.resize(childOffsets.back());
+
+            auto pass = [&](size_t first, size_t last)
+            {
+                for (size_t k = first; k < last; k++)
+                {
+                    uint32_t n = current[k], p = parents[n];
+                    worlds[n] = p == NoParent ? locals[n] : worlds[p] * locals[n];
+                    dirty[n] = 0;
+                    for (uint32_t c = 0; c < childCount[n]; c++)
+                        frontier[childOffsets[k] + c] = firstChild[n] + c;
+                }
+            };
+            if (jobs)
+                jobs->parallelFor(0, current.size(), 1024, pass);
+            else
+                pass(0, current.size());
+            updated += current.size();
+        }
+    }
+
+    // Breadth-first order: roots by id, then the children of each level's nodes in
+    // that level's order. Every node gets recomputed on the next update.
+    void sort()
+    {
+        size_t n = parentById.size();
+        std::vector<uint32_t> childOffset(n + 1, 0), childrenById(n);
+        for (Node node = 0; node < n; node++)
+            if (parentById[node] != NoParent)
+                childOffset[parentById[node] + 1]++;
+        for (size_t i = 0; i < n; i++)
+            childOffset[i + 1] += childOffset[i];
+        std::vector<uint32_t> fill(childOffset.begin(), childOffset.end() - 1);
+        for (Node node = 0; node < n; node++)
+            if (parentById[node] != NoParent)
+                childrenById[fill[parentById[node]]++] = node;
+
+        std::vector<Node> order;
+        order.reserve(n);
+        for (Node node = 0; node < n; node++)
+            if (parentById[node] == NoParent)
+                order.push_back(node);
+        levelStart.assign(1, 0);
+        for (size_t begin = 0; begin < order.size();)
+        {
+            size_t end = order.size();
+            levelStart.push_back((uint32_t)end);
+            for (size_t i = begin; i < end; i++)
+                for (uint32_t c = childOffset[order[i]]; c < childOffset[order[i] + 1]; c++)
+                    order.push_back(childrenById[c]);
+            begin = end;
+        }
+
+        std::vector<glm::mat4> newLocals(n), newWorlds(n);
+        std::vector<uint32_t> newIndex(n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            Node node = order[i];
+            newIndex[node] = i;
+            if (node < sortedCount)
+            {
+                newLocals[i] = locals[indexById[node]];
+                newWorlds[i] = worlds[indexById[node]];
+            }
+            else
+                newLocals[i] = pendingLocal[node - sortedCount];
+        }
+        locals.swap(newLocals);
+        worlds.swap(newWorlds);
+        indexById.swap(newIndex);
+        pendingLocal.clear();
+        sortedCount = n;
+
+        parents.resize(n);
+        firstChild.resize(n);
+        childCount.resize(n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            Node node = order[i];
+            parents[i] = parentById[node] == NoParent ? NoParent : indexById[parentById[node]];
+            uint32_t count = childOffset[node + 1] - childOffset[node];
+            childCount[i] = count;
+            firstChild[i] = count ? indexById[childrenById[childOffset[node]]] : 0;
+        }
+        dirty.assign(n, 1);
+        dirtyList.resize(n);
+        for (uint32_t i = 0; i < n; i++)
+            dirtyList[i] = i;
+        sorted = true;
+    }
+
+    // by id
+    std::vector<Node> parentById;
+    std::vector<uint32_t> indexById;
+    std::vector<glm::mat4> pendingLocal; // locals of the nodes added since the last sort
+    size_t sortedCount = 0;             // ids below this are in the arrays below
+
+    // breadth-first order
+    std::vector<uint32_t> parents, firstChild, childCount;
+    std::vector<glm::mat4> locals, worlds;
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> levelStart; // first index of each depth, plus the end
+
+    std::vector<uint32_t> dirtyList, roots, current, frontier, childOffsets;
+    Propagation propagation = Propagation::Auto;
+    float sparseFraction;
+    size_t updated = 0;
+    bool sorted = true;
+};
+
+#endif
@@ -0,0 +1,255 @@
+#ifndef __UNIFORMBLOCK_H__
+#define __UNIFORMBLOCK_H__
+
+#include "glad/glad.h"
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Typed std140 uniform blocks.
+//
+// A plain C++ struct is described once with UniformBlockTraits: the GLSL block
+// name and its members in declaration order. At compile time every member's
+// offsetof is checked against where std140 would put it, so a struct that can't
+// be memcpy'd straight into the buffer doesn't build (the usual fix is padding or
+// alignas(16) before a vec3/vec4). At link time validateUniformBlock compares the
+// same description with glGetActiveUniformBlockiv/glGetActiveUniformsiv, which
+// catches a shader that was edited without the struct or not declared std140.
+//
+//     struct alignas(16) FrameUniforms { glm::mat4 view; glm::mat4 projection; };
+//     template <> struct UniformBlockTraits<FrameUniforms>
+//     {
+//         static constexpr const char *name = "Frame";
+//         static constexpr UniformField fields[] = {UNIFORM_FIELD(FrameUniforms, view), UNIFORM_FIELD(FrameUniforms, projection)};
+//     };
+
+// std140 base alignment, size and GL type of the supported member types
+template <typename T>
+struct Std140;
+
+template <>
+struct Std140<float>
+{
+    static constexpr size_t align = 4, size = 4;
+    static constexpr GLenum type = GL_FLOAT;
+};
+template <>
+struct Std140<int>
+{
+    static constexpr size_t align = 4, size = 4;
+    static constexpr GLenum type = GL_INT;
+};
+template <>
+struct Std140<unsigned int>
+{
+    static constexpr size_t align = 4, size = 4;
+    static constexpr GLenum type = GL_UNSIGNED_INT;
+};
+template <>
+struct Std140<glm::vec2>
+{
+    static constexpr size_t align = 8, size = 8;
+    static constexpr GLenum type = GL_FLOAT_VEC2;
+};
+// a vec3 is aligned like a vec4 but only 12 bytes, a scalar can follow it
+template <>
+struct Std140<glm::vec3>
+{
+    static constexpr size_t align = 16, size = 12;
+    static constexpr GLenum type = GL_FLOAT_VEC3;
+};
+template <>
+struct Std140<glm::vec4>
+{
+    static constexpr size_t align = 16, size = 16;
+    static constexpr GLenum type = GL_FLOAT_VEC4;
+};
+template <>
+struct Std140<glm::ivec4>
+{
+    static constexpr size_t align = 16, size = 16;
+    static constexpr GLenum type = GL_INT_VEC4;
+};
+template <>
+struct Std140<glm::mat4>
+{
+    static constexpr size_t align = 16, size = 64;
+    static constexpr GLenum type = GL_FLOAT_MAT4;
+};
+
+struct UniformField
+{
+    const char *name;
+    size_t offset;
+    size_t align;
+    size_t size;
+    GLenum type;
+};
+
+#define UNIFORM_FIELD(Struct, member)                                                      \
+    UniformField                                                                           \
+    {                                                                                      \
+        #member, offsetof(Struct, member), Std140<decltype(Struct::member)>::align,        \
+            Std140<decltype(Struct::member)>::size, Std140<decltype(Struct::member)>::type \
+    }
+
+template <typename T>
+struct UniformBlockTraits;
+
+namespace UniformLayout
+{
+    constexpr size_t alignUp(size_t value, size_t align) { return (value + align - 1) / align * align; }
+
+    // true when every member sits where std140 puts it and the struct covers the block
+    template <typename T>
+    constexpr bool matchesStd140()
+    {
+        size_t end = 0;
+        for (const UniformField &field : UniformBlockTraits<T>::fields)
+        {
+            if (field.offset != alignUp(end, field.align))
+                return false;
+            end = field.offset + field.size;
+        }
+        return sizeof(T) >= alignUp(end, 16) && sizeof(T) % 16 == 0;
+    }
+}
+
+// Checks the program's block against T, binds it to bindingPoint and returns true
+// when they agree. On a mismatch the differences are printed and false returned.
+template <typename T>
+bool validateUniformBlock(GLuint program, GLuint bindingPoint)
+{
+    static_assert(UniformLayout::matchesStd140<T>(), "struct layout doesn't follow std140, pad it or align the struct to 16 bytes");
+    using Traits = UniformBlockTraits<T>;
+
+    GLuint block = glGetUniformBlockIndex(program, Traits::name);
+    if (block == GL_INVALID_INDEX)
+    {
+        std::cout << "ERROR::UNIFORMBLOCK::NOT_FOUND " << Traits::name << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    GLint dataSize = 0;
+    glGetActiveUniformBlockiv(program, block, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    if ((size_t)dataSize > sizeof(T))
+    {
+        std::cout << "ERROR::UNIFORMBLOCK::SIZE_MISMATCH " << Traits::name << " shader " << dataSize << " bytes, struct " << sizeof(T) << std::endl;
+        ok = false;
+    }
+
+    GLint activeCount = 0;
+    glGetActiveUniformBlockiv(program, block, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &activeCount);
+
+    for (const UniformField &field : Traits::fields)
+    {
+        // members of a block with an instance name are reported as Block.member
+        std::string qualified = std::string(Traits::name) + "." + field.name;
+        const char *names[2] = {field.name, qualified.c_str()};
+        GLuint indices[2];
+        glGetUniformIndices(program, 2, names, indices);
+        GLuint index = indices[0] != GL_INVALID_INDEX ? indices[0] : indices[1];
+        if (index == GL_INVALID_INDEX)
+        {
+            // the compiler may drop members the shader never reads, that's harmless
+            continue;
+        }
+
+        GLint offset = -1, type = 0, owner = -1;
+        glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_OFFSET, &offset);
+        glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_TYPE, &type);
+        glGetActiveUniformsiv(program, 1, &index, GL_UNIFORM_BLOCK_INDEX, &owner);
+        if ((GLuint)owner != block || (size_t)offset != field.offset || (GLenum)type != field.type)
+        {
+            std::cout << "ERROR::UNIFORMBLOCK::FIELD_MISMATCH " << Traits::name << "." << field.name
+                      << " shader offset " << offset << ", struct offset " << field.offset << std::endl;
+            ok = false;
+        }
+    }
+    if ((size_t)activeCount > std::size(Traits::fields))
+    {
+        std::cout << "ERROR::UNIFORMBLOCK::UNDECLARED_FIELDS " << Traits::name << std::endl;
+        ok = false;
+    }
+
+    if (ok)
+        glUniformBlockBinding(program, block, bindingPoint);
+    return ok;
+}
+
+// One uniform buffer holding every block written this frame.
+//
+// push() copies a block into a CPU staging area at the next offset that satisfies
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, upload() sends the whole frame with a single
+// orphan + glBufferSubData, and after that each draw only needs bind(), one
+// glBindBufferRange, instead of a glUniform* call per member.
+class UniformArena
+{
+public:
+    explicit UniformArena(size_t capacity = 64 * 1024) : capacity(capacity)
+    {
+        GLint align = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+        alignment = align > 0 ? (size_t)align : 256;
+        staging.reserve(capacity);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        glBufferData(GL_UNIFORM_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    ~UniformArena() { glDeleteBuffers(1, &buffer); }
+
+    UniformArena(const UniformArena &) = delete;
+    UniformArena &operator=(const UniformArena &) = delete;
+
+    // Returns the block's offset in the buffer, valid after the next upload()
+    template <typename T>
+    GLintptr push(const T &block)
+    {
+        static_assert(UniformLayout::matchesStd140<T>(), "struct layout doesn't follow std140, pad it or align the struct to 16 bytes");
+        size_t offset = UniformLayout::alignUp(staging.size(), alignment);
+        staging.resize(offset + sizeof(T));
+        memcpy(staging.data() + offset, &block, sizeof(T));
+        return (GLintptr)offset;
+    }
+
+    // Sends everything pushed since reset(), growing the buffer if needed
+    void upload()
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        if (staging.size() > capacity)
+            capacity = staging.size() * 2;
+        // orphan so the driver doesn't wait on draws still reading last frame's data
+        glBufferData(GL_UNIFORM_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, staging.size(), staging.data());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    template <typename T>
+    void bind(GLuint bindingPoint, GLintptr offset) const
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, buffer, offset, sizeof(T));
+    }
+
+    void reset() { staging.clear(); }
+
+    GLuint id() const { return buffer; }
+    size_t used() const { return staging.size(); }
+
+private:
+    GLuint buffer = 0;
+    size_t capacity;
+    size_t alignment = 256;
+    std::vector<unsigned char> staging;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef __WORLDPOSITIONS_H__
+#define __WORLDPOSITIONS_H__
+
+#include "MatrixKernels.h"
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Object positions in double precision, for worlds too large for float: at a
+// million units from the origin a float only resolves steps of 6 cm. The GPU never
+// sees them. Each frame toCameraRelative turns them into float offsets from the
+// camera in one batched pass, and the scene is drawn with the camera at the origin
+// (Camera::GetRelativeViewMatrix), so precision is best right where the camera is.
+class WorldPositions
+{
+public:
+    explicit WorldPositions(MatrixKernels::Isa isa = MatrixKernels::best()) : kernels(isa) {}
+
+    size_t add(const glm::dvec3 &position)
+    {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        z.push_back(position.z);
+        return x.size() - 1;
+    }
+
+    void set(size_t i, const glm::dvec3 &position)
+    {
+        x[i] = position.x;
+        y[i] = position.y;
+        z[i] = position.z;
+    }
+
+    glm::dvec3 get(size_t i) const { return glm::dvec3(x[i], y[i], z[i]); }
+
+    void translate(size_t i, const glm::dvec3 &offset)
+    {
+        x[i] += offset.x;
+        y[i] += offset.y;
+        z[i] += offset.z;
+    }
+
+    size_t size() const { return x.size(); }
+
+    void reserve(size_t count)
+    {
+        x.reserve(count);
+        y.reserve(count);
+        z.reserve(count);
+    }
+
+    // out[i] = position i - camera, for size() positions
+    void toCameraRelative(const glm::dvec3 &camera, glm::vec3 *out) const { kernels.relative(camera, x.data(), y.data(), z.data(), out, x.size()); }
+
+    // Writes the same offsets into the translation column of size() model matrices
+    // whose rotation and scale are already in place
+    void toCameraRelative(const glm::dvec3 &camera, glm::mat4 *models) const { kernels.relative(camera, x.data(), y.data(), z.data(), models, x.size()); }
+
+private:
+    std::vector<double> x, y, z;
+    MatrixKernels kernels;
+};
+
+#endif
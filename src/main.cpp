@@ -6,14 +6,37 @@
 #include "glm/gtc/type_ptr.hpp"
 
 #include "Shader.h"
+#include "ShaderCache.h"
+#include "ShaderHotReload.h"
+#include "ShaderSource.h"
 #include "Camera.h"
+#include "LessonScene.h"
+#include "RenderQueue.h"
+#include "TextureArray.h"
+#include "UniformBlock.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "InputSystem.h"
+#include "InputRecording.h"
+#include "FrameTimings.h"
+#include "FixedTimestep.h"
+#include "FrameLimiter.h"
+#include "OcclusionCuller.h"
+#include "WorldPositions.h"
 #include "stb_image/stb_image.h"
 
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
 #include <iostream>
+#include <optional>
 #include <string>
+#include <thread>
 
-float deltaTime, fps;
-Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+double deltaTime, fps;
+Camera camera(LessonScene::CameraStart);
 float lastX = 400, lastY = 300;
 
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
@@ -25,6 +48,73 @@ float yaw = -90.0f; // yaw is initialized to -90.0 degrees since a yaw of 0.0 re
 float pitch = 0.0f;
 float fov = 45.0f;
 
+// Per frame uniforms, the Frame block in instancedshader.vs
+struct alignas(16) FrameUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+};
+
+template <>
+struct UniformBlockTraits<FrameUniforms>
+{
+	static constexpr const char *name = "Frame";
+	static constexpr UniformField fields[] = {UNIFORM_FIELD(FrameUniforms, view), UNIFORM_FIELD(FrameUniforms, projection)};
+};
+
+const GLuint FrameBinding = 0;
+
+// Simulation state, advanced in fixed steps on the update thread
+struct SimState
+{
+	Camera camera;
+	float cubeAngles[10];
+};
+
+// Blend between two simulation steps for display
+SimState interpolate(const SimState &a, const SimState &b, float t)
+{
+	SimState s;
+	s.camera = Camera(glm::mix(a.camera.Position, b.camera.Position, (double)t), b.camera.WorldUp,
+					  glm::mix(a.camera.Yaw, b.camera.Yaw, t), glm::mix(a.camera.Pitch, b.camera.Pitch, t));
+	s.camera.Zoom = glm::mix(a.camera.Zoom, b.camera.Zoom, t);
+	for (int i = 0; i < 10; i++)
+		s.cubeAngles[i] = glm::mix(a.cubeAngles[i], b.cubeAngles[i], t);
+	return s;
+}
+
+// Everything the render thread needs for one frame, written by the update thread
+struct FrameSnapshot
+{
+	// the last two simulation steps, blended by clock.alpha(): the leftover accumulator over
+	// stepSize, as of this snapshot. After a stall the clock skips the dropped backlog in
+	// simulation time rather than replaying it.
+	SimState previous, current;
+	FixedTimestep clock;
+	// mouse movement current's camera includes, for late latching
+	InputSystem::LookState look;
+	// replay only: the log has been played to the end
+	bool replayDone = false;
+};
+
+// Timestamped events from the GLFW callbacks, replayed on the update thread
+InputSystem input;
+// set with --record, every event is also written to the log
+InputRecorder *inputRecorder = nullptr;
+
+// Simulation rate and the most steps one frame may catch up on before time is dropped
+const double SimStep = 1.0 / 120.0;
+const int MaxCatchUpSteps = 8;
+// Replays also render on a fixed clock, so every run sees the same camera path
+const double ReplayStep = 1.0 / 60.0;
+
+void submitInput(const InputEvent &event)
+{
+	if (inputRecorder)
+		inputRecorder->record(event);
+	input.push(event);
+}
+
 // Resize OpenGL viewport when window size changed
 void framebuffer_size_callback(GLFWwindow *window, int width, int height)
 {
@@ -44,33 +134,76 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 	lastX = xpos;
 	lastY = ypos;
 
-	camera.ProcessMouseMovement(xoffset, yoffset);
+	submitInput({InputEvent::MouseMove, FORWARD, xoffset, yoffset, glfwGetTime()});
 }
 
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset)
 {
-	camera.ProcessMouseScroll(static_cast<float>(yoffset));
+	submitInput({InputEvent::Scroll, FORWARD, 0.0f, static_cast<float>(yoffset), glfwGetTime()});
 }
 
-void processInput(GLFWwindow *window)
+// Movement keys become timestamped events, the camera itself moves on the update thread
+void key_callback(GLFWwindow *, int key, int, int action, int)
 {
-	const float cameraSpeed = 2.5f * deltaTime; // adjust
+	Camera_Movement movement;
+	switch (key)
+	{
+	case GLFW_KEY_W:
+		movement = FORWARD;
+		break;
+	case GLFW_KEY_S:
+		movement = BACKWARD;
+		break;
+	case GLFW_KEY_A:
+		movement = LEFT;
+		break;
+	case GLFW_KEY_D:
+		movement = RIGHT;
+		break;
+	default:
+		return;
+	}
+	if (action == GLFW_PRESS)
+		submitInput({InputEvent::KeyDown, movement, 0.0f, 0.0f, glfwGetTime()});
+	else if (action == GLFW_RELEASE)
+		submitInput({InputEvent::KeyUp, movement, 0.0f, 0.0f, glfwGetTime()});
+}
 
+void processInput(GLFWwindow *window)
+{
 	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, true);
-
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-		camera.ProcessKeyboard(FORWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-		camera.ProcessKeyboard(BACKWARD, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-		camera.ProcessKeyboard(LEFT, deltaTime);
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-		camera.ProcessKeyboard(RIGHT, deltaTime);
 }
 
-int main()
+// usage: LearnOpenGL [--fps <rate>] [--record <log>] [--replay <log> [--report <frames.csv>]]
+int main(int argc, char **argv)
 {
+	const char *recordPath = NULL;
+	const char *replayPath = NULL;
+	const char *reportPath = NULL;
+	// 0 renders as fast as possible
+	double targetFps = 0.0;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--record") == 0)
+			recordPath = argv[i + 1];
+		else if (strcmp(argv[i], "--replay") == 0)
+			replayPath = argv[i + 1];
+		else if (strcmp(argv[i], "--report") == 0)
+			reportPath = argv[i + 1];
+		else if (strcmp(argv[i], "--fps") == 0)
+			targetFps = atof(argv[i + 1]);
+	}
+
+	// Replays drive the camera from the log instead of the mouse and keyboard
+	InputReplay replay;
+	bool replaying = replayPath != NULL;
+	if (replaying)
+	{
+		if (!replay.load(replayPath))
+			return -1;
+		camera = replay.camera();
+	}
 
 	// Init glfw
 	glfwInit();
@@ -79,6 +212,9 @@ int main()
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	// Replays run headless
+	if (replaying)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
 	// Const Window Title for Showing FPS in window
 	const char *titleStr = "LearnOpenGL - FPS: ";
@@ -97,12 +233,17 @@ int main()
 
 	// Make window the current opengl context
 	glfwMakeContextCurrent(window);
-	// Capture the Cursor
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-	// Mouse movement callback
-	glfwSetCursorPosCallback(window, mouse_callback);
-	// Scroll callback
-	glfwSetScrollCallback(window, scroll_callback);
+	if (!replaying)
+	{
+		// Capture the Cursor
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		// Mouse movement callback
+		glfwSetCursorPosCallback(window, mouse_callback);
+		// Scroll callback
+		glfwSetScrollCallback(window, scroll_callback);
+		// Key callback
+		glfwSetKeyCallback(window, key_callback);
+	}
 
 	// Initialise GLAD
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -119,50 +260,56 @@ int main()
 
 	glEnable(GL_DEPTH_TEST);
 
-	// Triangle Vertex Data
-
-	float vertices[] = {
-		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-		0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-
-		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-		0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
-		0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
-		0.5f, 0.5f, 0.5f, 1.0f, 1.0f,
-		-0.5f, 0.5f, 0.5f, 0.0f, 1.0f,
-		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-
-		-0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-		-0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-		-0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-
-		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-		0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-		0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-		0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-
-		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-		0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
-		0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
-		0.5f, -0.5f, 0.5f, 1.0f, 0.0f,
-		-0.5f, -0.5f, 0.5f, 0.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-
-		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f,
-		0.5f, 0.5f, -0.5f, 1.0f, 1.0f,
-		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-		0.5f, 0.5f, 0.5f, 1.0f, 0.0f,
-		-0.5f, 0.5f, 0.5f, 0.0f, 0.0f,
-		-0.5f, 0.5f, -0.5f, 0.0f, 1.0f};
+	// Flip images vertically when loaded, to keep the textures the expected orientation
+	stbi_set_flip_vertically_on_load(true);
+
+	// Pack every material into the layers of one array texture, so all cubes can
+	// be drawn with a single texture binding. A job decodes the images with parallelFor
+	// across the job system's workers, then packs them and builds the mip chains, while
+	// this thread sets up the GL objects; only the upload happens on the GL thread.
+	const char *materialPaths[] = {"assets\\container.jpg", "assets\\wall.jpg", "assets\\awesomeface.png"};
+	TextureRegion materials[3];
+	TextureArrayBuilder arrayBuilder(512, 512);
+	// Frame and loading work goes through the job system, this thread is worker 0
+	JobSystem jobs;
+
+	// Decode the images in parallel on the workers, then pack them and build the mips
+	JobCounter materialsLoaded;
+	jobs.run([&]()
+			 {
+		struct Decoded
+		{
+			unsigned char *pixels;
+			int width, height, channels;
+		};
+		Decoded decoded[3];
+		jobs.parallelFor(0, 3, 1, [&](size_t first, size_t last)
+						 {
+			for (size_t m = first; m < last; m++)
+			{
+				Decoded &d = decoded[m];
+				d.pixels = stbi_load(materialPaths[m], &d.width, &d.height, &d.channels, 0);
+			} });
+		for (int m = 0; m < 3; m++)
+		{
+			const Decoded &d = decoded[m];
+			if (d.pixels)
+			{
+				// the face is blended over the crate, not alpha tested, so plain mips will do
+				materials[m] = arrayBuilder.add(d.pixels, d.width, d.height, d.channels, MipOptions());
+			}
+			else
+			{
+				std::cout << "Failed to load texture image" << std::endl;
+				std::cout << stbi_failure_reason() << std::endl;
+				materials[m] = {0.0f, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)};
+			}
+			stbi_image_free(d.pixels);
+		}
+		arrayBuilder.generateMips(); },
+			 &materialsLoaded);
+
+	// Triangle Vertex Data: the cube from LessonScene.h, shared with SoftRender
 
 	// Indices for drawing a rect from two tris
 	unsigned int indices[] = {
@@ -171,21 +318,21 @@ int main()
 		1, 2, 3	 // second Triangle
 	};
 
-	glm::vec3 cubePositions[] = {
-		glm::vec3(0.0f, 0.0f, 0.0f),
-		glm::vec3(2.0f, 5.0f, -15.0f),
-		glm::vec3(-1.5f, -2.2f, -2.5f),
-		glm::vec3(-3.8f, -2.0f, -12.3f),
-		glm::vec3(2.4f, -0.4f, -3.5f),
-		glm::vec3(-1.7f, 3.0f, -7.5f),
-		glm::vec3(1.3f, -2.0f, -2.5f),
-		glm::vec3(1.5f, 2.0f, -2.5f),
-		glm::vec3(1.5f, 0.2f, -1.5f),
-		glm::vec3(-1.3f, 1.0f, -1.5f)};
+	// The cubes' world positions in double; each frame draws them relative to the camera
+	WorldPositions cubeWorld;
+	for (const glm::vec3 &position : LessonScene::CubePositions)
+		cubeWorld.add(glm::dvec3(position));
 
 	// Declare Shader using custom shader class
-	// Shader myShader("E:\\dev\\LearnOpenGL\\src\\shaders\\coordinateshader.vs", "E:\\dev\\LearnOpenGL\\src\\shaders\\coordinateshader.fs");
-	Shader myShader("shaders\\coordinateshader.vs", "shaders\\coordinateshader.fs");
+	// Linked programs are cached on disk, so later launches skip compiling and linking.
+	// Sources come from shaders.pack (tools/ShaderPacker) when it's there, one mapping
+	// for every program instead of an open per file.
+	ShaderCache shaderCache("shadercache");
+	std::optional<ShaderArchive> shaderPack;
+	if (std::filesystem::exists("shaders.pack"))
+		shaderPack.emplace("shaders.pack");
+	Shader myShader(shaderPack && shaderPack->valid() ? shaderCache.load(*shaderPack, "instancedshader.vs", "instancedshader.fs")
+													  : shaderCache.load("shaders\\instancedshader.vs", "shaders\\instancedshader.fs"));
 	// Create a Vertex Buffer Object
 	// Special OpenGL object to hold vertex data
 	unsigned int VBO;
@@ -218,7 +365,7 @@ int main()
 	// GL_STREAM_DRAW: the data is set only once and used by the GPU at most a few times.
 	// GL_STATIC_DRAW: the data is set only once and used many times.
 	// GL_DYNAMIC_DRAW: the data is changed a lot and used many times.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(LessonScene::CubeVertices), LessonScene::CubeVertices, GL_STATIC_DRAW);
 
 	// Configure EBO
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
@@ -243,82 +390,131 @@ int main()
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 
-	// Flip images vertically when loaded, to keep the textures the expected orientation
-	stbi_set_flip_vertically_on_load(true);
-
-	// Create a openGl texture
-	unsigned int boxTexture;
-	glGenTextures(1, &boxTexture);
-
-	// Bind boxTexture to the GL_TEXTURE_2D
-	glBindTexture(GL_TEXTURE_2D, boxTexture);
+	jobs.wait(materialsLoaded);
+	unsigned int materialArray = arrayBuilder.build();
 
-	// Configure some wrapping and filtering settings
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	// Load Texture Image
-	int width, height, nrChannels;
-	unsigned char *image1 = stbi_load("assets\\container.jpg", &width, &height, &nrChannels, 0);
-	// unsigned char *image1 = stbi_load("E:\\dev\\LearnOpenGL\\assets\\container.jpg", &width, &height, &nrChannels, 0);
-	if (image1)
-	{
-		// Make texture using loaded image asset
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image1);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-	else
+	// Per instance data: each cube's transform, and which materials it mixes
+	TexturedInstance cubeInstances[10];
+	for (unsigned int i = 0; i < 10; i++)
 	{
-		std::cout << "Failed to load texture image" << std::endl;
-		std::cout << stbi_failure_reason() << std::endl;
-	}
-	stbi_image_free(image1);
-
-	unsigned int faceTexture;
-	glGenTextures(1, &faceTexture);
-
-	glBindTexture(GL_TEXTURE_2D, faceTexture);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, LessonScene::CubePositions[i]);
+		model = glm::rotate(model, glm::radians(LessonScene::cubeAngle(i)), LessonScene::RotationAxis);
 
-	// Load a second texture
-	// unsigned char *image2 = stbi_load("E:\\dev\\LearnOpenGL\\assets\\awesomeface.png", &width, &height, &nrChannels, 0);
-	unsigned char *image2 = stbi_load("assets\\awesomeface.png", &width, &height, &nrChannels, 0);
-	if (image2)
-	{
-		// Specify RGBA, as PNG has an alpha channel
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image2);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		const TextureRegion &base = materials[i % 2];
+		const TextureRegion &face = materials[2];
+		cubeInstances[i] = {model, base.rect, face.rect, glm::vec2(base.layer, face.layer)};
 	}
-	else
-	{
-		std::cout << "Failed to load texture image" << std::endl;
-		std::cout << stbi_failure_reason() << std::endl;
-	}
-	stbi_image_free(image2);
+
+	unsigned int instanceVBO;
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cubeInstances), cubeInstances, GL_DYNAMIC_DRAW);
+	setupTexturedInstanceAttributes(2);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
 
 	std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
 	std::cout << "Maximum Vertex Attributes: " << GL_MAX_VERTEX_ATTRIBS << std::endl;
 
 	myShader.use();
 
-	myShader.setInt("texture1", 0);
-	myShader.setInt("texture2", 1);
-
-	float currentFrame = 0.0f;
-	float lastFrame = 0.0f;
-
-	// Disables VSYNC
+	myShader.setInt("textures", 0);
+	// a program whose Frame block doesn't match FrameUniforms would draw with garbage matrices
+	if (!validateUniformBlock<FrameUniforms>(myShader.ID, FrameBinding))
+	{
+		std::cout << "ERROR::UNIFORMBLOCK::PROGRAM_REJECTED instancedshader" << std::endl;
+		glfwTerminate();
+		return -1;
+	}
+	UniformArena uniforms;
+
+	// Draw list for the scene, every cube shares one shader, texture set and VAO
+	RenderQueue renderQueue;
+	unsigned cubeProgram = renderQueue.registerProgram(myShader.ID);
+	TextureSet cubeTextures;
+	cubeTextures.units[0] = materialArray;
+	cubeTextures.target = GL_TEXTURE_2D_ARRAY;
+	unsigned cubeTextureSet = renderQueue.registerTextureSet(cubeTextures);
+	unsigned cubeVao = renderQueue.registerVertexArray(VAO);
+
+	// Saving either shader file rebuilds it in the background and swaps it in between frames
+	ProgramBatch::enableParallelCompile();
+	// Reloads compile on the watcher thread in this hidden context, so a save never stalls a frame
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow *reloadContext = glfwCreateWindow(1, 1, "", NULL, window);
+	ShaderHotReload shaderReload(reloadContext ? ShaderHotReload::ContextCallback([reloadContext](bool current)
+																				 { glfwMakeContextCurrent(current ? reloadContext : NULL); })
+											   : ShaderHotReload::ContextCallback());
+	shaderReload.watch(myShader, "shaders\\instancedshader.vs", "shaders\\instancedshader.fs", [&](Shader &shader)
+					   {
+		if (!validateUniformBlock<FrameUniforms>(shader.ID, FrameBinding))
+			return false;
+		shader.use();
+		shader.setInt("textures", 0);
+		renderQueue.replaceProgram(cubeProgram, shader.ID);
+		return true; });
+
+	// Events are stamped relative to this point, the camera here is the log's starting camera
+	if (recordPath)
+		inputRecorder = new InputRecorder(recordPath, camera, glfwGetTime());
+
+	// The update thread simulates the next frame while this thread renders the current one.
+	// It may run at most one snapshot ahead, which bounds input latency to two frames.
+	FramePipeline<FrameSnapshot> pipeline(FramePipeline<FrameSnapshot>::Mode::Queue, 1);
+	std::thread updateThread([&]()
+							 {
+		uint64_t replayFrame = 0;
+		FixedTimestep clock(SimStep, MaxCatchUpSteps);
+		SimState current;
+		current.camera = camera;
+		for (unsigned int i = 0; i < 10; i++)
+			current.cubeAngles[i] = LessonScene::cubeAngle(i);
+		SimState previous = current;
+		InputSystem::LookState look;
+		while (FrameSnapshot *snapshot = pipeline.beginWrite())
+		{
+			// replays advance a fixed amount per frame, live runs follow the wall clock
+			double now = replaying ? replayFrame++ * ReplayStep : glfwGetTime();
+			clock.advance(now);
+			while (clock.step())
+			{
+				previous = current;
+				// the log's events are pushed here as simulation time reaches them
+				if (replaying)
+					replay.feed(input, clock.time());
+				look = input.integrate(camera, clock.time());
+				current.camera = camera;
+			}
+
+			snapshot->previous = previous;
+			snapshot->current = current;
+			snapshot->clock = clock;
+			snapshot->look = look;
+			snapshot->replayDone = replaying && replay.finished() && clock.time() >= replay.duration();
+			pipeline.publish();
+		} });
+
+	FrameTimings timings;
+	auto lastFrameStart = std::chrono::steady_clock::now();
+
+	double currentFrame = 0.0;
+	double lastFrame = 0.0;
+
+	// Disables VSYNC, with --fps the limiter paces frames instead of spinning a core
 	glfwSwapInterval(0);
+	FrameLimiter limiter(targetFps);
+	OcclusionCuller occlusion;
+	std::clock_t cpuClockStart = std::clock();
+	auto wallClockStart = std::chrono::steady_clock::now();
 
 	// Render Loop
 	while (!glfwWindowShouldClose(window))
 	{
+		// starts the frame as late as it can and still finish on time
+		limiter.beginFrame();
+
 		currentFrame = glfwGetTime();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
@@ -333,60 +529,127 @@ int main()
 		//  Process Key events
 		processInput(window);
 
-		// Render Commands go Here:
-
-		// Color to clear the screen with
-		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-		// Clear the Color buffer and depth buffer
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Bind both textures to different texture units
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, boxTexture);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, faceTexture);
-
-		myShader.use();
-		// Perspective Projection Matrix
-		glm::mat4 projection;
-		projection = glm::perspective(glm::radians(camera.Zoom), 800.0f / 600.0f, 0.1f, 100.0f);
-
-		// camera/view transformation
-		glm::mat4 view = camera.GetViewMatrix();
-		myShader.setMat4("view", view);
+		// Swap in any shader that finished rebuilding since the last frame
+		shaderReload.update();
 
-		// Create transformations
-		// Model Matrix
-		glm::mat4 model = glm::mat4(1.0f);
-		// Stationary Model
-		// model = glm::rotate(model, glm::radians(-55.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-		// Rotating over time
-		model = glm::rotate(model, (float)glfwGetTime() * glm::radians(50.0f), glm::vec3(0.5f, 1.0f, 0.0f));
-
-		// Send Transform Matrices to shader
-		myShader.setMat4("model", model);
-
-		myShader.setMat4("projection", projection);
+		// Render Commands go Here:
 
-		glBindVertexArray(VAO); // seeing as we only have a single VAO there's no need to bind it every time, but we'll do so to keep things a bit more organized
-		for (unsigned int i = 0; i < 10; i++)
+		// Newest snapshot from the update thread, it stays untouched until the next acquire.
+		// None means the update thread fell behind: nothing is drawn or swapped, so the
+		// last frame stays on screen instead of a cleared one.
+		const FrameSnapshot *snapshot = pipeline.acquire();
+		if (snapshot)
 		{
-			glm::mat4 model = glm::mat4(1.0f);
-			model = glm::translate(model, cubePositions[i]);
-			float angle = 20.0f * i;
-			model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-			myShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			auto cpuStart = std::chrono::steady_clock::now();
+
+			// Color to clear the screen with
+			glClearColor(LessonScene::ClearColor.x, LessonScene::ClearColor.y, LessonScene::ClearColor.z, LessonScene::ClearColor.w);
+			// Clear the Color buffer and depth buffer
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+			// Blend the last two simulation steps for the moment the snapshot was made, so
+			// motion stays smooth whatever the render rate
+			SimState shown = interpolate(snapshot->previous, snapshot->current, (float)snapshot->clock.alpha());
+
+			// Rotations here, translations as offsets from the camera in one batched pass
+			TexturedInstance instances[10];
+			glm::mat4 models[10];
+			for (unsigned int i = 0; i < 10; i++)
+				models[i] = glm::rotate(glm::mat4(1.0f), glm::radians(shown.cubeAngles[i]), LessonScene::RotationAxis);
+			cubeWorld.toCameraRelative(shown.camera.Position, models);
+			for (unsigned int i = 0; i < 10; i++)
+			{
+				instances[i] = cubeInstances[i];
+				instances[i].model = models[i];
+			}
+
+			// Late latch: pick up mouse movement that arrived after the snapshot was made
+			// and turn the camera by it right before the view matrix goes to the GPU
+			// (not in replays, where the update thread feeds events ahead of the frame being drawn)
+			if (!replaying)
+			{
+				glfwPollEvents();
+				// snapshot->look is what current's orientation includes, so latch onto that
+				// rather than the blend, which trails it by (1 - alpha) of the last step's turn
+				const Camera &latest = snapshot->current.camera;
+				float zoom = shown.camera.Zoom;
+				shown.camera = Camera(shown.camera.Position, latest.WorldUp, latest.Yaw, latest.Pitch);
+				shown.camera.Zoom = zoom;
+				input.lateLatch(shown.camera, snapshot->look);
+			}
+			FrameUniforms frame;
+			// Perspective Projection Matrix
+			frame.projection = glm::perspective(glm::radians(shown.camera.Zoom), 800.0f / 600.0f, 0.1f, 100.0f);
+			// camera/view transformation, with the camera at the origin like the cube offsets
+			frame.view = shown.camera.GetRelativeViewMatrix();
+
+			// Occlusion cull: the cubes go into a small CPU depth buffer as occluders, and
+			// only those not completely hidden behind the others reach the instance buffer
+			occlusion.begin(frame.projection * frame.view);
+			for (unsigned int i = 0; i < 10; i++)
+				occlusion.addOccluderBox(instances[i].model, glm::vec3(-0.5f), glm::vec3(0.5f));
+			occlusion.finish();
+			unsigned int visibleCubes = 0;
+			for (unsigned int i = 0; i < 10; i++)
+				if (occlusion.isVisible(instances[i].model, glm::vec3(-0.5f), glm::vec3(0.5f)))
+					instances[visibleCubes++] = instances[i];
+			glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, visibleCubes * sizeof(TexturedInstance), instances);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+			// one upload for the frame's uniforms, one range bind instead of a glUniform call per matrix
+			uniforms.reset();
+			GLintptr frameOffset = uniforms.push(frame);
+			uniforms.upload();
+			uniforms.bind<FrameUniforms>(FrameBinding, frameOffset);
+
+			// All cubes go out as one instanced draw through the render queue
+			renderQueue.reset();
+			if (visibleCubes > 0)
+				renderQueue.submit({SortKey::make(0, cubeProgram, cubeTextureSet, cubeVao, 0), 0, LessonScene::CubeVertexCount, glm::mat4(1.0f), (GLsizei)visibleCubes});
+			renderQueue.sort();
+			renderQueue.execute();
+
+			if (replaying)
+			{
+				auto frameStart = std::chrono::steady_clock::now();
+				timings.add(std::chrono::duration<double, std::milli>(frameStart - lastFrameStart).count(),
+							std::chrono::duration<double, std::milli>(frameStart - cpuStart).count());
+				lastFrameStart = frameStart;
+				if (snapshot->replayDone)
+					glfwSetWindowShouldClose(window, true);
+			}
 		}
 
 		// glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
 
 		// Swap Color Buffers
-		glfwSwapBuffers(window);
+		if (snapshot)
+			glfwSwapBuffers(window);
+		limiter.endFrame();
 		// Get Any Events during this iteration
 		glfwPollEvents();
 	}
 
+	pipeline.stop();
+	updateThread.join();
+
+	delete inputRecorder;
+	inputRecorder = NULL;
+	if (replaying)
+	{
+		timings.print(replayPath);
+		// both threads, as a share of one core
+		double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallClockStart).count();
+		std::cout << "  cpu use: " << 100.0 * (std::clock() - cpuClockStart) / CLOCKS_PER_SEC / wall << "%";
+		if (limiter.target() > 0.0)
+			std::cout << ", limited to " << limiter.target() << " fps (" << limiter.rate() << " at the end, " << limiter.overruns() << " overruns)";
+		std::cout << std::endl;
+		if (reportPath)
+			timings.writeCsv(reportPath);
+	}
+
+	shaderReload.stop();
 	glfwTerminate();
 	return 0;
 }
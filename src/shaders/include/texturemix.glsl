@@ -0,0 +1,7 @@
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+
+vec4 mixTextures(vec2 uv)
+{
+    return mix(texture(texture1, uv), texture(texture2, uv), 0.2);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 TexCoord1;
+in vec3 TexCoord2;
+
+uniform sampler2DArray textures;
+
+void main()
+{
+    FragColor = mix(texture(textures, TexCoord1), texture(textures, TexCoord2), 0.2);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoord;
+// per instance attributes, see TexturedInstance
+layout (location = 2) in mat4 aModel;
+layout (location = 6) in vec4 aRect1;
+layout (location = 7) in vec4 aRect2;
+layout (location = 8) in vec2 aLayers;
+
+out vec3 TexCoord1;
+out vec3 TexCoord2;
+
+// per frame block, laid out like FrameUniforms in main.cpp
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    gl_Position = projection * view * aModel * vec4(aPos, 1.0);
+    // map the mesh uv into each texture's region of its array layer
+    TexCoord1 = vec3(aRect1.xy + aTexCoord * aRect1.zw, aLayers.x);
+    TexCoord2 = vec3(aRect2.xy + aTexCoord * aRect2.zw, aLayers.y);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+#pragma permutation VERTEX_COLOR
+
+out vec4 FragColor;
+
+#ifdef VERTEX_COLOR
+in vec3 ourColor;
+#endif
+in vec2 TexCoord;
+
+#include "include/texturemix.glsl"
+
+void main()
+{
+    FragColor = mixTextures(TexCoord);
+}
@@ -0,0 +1,42 @@
+#version 330 core
+// The lesson shaders in one source: VERTEX_COLOR is the old basicshader, adding
+// TRANSFORM gives transformshader and MVP alone coordinateshader
+#pragma permutation VERTEX_COLOR
+#pragma permutation TRANSFORM
+#pragma permutation MVP
+
+layout (location = 0) in vec3 aPos;
+#ifdef VERTEX_COLOR
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec2 aTexCoord;
+out vec3 ourColor;
+#else
+layout (location = 1) in vec2 aTexCoord;
+#endif
+
+out vec2 TexCoord;
+
+#ifdef TRANSFORM
+uniform mat4 transform;
+#endif
+#ifdef MVP
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+#endif
+
+void main()
+{
+    vec4 position = vec4(aPos, 1.0);
+#ifdef TRANSFORM
+    position = transform * position;
+#endif
+#ifdef MVP
+    position = projection * view * model * position;
+#endif
+    gl_Position = position;
+#ifdef VERTEX_COLOR
+    ourColor = aColor;
+#endif
+    TexCoord = aTexCoord;
+}
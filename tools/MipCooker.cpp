@@ -0,0 +1,53 @@
+// Offline mip cooker: decodes an image and writes its full mip chain to a .mips
+// file (see MipChain::save) so the runtime can upload levels without filtering.
+//
+// usage: MipCooker <input image> <output.mips> [--linear] [--kaiser] [--cutout <alpha ref>]
+
+#include "MipGenerator.h"
+#include "stb_image/stb_image.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "usage: MipCooker <input image> <output.mips> [--linear] [--kaiser] [--cutout <alpha ref>]" << std::endl;
+		return 1;
+	}
+
+	MipOptions options;
+	for (int i = 3; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--linear") == 0)
+			options.srgb = false;
+		else if (strcmp(argv[i], "--kaiser") == 0)
+			options.filter = MipFilter::Kaiser;
+		else if (strcmp(argv[i], "--cutout") == 0 && i + 1 < argc)
+			options.alphaCutoff = (float)atof(argv[++i]);
+	}
+
+	// match the runtime loader's orientation
+	stbi_set_flip_vertically_on_load(true);
+	int width, height, nrChannels;
+	unsigned char *image = stbi_load(argv[1], &width, &height, &nrChannels, 4);
+	if (!image)
+	{
+		std::cout << "Failed to load texture image" << std::endl;
+		std::cout << stbi_failure_reason() << std::endl;
+		return 1;
+	}
+
+	MipChain chain = MipGenerator::generate(image, width, height, options);
+	stbi_image_free(image);
+
+	if (!chain.save(argv[2]))
+	{
+		std::cout << "ERROR::MIPCOOKER::WRITE_FAILED " << argv[2] << std::endl;
+		return 1;
+	}
+	std::cout << argv[2] << ": " << width << "x" << height << ", " << chain.levels.size() << " levels" << std::endl;
+	return 0;
+}
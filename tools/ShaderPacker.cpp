@@ -0,0 +1,42 @@
+// Packs every shader source under a directory into one archive (see ShaderArchive)
+// so the runtime maps a single file at startup instead of opening each source.
+//
+// usage: ShaderPacker <shader directory> <output.pack>
+
+#include "ShaderSource.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		std::cout << "usage: ShaderPacker <shader directory> <output.pack>" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> files;
+	std::error_code ec;
+	for (const auto &entry : std::filesystem::recursive_directory_iterator(argv[1], ec))
+	{
+		std::string ext = entry.path().extension().string();
+		if (entry.is_regular_file() && (ext == ".vs" || ext == ".fs" || ext == ".glsl"))
+			files.push_back(entry.path().string());
+	}
+	if (ec || files.empty())
+	{
+		std::cout << "ERROR::SHADERPACKER::NO_SOURCES " << argv[1] << std::endl;
+		return 1;
+	}
+
+	if (!ShaderArchive::write(argv[2], argv[1], files))
+	{
+		std::cout << "ERROR::SHADERPACKER::WRITE_FAILED " << argv[2] << std::endl;
+		return 1;
+	}
+	std::cout << argv[2] << ": " << files.size() << " sources" << std::endl;
+	return 0;
+}
@@ -0,0 +1,158 @@
+// Headless software renderer: draws the lessons' cube scene from LessonScene.h, the
+// same one the demo draws (lessonshader's MVP variant, container.jpg mixed with
+// awesomeface.png), through SoftwareRasterizer, no GPU or window needed. Writes the frame as PNG, can compare it against a golden image
+// and reports throughput in Mpixels/s.
+//
+// usage: SoftRender [--out <frame.png>] [--golden <ref.png>] [--frames <n>] [--cubes <n>] [--threads <n>] [--size <w>x<h>]
+//
+// Run from the directory holding assets/. Exits with 1 when the golden image differs
+// or the frame can't be rendered. assets/golden/ holds the reference frames CTest
+// compares against.
+
+#include "Camera.h"
+#include "JobSystem.h"
+#include "LessonScene.h"
+#include "PngWriter.h"
+#include "SoftwareRasterizer.h"
+#include "stb_image/stb_image.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+static bool loadTexture(const char *path, SoftwareTexture &texture)
+{
+	int width, height, channels;
+	unsigned char *pixels = stbi_load(path, &width, &height, &channels, 0);
+	if (!pixels)
+	{
+		std::cout << "Failed to load texture image " << path << std::endl;
+		std::cout << stbi_failure_reason() << std::endl;
+		return false;
+	}
+	texture = SoftwareTexture(pixels, width, height, channels);
+	stbi_image_free(pixels);
+	return true;
+}
+
+// Pixels differing by more than Tolerance in any channel count as wrong, filtering
+// and rounding differences between machines stay below it
+static bool compareGolden(const char *path, const std::vector<uint8_t> &rgb, int width, int height)
+{
+	const int Tolerance = 8;
+	const double MaxWrongFraction = 0.001;
+
+	stbi_set_flip_vertically_on_load(false);
+	int w, h, channels;
+	unsigned char *golden = stbi_load(path, &w, &h, &channels, 3);
+	if (!golden)
+	{
+		std::cout << "ERROR::SOFTRENDER::GOLDEN_LOAD_FAILED " << path << std::endl;
+		return false;
+	}
+	if (w != width || h != height)
+	{
+		std::cout << "ERROR::SOFTRENDER::GOLDEN_SIZE_MISMATCH " << w << "x" << h << " vs " << width << "x" << height << std::endl;
+		stbi_image_free(golden);
+		return false;
+	}
+	size_t wrong = 0;
+	int maxDifference = 0;
+	for (size_t p = 0; p < (size_t)width * height; p++)
+	{
+		int difference = 0;
+		for (int c = 0; c < 3; c++)
+			difference = std::max(difference, std::abs((int)rgb[p * 3 + c] - (int)golden[p * 3 + c]));
+		maxDifference = std::max(maxDifference, difference);
+		if (difference > Tolerance)
+			wrong++;
+	}
+	stbi_image_free(golden);
+	double fraction = (double)wrong / ((size_t)width * height);
+	bool pass = fraction <= MaxWrongFraction;
+	std::cout << "golden " << path << ": " << (pass ? "match" : "MISMATCH") << ", " << wrong << " pixels off by more than " << Tolerance
+			  << " (" << fraction * 100.0 << "%), max difference " << maxDifference << std::endl;
+	return pass;
+}
+
+int main(int argc, char **argv)
+{
+	const char *outPath = NULL;
+	const char *goldenPath = NULL;
+	int frames = 1, cubes = 10, width = 800, height = 600;
+	unsigned threads = 0;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (strcmp(argv[i], "--out") == 0)
+			outPath = argv[i + 1];
+		else if (strcmp(argv[i], "--golden") == 0)
+			goldenPath = argv[i + 1];
+		else if (strcmp(argv[i], "--frames") == 0)
+			frames = std::max(1, atoi(argv[i + 1]));
+		else if (strcmp(argv[i], "--cubes") == 0)
+			cubes = std::max(1, atoi(argv[i + 1]));
+		else if (strcmp(argv[i], "--threads") == 0)
+			threads = (unsigned)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "--size") == 0)
+			sscanf(argv[i + 1], "%dx%d", &width, &height);
+	}
+
+	if (width <= 0 || height <= 0 || width > SoftwareRasterizer::MaxSize || height > SoftwareRasterizer::MaxSize)
+	{
+		std::cout << "ERROR::SOFTRENDER::BAD_SIZE " << width << "x" << height << ", at most " << SoftwareRasterizer::MaxSize << " on a side" << std::endl;
+		return 1;
+	}
+
+	// same orientation as the GL loader
+	stbi_set_flip_vertically_on_load(true);
+	SoftwareTexture container, face;
+	if (!loadTexture("assets/container.jpg", container) || !loadTexture("assets/awesomeface.png", face))
+		return 1;
+
+	// the first 10 cubes are the lesson's, more go in a grid behind them
+	std::vector<glm::mat4> models;
+	for (int i = 0; i < cubes; i++)
+	{
+		glm::vec3 position = i < LessonScene::CubeCount ? LessonScene::CubePositions[i] : glm::vec3((float)(i % 20) * 1.5f - 14.0f, (float)(i / 20 % 20) * 1.5f - 14.0f, -20.0f - (float)(i / 400) * 1.5f);
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+		models.push_back(glm::rotate(model, glm::radians(LessonScene::cubeAngle(i)), LessonScene::RotationAxis));
+	}
+
+	Camera camera(LessonScene::CameraStart);
+	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)width / (float)height, 0.1f, 100.0f);
+
+	JobSystem jobs(threads);
+	SoftwareRasterizer rasterizer(jobs);
+	SoftwareFramebuffer framebuffer(width, height);
+	const SoftwareVertex *vertices = (const SoftwareVertex *)LessonScene::CubeVertices;
+
+	auto start = std::chrono::steady_clock::now();
+	for (int f = 0; f < frames; f++)
+	{
+		framebuffer.clear(LessonScene::ClearColor);
+		rasterizer.setViewProjection(camera.GetViewMatrix(), projection);
+		rasterizer.setTextures(&container, &face);
+		for (const glm::mat4 &model : models)
+			rasterizer.draw(vertices, LessonScene::CubeVertexCount, model);
+		if (!rasterizer.flush(framebuffer))
+			return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << width << "x" << height << ", " << cubes << " cubes, " << frames << " frames on " << jobs.threadCount() << " threads (" << rasterizer.simdPath() << ")" << std::endl;
+	std::cout << "  " << seconds * 1000.0 / frames << " ms/frame, " << (double)width * height * frames / seconds / 1e6 << " Mpixels/s, "
+			  << rasterizer.shadedFragments() / seconds / 1e6 << " M shaded fragments/s" << std::endl;
+
+	std::vector<uint8_t> rgb = framebuffer.rgb();
+	if (outPath && !PngWriter::write(outPath, width, height, 3, rgb.data()))
+		return 1;
+	if (goldenPath && !compareGolden(goldenPath, rgb, width, height))
+		return 1;
+	return 0;
+}
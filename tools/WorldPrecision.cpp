@@ -0,0 +1,81 @@
+// Large world precision check, run by CTest. At 1e6 units from the origin: view space
+// error of cube corners drawn the old way (float world positions, float view matrix)
+// and camera-relative (double WorldPositions, GetRelativeViewMatrix), both against a
+// double reference, and how far the camera really moves in 10 s of 144 Hz keyboard
+// movement with a float and with the double Camera::Position.
+//
+// usage: WorldPrecision [distance]
+//
+// Exits with 1 if the camera-relative path is not accurate to 1e-4 units or the double
+// camera drifts from the distance it should have walked.
+
+#include "Camera.h"
+#include "WorldPositions.h"
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv)
+{
+	const double Far = argc > 1 ? atof(argv[1]) : 1e6;
+	bool failed = false;
+
+	// cubes within 50 units of a camera Far units out
+	Camera camera(glm::dvec3(Far, 1.7, Far), glm::vec3(0.0f, 1.0f, 0.0f), -60.0f, -5.0f);
+	std::mt19937 rng(9);
+	std::uniform_real_distribution<double> offset(-50.0, 50.0);
+	const size_t Cubes = 1000;
+	WorldPositions world;
+	for (size_t i = 0; i < Cubes; i++)
+		world.add(camera.Position + glm::dvec3(offset(rng), offset(rng), offset(rng)));
+
+	glm::dmat4 referenceView = glm::lookAt(camera.Position, camera.Position + glm::dvec3(camera.Front), glm::dvec3(camera.Up));
+	glm::mat4 floatView = glm::lookAt(glm::vec3(camera.Position), glm::vec3(camera.Position) + camera.Front, camera.Up);
+	glm::mat4 relativeView = camera.GetRelativeViewMatrix();
+	std::vector<glm::mat4> models(Cubes, glm::mat4(1.0f));
+	world.toCameraRelative(camera.Position, models.data());
+
+	double floatError = 0.0, relativeError = 0.0;
+	for (size_t i = 0; i < Cubes; i++)
+		for (int corner = 0; corner < 8; corner++)
+		{
+			glm::dvec3 local((corner & 1) - 0.5, (corner >> 1 & 1) - 0.5, (corner >> 2) - 0.5);
+			glm::dvec3 reference(referenceView * glm::dvec4(world.get(i) + local, 1.0));
+			glm::mat4 floatModel = glm::translate(glm::mat4(1.0f), glm::vec3(world.get(i)));
+			glm::vec3 old(floatView * floatModel * glm::vec4(glm::vec3(local), 1.0f));
+			glm::vec3 relative(relativeView * models[i] * glm::vec4(glm::vec3(local), 1.0f));
+			floatError = std::max(floatError, glm::length(glm::dvec3(old) - reference));
+			relativeError = std::max(relativeError, glm::length(glm::dvec3(relative) - reference));
+		}
+	std::cout << "view space error at " << Far << " units, " << Cubes << " cubes within 50 units of the camera:" << std::endl;
+	std::cout << "  float world positions:  " << floatError << " units" << std::endl;
+	std::cout << "  camera relative:        " << relativeError << " units" << std::endl;
+	failed |= !(relativeError < 1e-4);
+
+	// 10 s of walking forward at 144 Hz
+	const float dt = 1.0f / 144.0f;
+	glm::vec3 floatPosition = glm::vec3(camera.Position);
+	glm::dvec3 start = camera.Position;
+	for (int step = 0; step < 1440; step++)
+	{
+		floatPosition += camera.Front * (camera.MoveSpeed * dt);
+		camera.ProcessKeyboard(FORWARD, dt);
+	}
+	double expected = (double)camera.MoveSpeed * dt * 1440;
+	double doubleMoved = glm::length(camera.Position - start), floatMoved = glm::length(glm::dvec3(floatPosition) - start);
+	std::cout << "walking " << expected << " units in 1440 steps of " << dt << " s:" << std::endl;
+	std::cout << "  float position moved:   " << floatMoved << " units" << std::endl;
+	std::cout << "  double position moved:  " << doubleMoved << " units" << std::endl;
+	failed |= !(std::abs(doubleMoved - expected) < 1e-6 * expected);
+
+	if (failed)
+		std::cout << "ERROR::WORLDPRECISION::MISMATCH" << std::endl;
+	return failed ? 1 : 0;
+}